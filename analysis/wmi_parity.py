@@ -0,0 +1,369 @@
+#!/usr/bin/env python3
+"""
+wmi_parity: compare firmware round trips per user action, Windows vs Linux
+
+Windows side: the WMI-Activity ExecMethod events in traces/wmi_events.csv.
+Calls closer together than --gap-ms form one burst. Each Set method in a
+burst is a user action of the kind ACTIONS maps it to; the service often
+changes the fans and the profile in one burst, so a burst is split where the
+action of its Set methods changes. Other calls go with the next Set method
+(reads before a write), or with the last one when none follows. Bursts
+without a Set method are the service's background polling and are only
+counted.
+
+Linux side: the driver's debugfs wmi_stats counters, either captured live
+(--capture, root) or from files saved with
+    echo > wmi_stats; <do the action>; cat wmi_stats > profile.txt
+and passed as --linux profile=profile.txt. wmi_stats has counts, not order,
+so the Linux column lists methods with their call counts. Anything else
+calling the firmware meanwhile (hwmon readers, temperature alerts) adds to
+the counts, so capture on an idle system.
+
+With neither, the host build of the driver makes the same changes against
+its firmware model ("nekro_host --parity", built with make if needed), so
+the comparison runs anywhere, without the laptop.
+
+An action is flagged when Linux makes more calls than the cheapest Windows
+occurrence of it. The exit code is 1 if anything is flagged, and 2 if no
+action had data on both sides to compare.
+"""
+
+from __future__ import annotations
+
+import argparse
+import os
+import re
+import statistics
+import subprocess
+import sys
+from collections import Counter
+from typing import Dict, List, Optional, Tuple
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+TRACE_CSV = os.path.join(HERE, "traces", "wmi_events.csv")
+ROOT = os.path.dirname(HERE)
+HOST_BIN = os.path.join("tests", "host", "build", "nekro_host")
+
+SYSFS_BASE = "/sys/module/nekro_sense/drivers/platform:acer-wmi/acer-wmi"
+WMI_STATS = "/sys/kernel/debug/nekro_sense/wmi_stats"
+PLATFORM_PROFILE = "/sys/firmware/acpi/platform_profile"
+PLATFORM_PROFILE_CHOICES = "/sys/firmware/acpi/platform_profile_choices"
+
+# AcerGamingFunction (WMID_GUID4) method ids, as named in the Windows MOF.
+# 0x0c/0x0d are the logo set/get the driver uses; the captures never name them.
+GUID4_METHODS = {
+    1: "SetGamingProfile",
+    2: "SetGamingLED",
+    3: "GetGamingProfile",
+    4: "GetGamingLED",
+    5: "GetGamingSysInfo",
+    6: "SetGamingRGBKB",
+    7: "GetGamingRGBKB",
+    12: "SetGamingLogo(0x0c)",
+    13: "GetGamingLogo(0x0d)",
+    14: "SetGamingFanBehavior",
+    16: "SetGamingFanSpeed",
+    20: "SetGamingKBBacklight",
+    21: "GetGamingKBBacklight",
+    22: "SetGamingMiscSetting",
+    23: "GetGamingMiscSetting",
+}
+
+# Action -> the Set methods that mark it, in report order
+ACTIONS = [
+    ("profile", {"SetGamingMiscSetting", "SetGamingProfile"}),
+    ("fan", {"SetGamingFanBehavior", "SetGamingFanSpeed"}),
+    ("keyboard", {"SetGamingKBBacklight", "SetGamingRGBKB", "SetGamingLED"}),
+    ("logo", {"SetGamingLogo(0x0c)"}),
+]
+SETTER_ACTION = {m: action for action, setters in ACTIONS for m in setters}
+
+EXEC_RE = re.compile(r'ExecMethod - ROOT\\WMI : (\w+)\..*?::(\w+)"')
+
+
+def method_name(guid: int, method: str) -> str:
+    if guid == 4 and method != "other" and int(method, 16) in GUID4_METHODS:
+        return GUID4_METHODS[int(method, 16)]
+    return f"guid{guid}:{method}"
+
+
+# ---------------------------------------------------------------- Windows side
+
+def windows_calls(path: str) -> List[Tuple[float, str]]:
+    """Return (time_ms, method) for every WMI ExecMethod start in the trace."""
+    calls = []
+    with open(path, "r", encoding="utf-8", errors="ignore") as f:
+        for line in f:
+            if "ExecMethod - ROOT\\WMI" not in line:
+                continue
+            fields = line.split(",", 17)
+            if fields[0].strip() != "Microsoft-Windows-WMI-Activity":
+                continue
+            m = EXEC_RE.search(line)
+            if not m:
+                continue
+            # Clock-Time is a FILETIME, in 100 ns units
+            calls.append((int(fields[16]) / 10000.0, m.group(2)))
+    calls.sort()
+    return calls
+
+
+def bursts(calls: List[Tuple[float, str]], gap_ms: float) -> List[List[str]]:
+    out: List[List[str]] = []
+    last = None
+    for t, method in calls:
+        if last is None or t - last > gap_ms:
+            out.append([])
+        out[-1].append(method)
+        last = t
+    return out
+
+
+def split_actions(burst: List[str]) -> List[Tuple[str, List[str]]]:
+    """Split a burst into (action, calls) parts, one per run of Set methods of one action."""
+    parts: List[Tuple[str, List[str]]] = []
+    pending: List[str] = []
+    for method in burst:
+        pending.append(method)
+        action = SETTER_ACTION.get(method)
+        if action is None:
+            continue
+        if parts and parts[-1][0] == action:
+            parts[-1][1].extend(pending)
+        else:
+            parts.append((action, pending))
+        pending = []
+    if parts:
+        parts[-1][1].extend(pending)
+    return parts
+
+
+def windows_actions(path: str, gap_ms: float) -> Tuple[Dict[str, List[List[str]]], int]:
+    """Return {action: [calls, ...]} and the number of polling bursts."""
+    actions: Dict[str, List[List[str]]] = {}
+    polls = 0
+    for b in bursts(windows_calls(path), gap_ms):
+        parts = split_actions(b)
+        for action, calls in parts:
+            actions.setdefault(action, []).append(calls)
+        if not parts:
+            polls += 1
+    return actions, polls
+
+
+# ------------------------------------------------------------------ Linux side
+
+def parse_wmi_stats(text: str) -> Counter:
+    """Parse wmi_stats output into {method name: calls}."""
+    counts: Counter = Counter()
+    for line in text.splitlines():
+        if not line or line.startswith("#"):
+            continue
+        guid, method, calls = line.split()[:3]
+        counts[method_name(int(guid), method)] += int(calls)
+    return counts
+
+
+def _read(path: str) -> str:
+    with open(path, "r", encoding="utf-8") as f:
+        return f.read().strip()
+
+
+def _write(path: str, value: str) -> None:
+    with open(path, "w", encoding="utf-8") as f:
+        f.write(value + "\n")
+
+
+def _sense_dir() -> Optional[str]:
+    for sub in ("predator_sense", "nitro_sense"):
+        p = os.path.join(SYSFS_BASE, sub)
+        if os.path.isdir(p):
+            return p
+    return None
+
+
+def _flip_hex(color: str) -> str:
+    return f"{int(color, 16) ^ 1:06x}"
+
+
+def _profile_change(cur: str) -> Optional[str]:
+    choices = _read(PLATFORM_PROFILE_CHOICES).split()
+    others = [c for c in choices if c != cur and c != "custom"]
+    return others[0] if others else None
+
+
+def _fan_change(cur: str) -> str:
+    cpu, gpu = (int(v) for v in cur.split(","))
+    return f"{50 if cpu != 50 else 60},{gpu}"
+
+
+def _zones_change(cur: str) -> str:
+    fields = cur.split(",")
+    fields[0] = _flip_hex(fields[0])
+    return ",".join(fields)
+
+
+def _effect_change(cur: str) -> str:
+    fields = cur.split(",")
+    fields[2] = str(50 if fields[2] != "50" else 60)
+    return ",".join(fields)
+
+
+def _logo_change(cur: str) -> str:
+    fields = cur.split(",")
+    fields[0] = _flip_hex(fields[0])
+    return ",".join(fields)
+
+
+def _kb_per_zone() -> bool:
+    state = os.path.join(SYSFS_BASE, "state")
+    if not os.path.exists(state):
+        return True
+    return "kb_per_zone=1" in _read(state).splitlines()
+
+
+def capture_actions() -> Dict[str, Counter]:
+    """
+    Make one real change per action on the live driver and count its WMI
+    calls. The old value is written back afterwards, outside the count.
+    """
+    sense = _sense_dir()
+    # Change the keyboard in its current mode, so the restore leaves it as it was
+    if _kb_per_zone():
+        kb = (os.path.join(SYSFS_BASE, "four_zoned_kb/per_zone_mode"), _zones_change)
+    else:
+        kb = (os.path.join(SYSFS_BASE, "four_zoned_kb/four_zone_mode"), _effect_change)
+    targets = [
+        ("profile", PLATFORM_PROFILE, _profile_change),
+        ("fan", os.path.join(sense, "fan_speed") if sense else "", _fan_change),
+        ("keyboard", *kb),
+        ("logo", os.path.join(SYSFS_BASE, "back_logo/color"), _logo_change),
+    ]
+    counts: Dict[str, Counter] = {}
+    for action, path, change in targets:
+        if not path or not os.path.exists(path):
+            continue
+        before = _read(path)
+        after = change(before)
+        if after is None:
+            continue
+        _write(WMI_STATS, "")
+        _write(path, after)
+        counts[action] = parse_wmi_stats(_read(WMI_STATS))
+        _write(path, before)
+    return counts
+
+
+def parse_parity(text: str) -> Dict[str, Counter]:
+    """Split "nekro_host --parity" output into {action: wmi_stats counts}."""
+    sections: Dict[str, List[str]] = {}
+    lines: Optional[List[str]] = None
+    for line in text.splitlines():
+        m = re.match(r"# action (\w+)$", line)
+        if m:
+            lines = sections.setdefault(m.group(1), [])
+        elif line.startswith("# action "):
+            lines = None  # the action failed, leave it out
+        elif lines is not None:
+            lines.append(line)
+    return {action: parse_wmi_stats("\n".join(lines)) for action, lines in sections.items()}
+
+
+def host_actions(binary: Optional[str]) -> Dict[str, Counter]:
+    """Run the host build's parity mode, building it first unless a binary is given."""
+    if binary is None:
+        subprocess.run(["make", "-s", "-C", ROOT, HOST_BIN], check=True, stdout=sys.stderr)
+        binary = os.path.join(ROOT, HOST_BIN)
+    out = subprocess.run([binary, "--parity"], check=False, capture_output=True, text=True)
+    if out.returncode:
+        sys.stderr.write(out.stdout)
+    return parse_parity(out.stdout)
+
+
+# ---------------------------------------------------------------------- report
+
+def _seq(burst: List[str]) -> str:
+    return " ".join(burst)
+
+
+def report(win: Dict[str, List[List[str]]], polls: int, linux: Dict[str, Counter],
+           source: str) -> int:
+    flagged = compared = 0
+    print(f"Windows: {sum(len(v) for v in win.values())} actions, {polls} polling bursts")
+    print(f"Linux: {source}")
+    print()
+    print(f"{'action':<10} {'n':>3} {'win min':>7} {'win med':>7} {'linux':>5}  verdict")
+    for action, _ in ACTIONS:
+        occ = win.get(action, [])
+        lin = linux.get(action)
+        lin_calls = sum(lin.values()) if lin is not None else None
+        win_min = min((len(b) for b in occ), default=None)
+        win_med = statistics.median(len(b) for b in occ) if occ else None
+
+        if lin_calls is None:
+            verdict = "no linux data"
+        elif win_min is None:
+            verdict = "no windows trace"
+        elif lin_calls > win_min:
+            verdict = f"MORE (+{lin_calls - win_min})"
+            flagged += 1
+        else:
+            verdict = "ok"
+        compared += lin_calls is not None and win_min is not None
+
+        print(f"{action:<10} {len(occ):>3} {win_min if win_min is not None else '-':>7} "
+              f"{win_med if win_med is not None else '-':>7} "
+              f"{lin_calls if lin_calls is not None else '-':>5}  {verdict}")
+        if occ:
+            print(f"  windows: {_seq(min(occ, key=len))}")
+        if lin:
+            print("  linux:   " + ", ".join(f"{m} x{n}" for m, n in sorted(lin.items())))
+    if not compared:
+        sys.stderr.write("No action had both Windows and Linux data, nothing was compared.\n")
+        return 2
+    return 1 if flagged else 0
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    p = argparse.ArgumentParser(
+        description="Compare WMI round trips per action between the Windows service and the driver",
+    )
+    p.add_argument("--trace", default=TRACE_CSV, help="Windows trace CSV (default traces/wmi_events.csv)")
+    p.add_argument("--gap-ms", type=float, default=500.0,
+                   help="Max gap between calls of one action (default 500)")
+    p.add_argument("--linux", action="append", default=[], metavar="ACTION=FILE",
+                   help="Saved wmi_stats output for one action (profile, fan, keyboard, logo)")
+    p.add_argument("--capture", action="store_true",
+                   help="Measure each action on the live driver (root, debugfs)")
+    p.add_argument("--host", metavar="BINARY",
+                   help="nekro_host to run when neither --linux nor --capture is given "
+                        "(default: build tests/host/build/nekro_host)")
+    args = p.parse_args(argv)
+
+    win, polls = windows_actions(args.trace, args.gap_ms)
+
+    linux: Dict[str, Counter] = {}
+    for spec in args.linux:
+        action, sep, path = spec.partition("=")
+        if not sep or action not in dict(ACTIONS):
+            p.error(f"bad --linux {spec!r}, expected ACTION=FILE")
+        linux[action] = parse_wmi_stats(_read(path))
+    if args.capture:
+        if not os.path.exists(WMI_STATS):
+            sys.stderr.write(f"Missing {WMI_STATS}. Load the module and mount debugfs, as root.\n")
+            return 2
+        linux.update(capture_actions())
+    source = "live driver" if args.capture else "saved wmi_stats"
+    if not args.linux and not args.capture:
+        try:
+            linux = host_actions(args.host)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.stderr.write(f"Cannot run the host build: {e}\n")
+            return 2
+        source = "host build against the firmware model"
+
+    return report(win, polls, linux, source)
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
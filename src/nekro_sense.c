@@ -19,6 +19,16 @@
  #include <linux/dmi.h>
  #include <linux/backlight.h>
  #include <linux/leds.h>
+ #include <linux/led-class-multicolor.h>
+ #include <linux/mutex.h>
+ #include <linux/spinlock.h>
+ #include <linux/miscdevice.h>
+ #include <linux/uaccess.h>
+ #include <linux/ktime.h>
+ #include <linux/math64.h>
+ #include <linux/sort.h>
+ #include <linux/ctype.h>
+#include <linux/power_supply.h>
  #include <linux/platform_device.h>
  #include <linux/platform_profile.h>
  #include <linux/acpi.h>
@@ -26,16 +36,21 @@
  #include <linux/rfkill.h>
  #include <linux/workqueue.h>
  #include <linux/debugfs.h>
+ #include <linux/seq_file.h>
  #include <linux/slab.h>
  #include <linux/input.h>
  #include <linux/input/sparse-keymap.h>
  #include <acpi/video.h>
+ #include <acpi/battery.h>
  #include <linux/hwmon.h>
  #include <linux/fs.h>
  #include <linux/units.h>
  #include <linux/unaligned.h>
  #include <linux/bitfield.h>
  #include <linux/bitmap.h>
+ #include <net/genetlink.h>
+
+ #include "nekro_sense.h"
  
  MODULE_AUTHOR("Carlos Corbacho");
  MODULE_DESCRIPTION("Acer Laptop WMI Extras Driver");
@@ -277,6 +292,13 @@ static bool platform_profile_support;
  */
 static int last_non_turbo_profile = INT_MIN;
 
+/*
+ * Serializes every thermal profile write: the platform_profile callback
+ * (which the core already runs under its own lock), the mode key and
+ * scenes. It also guards last_non_turbo_profile.
+ */
+static DEFINE_MUTEX(acer_profile_lock);
+
 /* The most performant supported profile */
 static int acer_predator_v4_max_perf;
 
@@ -291,6 +313,550 @@ enum acer_predator_v4_thermal_profile {
      .type = ACER_WMID_v2,
  };
  
+ /*
+  * WMI call seam
+  *
+  * Every firmware method call goes through acer_wmi_evaluate(), which counts
+  * calls, failures and latency per GUID and method id. debugfs wmi_stats
+  * shows the counters. Resetting them before an operation and reading them
+  * after gives the exact firmware calls that operation cost.
+  *
+  * debugfs wmi_inject adds a delay to, or fails every Nth call of, a GUID
+  * and method id, to see how the driver behaves with a slow or flaky
+  * embedded controller. Failed calls never reach the firmware.
+  *
+  * debugfs wmi_emulate swaps the firmware for a model of it, see below.
+  */
+ enum acer_wmi_guid {
+     ACER_WMI_GUID3,
+     ACER_WMI_GUID4,
+     ACER_WMI_GUID5,
+     ACER_WMI_GUID_MAX,
+ };
+
+ static const char * const acer_wmi_guids[ACER_WMI_GUID_MAX] = {
+     [ACER_WMI_GUID3] = WMID_GUID3,
+     [ACER_WMI_GUID4] = WMID_GUID4,
+     [ACER_WMI_GUID5] = WMID_GUID5,
+ };
+
+ /* Method ids from here on share the last slot */
+ #define ACER_WMI_STATS_METHODS	32
+
+ struct acer_wmi_call_stats {
+     u64 calls;
+     u64 failures;
+     u64 total_us;
+     u64 max_us;
+     u64 task_calls;	/* from acer_wmi_emulate_task */
+ };
+
+ static DEFINE_SPINLOCK(acer_wmi_stats_lock);
+ static struct acer_wmi_call_stats acer_wmi_stats[ACER_WMI_GUID_MAX][ACER_WMI_STATS_METHODS + 1];
+
+ struct acer_wmi_inject {
+     u32 delay_us;
+     u32 fail_every;	/* 0 never fails */
+     u32 calls;
+     u64 injected;
+ };
+
+ static struct acer_wmi_inject acer_wmi_inject[ACER_WMI_GUID_MAX][ACER_WMI_STATS_METHODS + 1];
+
+ /*
+  * Firmware model
+  *
+  * With debugfs wmi_emulate on, acer_wmi_evaluate() answers every call from
+  * the model below and never reaches wmi_evaluate_method(). It implements the
+  * methods the driver uses, with the same payloads and result words as the
+  * PHN16-72 firmware:
+  *
+  *  - the misc settings (GUID4 22/23), seeded from the BALANCED state dump in
+  *    analysis/complete_capture_20251223_220129. The other three dumps only
+  *    differ in the profile index 0x0B.
+  *  - sys-info (GUID4 5): the supported sensors, AC status, and temperatures
+  *    and fan speeds from a first-order thermal model. Heat follows the load
+  *    and the thermal profile, the fans remove it, and each value moves toward
+  *    its target with a configurable time constant.
+  *  - fan behavior and speed (GUID4 14/16), which drive the fan targets.
+  *  - the keyboard backlight, RGB zones, logo and turbo LED (GUID4 2/4, 6/7,
+  *    12/13, 20/21), the gaming profile word (GUID4 1/3) and the ApgeAction
+  *    words (GUID3 1/2). Their reset state is also taken from the dumps where
+  *    the dumps have it.
+  *  - battery health (GUID5 20/21).
+  *
+  * wmi_inject rules still apply, so per-method latency and failures can be
+  * layered on top. wmi_stats counts the calls as usual.
+  */
+ #define ACER_WMI_EMU_FAN_MAX_RPM	5800
+ #define ACER_WMI_EMU_STEP_MS		250
+ #define ACER_WMI_EMU_MAX_GAP_MS		60000
+
+ enum acer_wmi_emu_fan_mode {
+     ACER_WMI_EMU_FAN_AUTO = 1,
+     ACER_WMI_EMU_FAN_MAX,
+     ACER_WMI_EMU_FAN_CUSTOM,
+ };
+
+ struct acer_wmi_emu {
+     u8 misc[256];		/* misc setting values */
+     u8 misc_status[256];	/* status byte returned for each index */
+     u64 gaming_profile;	/* GetGamingProfile word */
+     u64 usb_charging;		/* ApgeAction words */
+     u64 backlight_timeout;
+     u8 kb[15];			/* GetGamingKBBacklight(1) output */
+     u8 lb[15];			/* GetGamingKBBacklight(2) output */
+     u32 zone[4];		/* 0xRRGGBB of zone ids BIT(0)-BIT(3) */
+     u8 logo[5];		/* R, G, B, brightness, enable */
+     bool turbo_led;
+     u64 led_wakes;		/* 16-byte SetGamingLED(1) calls */
+     u8 battery[5];		/* uFunctionStatus, [0] limiter, [1] calibration */
+
+     /* Thermal model, index 0 CPU, 1 GPU */
+     bool on_ac;
+     unsigned int load[2];	/* percent */
+     int ambient_mc;
+     unsigned int tau_ms[2];	/* temperature, fan; 0 jumps to the target */
+     u8 fan_mode[2];		/* enum acer_wmi_emu_fan_mode */
+     u8 fan_level[2];		/* SetGamingFanSpeed level, percent */
+     int temp_mc[2];
+     int rpm[2];
+     ktime_t updated;
+ };
+
+ /* Misc settings that are not 0xFF in the captures, as index, value */
+ static const u8 acer_wmi_emu_misc_seed[][2] = {
+     { 0x01, 0x00 }, { 0x02, 0x02 }, { 0x06, 0x00 }, { 0x08, 0x01 }, { 0x09, 0x07 },
+     { 0x0A, 0x73 }, { 0x0B, ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED }, { 0x0C, 0x00 },
+     { 0x0F, 0x01 },
+ };
+
+ /* Sensors reported by sys-info 0x0000, bit (id - 1) */
+ static const u8 acer_wmi_emu_sensors[] = { 0x01, 0x02, 0x03, 0x06, 0x0A };
+
+ static DEFINE_MUTEX(acer_wmi_emu_lock);
+ static struct acer_wmi_emu acer_wmi_emu;
+ static bool acer_wmi_emulate;
+ /* Calls from this task always go to the model, see nekro_sense_test.c */
+ static struct task_struct *acer_wmi_emulate_task;
+
+ /* Back to the captured state: balanced, AC, idle, fans on auto */
+ static void acer_wmi_emu_reset(void)
+ {
+     struct acer_wmi_emu *emu = &acer_wmi_emu;
+     static const u8 kb_seed[15] = { 0, 0, 25, 0xFF, 0, 0, 0, 0, 3 };
+     static const u8 lb_seed[15] = { 1, 0, 0, 0xFF };
+
+     mutex_lock(&acer_wmi_emu_lock);
+     memset(emu, 0, sizeof(*emu));
+     memset(emu->misc, 0xFF, sizeof(emu->misc));
+     for (int i = 0; i < ARRAY_SIZE(acer_wmi_emu_misc_seed); i++)
+         emu->misc[acer_wmi_emu_misc_seed[i][0]] = acer_wmi_emu_misc_seed[i][1];
+     /* The only indexes the capture tool failed to read */
+     emu->misc_status[0x0D] = 1;
+     emu->misc_status[0x0E] = 1;
+
+     emu->gaming_profile = 0x1000000;
+     emu->usb_charging = 0xA1F00;
+     emu->backlight_timeout = 0x80000;
+     memcpy(emu->kb, kb_seed, sizeof(kb_seed));
+     memcpy(emu->lb, lb_seed, sizeof(lb_seed));
+     for (int i = 0; i < 4; i++)
+         emu->zone[i] = 0xFFFFFF;
+     emu->logo[4] = 1;
+
+     emu->on_ac = true;
+     emu->load[0] = 10;
+     emu->load[1] = 5;
+     emu->ambient_mc = 25000;
+     emu->tau_ms[0] = 5000;
+     emu->tau_ms[1] = 1500;
+     emu->fan_mode[0] = ACER_WMI_EMU_FAN_AUTO;
+     emu->fan_mode[1] = ACER_WMI_EMU_FAN_AUTO;
+     emu->temp_mc[0] = emu->temp_mc[1] = emu->ambient_mc;
+     emu->updated = ktime_get();
+     mutex_unlock(&acer_wmi_emu_lock);
+ }
+
+ /* Share of full heat output in each thermal profile, percent */
+ static int acer_wmi_emu_power(const struct acer_wmi_emu *emu)
+ {
+     int power;
+
+     switch (emu->misc[ACER_WMID_MISC_SETTING_PLATFORM_PROFILE]) {
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_ECO:
+         power = 40;
+         break;
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET:
+         power = 55;
+         break;
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE:
+         power = 85;
+         break;
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_TURBO:
+         power = 100;
+         break;
+     default:
+         power = 70;
+         break;
+     }
+     return emu->on_ac ? power : min(power, 55);
+ }
+
+ static int acer_wmi_emu_fan_target(const struct acer_wmi_emu *emu, int i)
+ {
+     switch (emu->fan_mode[i]) {
+     case ACER_WMI_EMU_FAN_MAX:
+         return ACER_WMI_EMU_FAN_MAX_RPM;
+     case ACER_WMI_EMU_FAN_CUSTOM:
+         return ACER_WMI_EMU_FAN_MAX_RPM * min_t(int, emu->fan_level[i], 100) / 100;
+     default:
+         /* Off up to 50 °C, then linear to full speed at 90 °C */
+         return clamp(ACER_WMI_EMU_FAN_MAX_RPM * (emu->temp_mc[i] - 50000) / 40000,
+                      0, ACER_WMI_EMU_FAN_MAX_RPM);
+     }
+ }
+
+ static int acer_wmi_emu_approach(int value, int target, unsigned int tau_ms, unsigned int dt_ms)
+ {
+     if (!tau_ms)
+         return target;
+     return value + (int)div_s64((s64)(target - value) * dt_ms, tau_ms + dt_ms);
+ }
+
+ /* Caller holds acer_wmi_emu_lock */
+ static void acer_wmi_emu_advance(struct acer_wmi_emu *emu)
+ {
+     ktime_t now = ktime_get();
+     s64 gap_ms = min_t(s64, ktime_ms_delta(now, emu->updated), ACER_WMI_EMU_MAX_GAP_MS);
+     int power = acer_wmi_emu_power(emu);
+
+     /* Zero time constants settle in one step, even without a time gap */
+     if (!emu->tau_ms[0] || !emu->tau_ms[1])
+         gap_ms = max_t(s64, gap_ms, 1);
+     while (gap_ms > 0) {
+         unsigned int dt = min_t(s64, gap_ms, ACER_WMI_EMU_STEP_MS);
+
+         for (int i = 0; i < 2; i++) {
+             /* Full load in turbo heats the CPU by 70 °C and the GPU by 60 °C, fans off */
+             int rise = emu->load[i] * power * (i ? 6 : 7);
+             int target = emu->ambient_mc +
+                          rise * (1000 - 500 * emu->rpm[i] / ACER_WMI_EMU_FAN_MAX_RPM) / 1000;
+
+             emu->temp_mc[i] = acer_wmi_emu_approach(emu->temp_mc[i], target, emu->tau_ms[0], dt);
+             emu->rpm[i] = acer_wmi_emu_approach(emu->rpm[i], acer_wmi_emu_fan_target(emu, i),
+                                                 emu->tau_ms[1], dt);
+         }
+         gap_ms -= dt;
+     }
+     emu->updated = now;
+ }
+
+ /* Caller holds acer_wmi_emu_lock */
+ static u64 acer_wmi_emu_sys_info(struct acer_wmi_emu *emu, u64 command)
+ {
+     u64 sensors = 0;
+     u8 sensor;
+
+     switch (command & 0xFF) {
+     case ACER_WMID_CMD_GET_PREDATOR_V4_SUPPORTED_SENSORS:
+         for (int i = 0; i < ARRAY_SIZE(acer_wmi_emu_sensors); i++)
+             sensors |= BIT_ULL(acer_wmi_emu_sensors[i] - 1);
+         return FIELD_PREP(ACER_PREDATOR_V4_SUPPORTED_SENSORS_BIT_MASK, sensors);
+     case ACER_WMID_CMD_GET_PREDATOR_V4_BAT_STATUS:
+         return (u64)emu->on_ac << 8;
+     case ACER_WMID_CMD_GET_PREDATOR_V4_SENSOR_READING:
+         break;
+     default:
+         return 1;
+     }
+
+     acer_wmi_emu_advance(emu);
+     sensor = FIELD_GET(ACER_PREDATOR_V4_SENSOR_INDEX_BIT_MASK, command);
+     switch (sensor) {
+     case ACER_WMID_SENSOR_CPU_TEMPERATURE:
+         return FIELD_PREP(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, emu->temp_mc[0] / 1000);
+     case ACER_WMID_SENSOR_GPU_TEMPERATURE:
+         return FIELD_PREP(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, emu->temp_mc[1] / 1000);
+     case ACER_WMID_SENSOR_EXTERNAL_TEMPERATURE_2:
+         /* The chassis sits a third of the way from ambient to the CPU */
+         return FIELD_PREP(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK,
+                           (2 * emu->ambient_mc + emu->temp_mc[0]) / 3000);
+     case ACER_WMID_SENSOR_CPU_FAN_SPEED:
+         return FIELD_PREP(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, emu->rpm[0]);
+     case ACER_WMID_SENSOR_GPU_FAN_SPEED:
+         return FIELD_PREP(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, emu->rpm[1]);
+     default:
+         return 1;
+     }
+ }
+
+ /* Caller holds acer_wmi_emu_lock. Mask and modes as WMID_gaming_set_fan_mode() builds them */
+ static void acer_wmi_emu_fan_behavior(struct acer_wmi_emu *emu, u64 value)
+ {
+     u16 mask = value & 0xFFFF;
+     u16 modes = value >> 16;
+
+     if (mask & BIT(0))
+         emu->fan_mode[0] = modes & 0x3;
+     if (mask & BIT(3))
+         emu->fan_mode[1] = (modes >> 6) & 0x3;
+ }
+
+ /* Caller holds acer_wmi_emu_lock */
+ static acpi_status acer_wmi_emu_gaming(struct acer_wmi_emu *emu, u32 method_id,
+                                        const u8 *in, size_t len, u8 *out, size_t *out_len)
+ {
+     u64 value = 0, result = 0;
+     u8 index;
+
+     memcpy(&value, in, min(len, sizeof(value)));
+     value = le64_to_cpu(value);
+
+     switch (method_id) {
+     case ACER_WMID_SET_GAMING_PROFILE_METHODID:
+         emu->gaming_profile = value & ~0xFFULL;
+         break;
+     case ACER_WMID_SET_GAMING_LED_METHODID:
+         /* The 16-byte form starts the lighting engine, the u64 form is the turbo LED */
+         if (len == 16)
+             emu->led_wakes++;
+         else
+             emu->turbo_led = value & BIT(16);
+         break;
+     case ACER_WMID_GET_GAMING_PROFILE_METHODID:
+         result = emu->gaming_profile | BIT(24);
+         break;
+     case ACER_WMID_GET_GAMING_LED_METHODID:
+         result = (u64)emu->turbo_led << 8;
+         break;
+     case ACER_WMID_GET_GAMING_SYS_INFO_METHODID:
+         result = acer_wmi_emu_sys_info(emu, value);
+         break;
+     case ACER_WMID_SET_GAMING_RGB_KB_METHODID:
+         for (int i = 0; i < 4; i++) {
+             if (in[0] & BIT(i))
+                 emu->zone[i] = in[1] << 16 | in[2] << 8 | in[3];
+         }
+         break;
+     case ACER_WMID_GET_GAMING_RGB_KB_METHODID:
+         result = 1;
+         for (int i = 0; i < 4; i++) {
+             u32 rgb = emu->zone[i];
+
+             /* Bytes 1-3 are R, G, B */
+             if (value == BIT(i))
+                 result = (u64)(rgb & 0xFF) << 24 | (u64)((rgb >> 8) & 0xFF) << 16 |
+                          (u64)((rgb >> 16) & 0xFF) << 8;
+         }
+         break;
+     case 12:	/* logo set: select, R, G, B, brightness, enable */
+         if (len < 6 || in[0] != 1)
+             return AE_BAD_PARAMETER;
+         memcpy(emu->logo, in + 1, sizeof(emu->logo));
+         emu->lb[0] = emu->logo[4];
+         emu->lb[2] = emu->logo[3];
+         memcpy(emu->lb + 5, emu->logo, 3);
+         return AE_OK;
+     case 13:	/* logo get: status, R, G, B, brightness, enable */
+         out[0] = 0;
+         memcpy(out + 1, emu->logo, sizeof(emu->logo));
+         *out_len = 6;
+         return AE_OK;
+     case ACER_WMID_SET_GAMING_FAN_BEHAVIOR_METHODID:
+         acer_wmi_emu_fan_behavior(emu, value);
+         break;
+     case ACER_WMID_SET_GAMING_FAN_SPEED_METHODID:
+         if ((value & 0xFF) == 1)
+             emu->fan_level[0] = value >> 8;
+         else if ((value & 0xFF) == 4)
+             emu->fan_level[1] = value >> 8;
+         else
+             result = 1;
+         break;
+     case ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID:
+         if (len != 16)
+             return AE_BAD_PARAMETER;
+         /* Byte 9 selects the keyboard (1) or the lightbar (2) */
+         if (in[9] == 2) {
+             emu->lb[0] = in[0];
+             emu->logo[4] = in[0];
+         } else {
+             memcpy(emu->kb, in, 3);
+             memcpy(emu->kb + 4, in + 4, 5);
+         }
+         break;
+     case ACER_WMID_GET_GAMING_KB_BACKLIGHT_METHODID:
+         out[0] = 0;
+         memcpy(out + 1, value == 2 ? emu->lb : emu->kb, 15);
+         *out_len = 16;
+         return AE_OK;
+     case ACER_WMID_SET_GAMING_MISC_SETTING_METHODID:
+         index = FIELD_GET(ACER_GAMING_MISC_SETTING_INDEX_MASK, value);
+         result = emu->misc_status[index];
+         /* The firmware takes only the profiles it lists as supported */
+         if (index == ACER_WMID_MISC_SETTING_PLATFORM_PROFILE &&
+             (FIELD_GET(ACER_GAMING_MISC_SETTING_VALUE_MASK, value) > 7 ||
+              !(emu->misc[ACER_WMID_MISC_SETTING_SUPPORTED_PROFILES] &
+                BIT(FIELD_GET(ACER_GAMING_MISC_SETTING_VALUE_MASK, value)))))
+             result = 1;
+         if (!result) {
+             acer_wmi_emu_advance(emu);
+             emu->misc[index] = FIELD_GET(ACER_GAMING_MISC_SETTING_VALUE_MASK, value);
+         }
+         break;
+     case ACER_WMID_GET_GAMING_MISC_SETTING_METHODID:
+         index = FIELD_GET(ACER_GAMING_MISC_SETTING_INDEX_MASK, value);
+         result = FIELD_PREP(ACER_GAMING_MISC_SETTING_VALUE_MASK, emu->misc[index]) |
+                  emu->misc_status[index];
+         break;
+     default:
+         return AE_BAD_PARAMETER;
+     }
+
+     put_unaligned_le64(result, out);
+     *out_len = sizeof(u64);
+     return AE_OK;
+ }
+
+ /* Caller holds acer_wmi_emu_lock */
+ static acpi_status acer_wmi_emu_call(enum acer_wmi_guid guid, u32 method_id,
+                                      const struct acpi_buffer *in, u8 *out, size_t *out_len)
+ {
+     struct acer_wmi_emu *emu = &acer_wmi_emu;
+     u8 buf[16] = {};
+     u64 value;
+
+     memcpy(buf, in->pointer, min_t(size_t, in->length, sizeof(buf)));
+     value = get_unaligned_le64(buf);
+
+     switch (guid) {
+     case ACER_WMI_GUID3:
+         if (method_id == ACER_WMID_SET_FUNCTION) {
+             /* Low byte 0x04 is USB charging, 0x8402 the backlight timeout */
+             if ((value & 0xFF) == 0x04)
+                 emu->usb_charging = value & ~0xFFULL;
+             else if ((value & 0xFFFF) == 0x8402)
+                 emu->backlight_timeout = value & ~0xFFFFULL;
+             else
+                 return AE_BAD_PARAMETER;
+             value = 0;
+         } else if (method_id == ACER_WMID_GET_FUNCTION) {
+             if (value == 0x4)
+                 value = emu->usb_charging;
+             else if ((value & 0xFFFF) == 0x8401)
+                 value = emu->backlight_timeout;
+             else
+                 return AE_BAD_PARAMETER;
+         } else {
+             return AE_BAD_PARAMETER;
+         }
+         put_unaligned_le64(value, out);
+         *out_len = sizeof(u64);
+         return AE_OK;
+
+     case ACER_WMI_GUID4:
+         return acer_wmi_emu_gaming(emu, method_id, buf, in->length, out, out_len);
+
+     case ACER_WMI_GUID5:
+         if (method_id == ACER_WMID_GET_BATTERY_HEALTH_CONTROL_STATUS_METHODID) {
+             /* uFunctionList, uReturn[2], uFunctionStatus[5] */
+             memset(out, 0, 8);
+             out[0] = HEALTH_MODE | CALIBRATION_MODE;
+             memcpy(out + 3, emu->battery, sizeof(emu->battery));
+             *out_len = 8;
+         } else if (method_id == ACER_WMID_SET_BATTERY_HEALTH_CONTROL_METHODID) {
+             /* uBatteryNo, uFunctionMask, uFunctionStatus */
+             if (buf[1] & HEALTH_MODE)
+                 emu->battery[0] = buf[2];
+             if (buf[1] & CALIBRATION_MODE)
+                 emu->battery[1] = buf[2];
+             memset(out, 0, 4);
+             *out_len = 4;
+         } else {
+             return AE_BAD_PARAMETER;
+         }
+         return AE_OK;
+
+     default:
+         return AE_BAD_PARAMETER;
+     }
+ }
+
+ /* The results come back the way ACPI returns them: one kmalloc'd buffer object */
+ static acpi_status acer_wmi_emu_evaluate(enum acer_wmi_guid guid, u32 method_id,
+                                          const struct acpi_buffer *in, struct acpi_buffer *out)
+ {
+     union acpi_object *obj;
+     acpi_status status;
+     size_t len = 0;
+     u8 data[16];
+
+     mutex_lock(&acer_wmi_emu_lock);
+     status = acer_wmi_emu_call(guid, method_id, in, data, &len);
+     mutex_unlock(&acer_wmi_emu_lock);
+     if (ACPI_FAILURE(status) || !out)
+         return status;
+
+     obj = kzalloc(sizeof(*obj) + len, GFP_KERNEL);
+     if (!obj)
+         return AE_NO_MEMORY;
+     obj->type = ACPI_TYPE_BUFFER;
+     obj->buffer.length = len;
+     obj->buffer.pointer = (u8 *)(obj + 1);
+     memcpy(obj->buffer.pointer, data, len);
+     out->length = sizeof(*obj) + len;
+     out->pointer = obj;
+
+     return AE_OK;
+ }
+
+ static acpi_status acer_wmi_evaluate(enum acer_wmi_guid guid, u32 method_id,
+                                      const struct acpi_buffer *in, struct acpi_buffer *out)
+ {
+     u32 slot = min_t(u32, method_id, ACER_WMI_STATS_METHODS);
+     struct acer_wmi_inject *inj = &acer_wmi_inject[guid][slot];
+     struct acer_wmi_call_stats *st;
+     bool task = READ_ONCE(acer_wmi_emulate_task) == current;
+     bool fail = false;
+     acpi_status status;
+     u32 delay_us;
+     ktime_t start;
+     u64 us;
+
+     spin_lock(&acer_wmi_stats_lock);
+     delay_us = inj->delay_us;
+     if (inj->fail_every && ++inj->calls >= inj->fail_every) {
+         inj->calls = 0;
+         inj->injected++;
+         fail = true;
+     }
+     spin_unlock(&acer_wmi_stats_lock);
+
+     start = ktime_get();
+     if (delay_us)
+         usleep_range(delay_us, delay_us + delay_us / 8 + 1);
+     if (fail)
+         status = AE_ERROR;
+     else if (task || READ_ONCE(acer_wmi_emulate))
+         status = acer_wmi_emu_evaluate(guid, method_id, in, out);
+     else
+         status = wmi_evaluate_method(acer_wmi_guids[guid], 0, method_id, in, out);
+     us = ktime_us_delta(ktime_get(), start);
+
+     st = &acer_wmi_stats[guid][slot];
+     spin_lock(&acer_wmi_stats_lock);
+     st->calls++;
+     st->task_calls += task;
+     if (ACPI_FAILURE(status))
+         st->failures++;
+     st->total_us += us;
+     st->max_us = max(st->max_us, us);
+     spin_unlock(&acer_wmi_stats_lock);
+
+     return status;
+ }
+
  /*
   * WMID ApgeAction interface
   */
@@ -302,7 +868,7 @@ enum acer_predator_v4_thermal_profile {
      union acpi_object *obj;
      u64 tmp = 0;
      acpi_status status;
-     status = wmi_evaluate_method(WMID_GUID3, 0, method_id, &input, &result);
+     status = acer_wmi_evaluate(ACER_WMI_GUID3, method_id, &input, &result);
  
      if (ACPI_FAILURE(status))
          return status;
@@ -339,7 +905,7 @@ enum acer_predator_v4_thermal_profile {
      u64 tmp = 0;
      acpi_status status;
  
-     status = wmi_evaluate_method(WMID_GUID4, 0, method_id, &input, &result);
+     status = acer_wmi_evaluate(ACER_WMI_GUID4, method_id, &input, &result);
  
      if (ACPI_FAILURE(status))
          return status;
@@ -375,7 +941,7 @@ enum acer_predator_v4_thermal_profile {
      acpi_status status;
      int ret = 0;
  
-     status = wmi_evaluate_method(WMID_GUID4, 0, method_id, &input, &result);
+     status = acer_wmi_evaluate(ACER_WMI_GUID4, method_id, &input, &result);
      if (ACPI_FAILURE(status))
          return -EIO;
  
@@ -467,6 +1033,23 @@ enum acer_predator_v4_thermal_profile {
      return 0;
  }
 
+ static int WMID_gaming_get_sensor_reading(enum acer_wmi_predator_v4_sensor_id sensor, u64 *reading)
+ {
+     u64 command = ACER_WMID_CMD_GET_PREDATOR_V4_SENSOR_READING;
+     u64 result;
+     int ret;
+ 
+     command |= FIELD_PREP(ACER_PREDATOR_V4_SENSOR_INDEX_BIT_MASK, sensor);
+ 
+     ret = WMID_gaming_get_sys_info(command, &result);
+     if (ret < 0)
+         return ret;
+ 
+     *reading = FIELD_GET(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, result);
+ 
+     return 0;
+ }
+
  static void WMID_gaming_set_fan_mode(u8 fan_mode)
  {
      /* fan_mode = 1 is used for auto, fan_mode = 2 used for turbo*/
@@ -488,6 +1071,12 @@ enum acer_predator_v4_thermal_profile {
      WMID_gaming_set_u64(gpu_fan_config2 | gpu_fan_config1 << 16, ACER_CAP_TURBO_FAN);
  }
 
+ /*
+  * Last thermal profile the driver wrote or read back, -1 when unknown. Every
+  * profile change goes through the misc setting helpers below, so they keep it.
+  */
+ static int thermal_profile_cached = -1;
+
  static int WMID_gaming_set_misc_setting(enum acer_wmi_gaming_misc_setting setting, u8 value)
  {
      acpi_status status;
@@ -497,6 +1086,10 @@ enum acer_predator_v4_thermal_profile {
      input |= FIELD_PREP(ACER_GAMING_MISC_SETTING_INDEX_MASK, setting);
      input |= FIELD_PREP(ACER_GAMING_MISC_SETTING_VALUE_MASK, value);
  
+     /* Whatever the outcome, the cached profile can't be trusted until it succeeds */
+     if (setting == ACER_WMID_MISC_SETTING_PLATFORM_PROFILE)
+         WRITE_ONCE(thermal_profile_cached, -1);
+
      status = WMI_gaming_execute_u64(ACER_WMID_SET_GAMING_MISC_SETTING_METHODID, input, &result);
      if (ACPI_FAILURE(status))
          return -EIO;
@@ -504,20 +1097,30 @@ enum acer_predator_v4_thermal_profile {
      /* The return status must be zero for the operation to have succeeded */
      if (FIELD_GET(ACER_GAMING_MISC_SETTING_STATUS_MASK, result))
          return -EIO;
+
+     if (setting == ACER_WMID_MISC_SETTING_PLATFORM_PROFILE)
+         WRITE_ONCE(thermal_profile_cached, value);
  
      return 0;
  }
  
- static int WMID_gaming_get_misc_setting(enum acer_wmi_gaming_misc_setting setting, u8 *value)
+ /* Returns the whole result word, status byte included */
+ static int WMID_gaming_get_misc_setting_raw(u8 setting, u64 *result)
  {
      u64 input = 0;
-     u64 result;
-     int ret;
  
      input |= FIELD_PREP(ACER_GAMING_MISC_SETTING_INDEX_MASK, setting);
  
-     ret = WMI_gaming_execute_u32_u64(ACER_WMID_GET_GAMING_MISC_SETTING_METHODID, input,
-                      &result);
+     return WMI_gaming_execute_u32_u64(ACER_WMID_GET_GAMING_MISC_SETTING_METHODID, input,
+                       result);
+ }
+
+ static int WMID_gaming_get_misc_setting(enum acer_wmi_gaming_misc_setting setting, u8 *value)
+ {
+     u64 result = 0;
+     int ret;
+ 
+     ret = WMID_gaming_get_misc_setting_raw(setting, &result);
      if (ret < 0)
          return ret;
  
@@ -526,6 +1129,8 @@ enum acer_predator_v4_thermal_profile {
          return -EIO;
  
      *value = FIELD_GET(ACER_GAMING_MISC_SETTING_VALUE_MASK, result);
+     if (setting == ACER_WMID_MISC_SETTING_PLATFORM_PROFILE)
+         WRITE_ONCE(thermal_profile_cached, *value);
  
      return 0;
  }
@@ -610,9 +1215,9 @@ enum acer_predator_v4_thermal_profile {
      return 0;
  }
  
+ /* Caller holds acer_profile_lock */
  static int
- acer_predator_v4_platform_profile_set(struct device *dev,
-                       enum platform_profile_option profile)
+ __acer_predator_v4_platform_profile_set(enum platform_profile_option profile)
  {
      int err,tp;
      acpi_status status;
@@ -669,6 +1274,18 @@ enum acer_predator_v4_thermal_profile {
  
      return 0;
  }
+
+ static int
+ acer_predator_v4_platform_profile_set(struct device *dev,
+                       enum platform_profile_option profile)
+ {
+     int err;
+
+     mutex_lock(&acer_profile_lock);
+     err = __acer_predator_v4_platform_profile_set(profile);
+     mutex_unlock(&acer_profile_lock);
+     return err;
+ }
  
  static int
  acer_predator_v4_platform_profile_probe(void *drvdata, unsigned long *choices)
@@ -762,6 +1379,45 @@ enum acer_predator_v4_thermal_profile {
      return PTR_ERR(platform_profile_device);
  }
  
+ /*
+  * Mode key transition table: the profile that follows current_tp, or a
+  * negative value when the key does not cycle out of current_tp or no
+  * non-turbo profile has been recorded yet.
+  */
+ static int acer_thermal_profile_next(u8 current_tp, bool on_ac)
+ {
+     /* On battery, only ECO and BALANCED mode are available */
+     if (!on_ac)
+         return current_tp == ACER_PREDATOR_V4_THERMAL_PROFILE_ECO
+                ? ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED
+                : ACER_PREDATOR_V4_THERMAL_PROFILE_ECO;
+
+     switch (current_tp) {
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_TURBO:
+         return cycle_gaming_thermal_profile
+                ? ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET
+                : last_non_turbo_profile;
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE:
+         return (acer_predator_v4_max_perf == current_tp)
+                ? last_non_turbo_profile
+                : acer_predator_v4_max_perf;
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED:
+         return cycle_gaming_thermal_profile
+                ? ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE
+                : acer_predator_v4_max_perf;
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET:
+         return cycle_gaming_thermal_profile
+                ? ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED
+                : acer_predator_v4_max_perf;
+     case ACER_PREDATOR_V4_THERMAL_PROFILE_ECO:
+         return cycle_gaming_thermal_profile
+                ? ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET
+                : acer_predator_v4_max_perf;
+     default:
+         return -EOPNOTSUPP;
+     }
+ }
+
  static int acer_thermal_profile_change(void)
  {
      /*
@@ -773,69 +1429,45 @@ enum acer_predator_v4_thermal_profile {
          int tp, err;
          u64 on_AC;
          acpi_status status;
+         mutex_lock(&acer_profile_lock);
          err = WMID_gaming_get_misc_setting(ACER_WMID_MISC_SETTING_PLATFORM_PROFILE, &current_tp);
          if (err)
-             return err;
+             goto out_unlock;
          /* Check power source */
          status = WMI_gaming_execute_u64(
              ACER_WMID_GET_GAMING_SYS_INFO_METHODID,
              ACER_WMID_CMD_GET_PREDATOR_V4_BAT_STATUS, &on_AC);
          
-         if (ACPI_FAILURE(status))
-             return -EIO;
+         if (ACPI_FAILURE(status)) {
+             err = -EIO;
+             goto out_unlock;
+         }
          
-         /* On AC - define next profile transitions */
-         if (!on_AC) {
-            if (current_tp == ACER_PREDATOR_V4_THERMAL_PROFILE_ECO)
-                tp = ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED;
-            else
-                tp = ACER_PREDATOR_V4_THERMAL_PROFILE_ECO;
-        } else {
-            switch (current_tp) {
-            case ACER_PREDATOR_V4_THERMAL_PROFILE_TURBO:
-                tp = cycle_gaming_thermal_profile
-                     ? ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET
-                     : last_non_turbo_profile;
-                break;
-            case ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE:
-                tp = (acer_predator_v4_max_perf == current_tp)
-                     ? last_non_turbo_profile
-                     : acer_predator_v4_max_perf;
-                break;
-            case ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED:
-                tp = cycle_gaming_thermal_profile
-                     ? ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE
-                     : acer_predator_v4_max_perf;
-                break;
-            case ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET:
-                tp = cycle_gaming_thermal_profile
-                     ? ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED
-                     : acer_predator_v4_max_perf;
-                break;
-            case ACER_PREDATOR_V4_THERMAL_PROFILE_ECO:
-                tp = cycle_gaming_thermal_profile
-                     ? ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET
-                     : acer_predator_v4_max_perf;
-                break;
-            default:
-                return -EOPNOTSUPP;
-            }
-        }
+         tp = acer_thermal_profile_next(current_tp, on_AC);
+         if (tp < 0) {
+             err = -EOPNOTSUPP;
+             goto out_unlock;
+         }
 
          err = WMID_gaming_set_misc_setting(ACER_WMID_MISC_SETTING_PLATFORM_PROFILE, tp);
          if (err)
-             return err;
+             goto out_unlock;
  
          /* the quiter you become the more you'll be able to hear! */
          if(tp == ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET || tp == ACER_PREDATOR_V4_THERMAL_PROFILE_ECO) {
              acpi_status stat = acer_set_fan_speed(0,0);
              if(ACPI_FAILURE(stat)){
-                 return -EIO;
+                 err = -EIO;
+                 goto out_unlock;
              }
          }
          /* Store non-turbo profile for turbo mode toggle*/
          if (tp != acer_predator_v4_max_perf)
              last_non_turbo_profile = tp;
+ out_unlock:
+         mutex_unlock(&acer_profile_lock);
+         if (err)
+             return err;
  
          platform_profile_notify(platform_profile_device);
      }
@@ -843,6 +1475,29 @@ enum acer_predator_v4_thermal_profile {
      return 0;
  }
  
+ /*
+  * Re-read the profile after the firmware may have switched it on its own, so
+  * the cache stays filled and readers of it never call the firmware.
+  */
+ static void acer_thermal_profile_refresh(void)
+ {
+     u8 value;
+
+     if (!has_cap(ACER_CAP_PLATFORM_PROFILE))
+         return;
+
+     mutex_lock(&acer_profile_lock);
+     if (WMID_gaming_get_misc_setting(ACER_WMID_MISC_SETTING_PLATFORM_PROFILE, &value))
+         WRITE_ONCE(thermal_profile_cached, -1);
+     mutex_unlock(&acer_profile_lock);
+ }
+
+ static void lighting_state_invalidate(void);
+ static void battery_health_invalidate(void);
+ static void acer_state_caches_fill(void);
+ static void lighting_idle_kick(void);
+ static void nekro_genl_event(u8 function, u8 key);
+
  static void acer_wmi_notify(union acpi_object *obj, void *context)
  {
      struct event_return_value return_value;
@@ -859,8 +1514,13 @@ enum acer_predator_v4_thermal_profile {
      }
 
      return_value = *((struct event_return_value *)obj->buffer.pointer);
+     nekro_genl_event(return_value.function, return_value.key_num);
 
      switch (return_value.function) {
+     case WMID_HOTKEY_EVENT:
+         /* Lighting keys change the keyboard and logo behind our back */
+         lighting_state_invalidate();
+         break;
      case WMID_GAMING_TURBO_KEY_EVENT:
          pr_info("pressed turbo button - %d\n", return_value.key_num);
          if (return_value.key_num == 0x4 && !has_cap(ACER_CAP_NITRO_SENSE_V4))
@@ -869,8 +1529,12 @@ enum acer_predator_v4_thermal_profile {
               (return_value.key_num == 0x4 && has_cap(ACER_CAP_NITRO_SENSE_V4))) &&
              has_cap(ACER_CAP_PLATFORM_PROFILE))
              acer_thermal_profile_change();
+         /* The firmware may switch the profile on its own for this key */
+         acer_thermal_profile_refresh();
          break;
      case WMID_AC_EVENT:
+         /* The idle timeout differs on AC and battery, and so do the profiles */
+         lighting_idle_kick();
          if (has_cap(ACER_CAP_PREDATOR_SENSE) || has_cap(ACER_CAP_NITRO_SENSE_V4)) {
              if (return_value.key_num == 0) {
                  acer_predator_state_update(1);
@@ -882,12 +1546,15 @@ enum acer_predator_v4_thermal_profile {
                  pr_info("Unknown key number - %d\n", return_value.key_num);
              }
          }
+         acer_thermal_profile_refresh();
          break;
      case WMID_CALIBRATION_EVENT:
+         battery_health_invalidate();
          if (has_cap(ACER_CAP_PREDATOR_SENSE) || has_cap(ACER_CAP_NITRO_SENSE) || has_cap(ACER_CAP_NITRO_SENSE_V4)) {
              if (battery_health_set(CALIBRATION_MODE, return_value.key_num) != AE_OK)
                  pr_err("Error changing calibration state\n");
          }
+         acer_state_caches_fill();
          break;
      default:
          break;
@@ -898,37 +1565,228 @@ enum acer_predator_v4_thermal_profile {
  
  
  /*
-  * USB Charging
+  * Firmware settings
+  *
+  * Settings that map a small set of values onto fixed WMI words are described
+  * by one table entry each: the interface, the get/set methods, the argument
+  * that reads the setting and, per allowed value, the word written and the
+  * word the getter reports back. Reads come from a cache that only holds
+  * values the table could decode. Every write is checked with one read.
   */
- static ssize_t predator_usb_charging_show(struct device *dev, struct device_attribute *attr,char *buf){
+ enum acer_setting_iface {
+     ACER_SETTING_APGEACTION,	/* WMID_GUID3 */
+     ACER_SETTING_GAMING,	/* WMID_GUID4 */
+ };
+
+ struct acer_setting_value {
+     int value;		/* value shown in sysfs */
+     u64 set_in;	/* setter argument */
+     u64 get_out;	/* getter output */
+ };
+
+ struct acer_setting {
+     const char *name;
+     enum acer_setting_iface iface;
+     u32 get_method;
+     u64 get_in;
+     u32 set_method;
+     const struct acer_setting_value *values;
+     unsigned int num_values;
+     /* protected by acer_settings_lock */
+     bool valid;
+     int cached;
+ };
+
+ enum acer_setting_id {
+     ACER_SETTING_USB_CHARGING,
+     ACER_SETTING_LCD_OVERRIDE,
+     ACER_SETTING_BACKLIGHT_TIMEOUT,
+     ACER_SETTING_BOOT_ANIMATION_SOUND,
+     ACER_SETTING_MAX,
+ };
+
+ static const struct acer_setting_value usb_charging_values[] = {
+     { 0, 663300, 663296 },
+     { 10, 659204, 659200 },
+     { 20, 1314564, 1314560 },
+     { 30, 1969924, 1969920 },
+ };
+
+ static const struct acer_setting_value lcd_override_values[] = {
+     { 0, 0x10, 0x1000000 },
+     { 1, 0x1000000000010, 0x1000001000000 },
+ };
+
+ static const struct acer_setting_value backlight_timeout_values[] = {
+     { 0, 0x88402, 0x80000 },
+     { 1, 0x1E0000088402, 0x1E0000080000 },
+ };
+
+ static const struct acer_setting_value boot_animation_sound_values[] = {
+     { 0, 0x6, 0x0 },
+     { 1, 0x106, 0x100 },
+ };
+
+ static DEFINE_MUTEX(acer_settings_lock);
+ static struct acer_setting acer_settings[ACER_SETTING_MAX] = {
+     [ACER_SETTING_USB_CHARGING] = {
+         .name = "usb_charging",
+         .iface = ACER_SETTING_APGEACTION,
+         .get_method = ACER_WMID_GET_FUNCTION, .get_in = 0x4,
+         .set_method = ACER_WMID_SET_FUNCTION,
+         .values = usb_charging_values, .num_values = ARRAY_SIZE(usb_charging_values),
+     },
+     [ACER_SETTING_LCD_OVERRIDE] = {
+         .name = "lcd_override",
+         .iface = ACER_SETTING_GAMING,
+         .get_method = ACER_WMID_GET_GAMING_PROFILE_METHODID, .get_in = 0x00,
+         .set_method = ACER_WMID_SET_GAMING_PROFILE_METHODID,
+         .values = lcd_override_values, .num_values = ARRAY_SIZE(lcd_override_values),
+     },
+     [ACER_SETTING_BACKLIGHT_TIMEOUT] = {
+         .name = "backlight_timeout",
+         .iface = ACER_SETTING_APGEACTION,
+         .get_method = ACER_WMID_GET_FUNCTION, .get_in = 0x88401,
+         .set_method = ACER_WMID_SET_FUNCTION,
+         .values = backlight_timeout_values, .num_values = ARRAY_SIZE(backlight_timeout_values),
+     },
+     [ACER_SETTING_BOOT_ANIMATION_SOUND] = {
+         .name = "boot_animation_sound",
+         .iface = ACER_SETTING_GAMING,
+         .get_method = ACER_WMID_GET_GAMING_MISC_SETTING_METHODID, .get_in = 0x6,
+         .set_method = ACER_WMID_SET_GAMING_MISC_SETTING_METHODID,
+         .values = boot_animation_sound_values, .num_values = ARRAY_SIZE(boot_animation_sound_values),
+     },
+ };
+
+ static acpi_status acer_setting_execute(const struct acer_setting *setting, u32 method,
+                                         u64 in, u64 *out)
+ {
+     if (setting->iface == ACER_SETTING_APGEACTION)
+         return WMI_apgeaction_execute_u64(method, in, out);
+     return WMI_gaming_execute_u64(method, in, out);
+ }
+
+ /* Caller holds acer_settings_lock */
+ static int acer_setting_fetch(struct acer_setting *setting)
+ {
      acpi_status status;
      u64 result;
-     status = WMI_apgeaction_execute_u64(ACER_WMID_GET_FUNCTION,0x4,&result);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error getting usb charging status: %s\n",acpi_format_exception(status));
+
+     setting->valid = false;
+
+     status = acer_setting_execute(setting, setting->get_method, setting->get_in, &result);
+     if (ACPI_FAILURE(status)) {
+         pr_err("Error getting %s status: %s\n", setting->name, acpi_format_exception(status));
          return -ENODEV;
      }
-     pr_info("usb charging get status: %llu\n",result);
-     return sprintf(buf, "%d\n", result == 663296 ? 0 : result == 659200 ? 10 : result == 1314560 ? 20 : result == 1969920 ? 30 : -1); //-1 means unknown value
- }
- 
- static ssize_t predator_usb_charging_store(struct device *dev, struct device_attribute *attr,const char *buf, size_t count){
-     acpi_status status;
-     u64 result;
-     u8 val;
-       if (sscanf(buf, "%hhd", &val) != 1)
-         return -EINVAL;
-       if ((val != 0) && (val != 10) && (val != 20) && (val != 30))
+
+     for (unsigned int i = 0; i < setting->num_values; i++) {
+         if (setting->values[i].get_out == result) {
+             setting->cached = setting->values[i].value;
+             setting->valid = true;
+             return 0;
+         }
+     }
+
+     pr_warn("Unknown %s status: 0x%llx\n", setting->name, result);
+     return -EIO;
+ }
+
+ /* Returns 0 and the value, -EIO if the firmware reports an unknown word */
+ static int acer_setting_get(enum acer_setting_id id, int *value)
+ {
+     struct acer_setting *setting = &acer_settings[id];
+     int ret = 0;
+
+     mutex_lock(&acer_settings_lock);
+     if (!setting->valid)
+         ret = acer_setting_fetch(setting);
+     if (!ret)
+         *value = setting->cached;
+     mutex_unlock(&acer_settings_lock);
+
+     return ret;
+ }
+
+ static int acer_setting_set(enum acer_setting_id id, int value)
+ {
+     struct acer_setting *setting = &acer_settings[id];
+     const struct acer_setting_value *val = NULL;
+     acpi_status status;
+     int ret;
+
+     for (unsigned int i = 0; i < setting->num_values; i++) {
+         if (setting->values[i].value == value)
+             val = &setting->values[i];
+     }
+     if (!val)
          return -EINVAL;
-     pr_info("usb charging set value: %d\n",val);
-     status = WMI_apgeaction_execute_u64(ACER_WMID_SET_FUNCTION,val == 0 ? 663300 : val == 10 ? 659204 : val == 20 ? 1314564 : val == 30 ? 1969924 : 663300, &result); //if unkown value then turn it off.
-     if(ACPI_FAILURE(status)){
-         pr_err("Error setting usb charging status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
+
+     mutex_lock(&acer_settings_lock);
+     status = acer_setting_execute(setting, setting->set_method, val->set_in, NULL);
+     if (ACPI_FAILURE(status)) {
+         pr_err("Error setting %s status: %s\n", setting->name, acpi_format_exception(status));
+         setting->valid = false;
+         ret = -ENODEV;
+         goto out;
+     }
+
+     /* Read back once, so the cache holds what the firmware actually took */
+     ret = acer_setting_fetch(setting);
+     if (!ret && setting->cached != value) {
+         pr_err("%s set to %d but firmware reports %d\n", setting->name, value, setting->cached);
+         ret = -EIO;
      }
-     pr_info("usb charging set status: %llu\n",result);
+ out:
+     mutex_unlock(&acer_settings_lock);
+     return ret;
+ }
+
+ static void acer_settings_invalidate(void)
+ {
+     mutex_lock(&acer_settings_lock);
+     for (int i = 0; i < ACER_SETTING_MAX; i++)
+         acer_settings[i].valid = false;
+     mutex_unlock(&acer_settings_lock);
+ }
+
+ static ssize_t acer_setting_show(struct device *dev, struct device_attribute *attr, char *buf)
+ {
+     struct dev_ext_attribute *ea = container_of(attr, struct dev_ext_attribute, attr);
+     int value, ret;
+
+     ret = acer_setting_get((uintptr_t)ea->var, &value);
+     /* Unknown firmware words read as -1, as before */
+     if (ret == -EIO)
+         value = -1;
+     else if (ret)
+         return ret;
+
+     return sprintf(buf, "%d\n", value);
+ }
+
+ static ssize_t acer_setting_store(struct device *dev, struct device_attribute *attr,
+                                   const char *buf, size_t count)
+ {
+     struct dev_ext_attribute *ea = container_of(attr, struct dev_ext_attribute, attr);
+     int value, ret;
+
+     if (kstrtoint(buf, 10, &value))
+         return -EINVAL;
+
+     ret = acer_setting_set((uintptr_t)ea->var, value);
+     if (ret)
+         return ret;
+
      return count;
  }
+
+ #define ACER_SETTING_ATTR(_name, _id)						\
+     static struct dev_ext_attribute _name = {					\
+         __ATTR(_name, 0644, acer_setting_show, acer_setting_store),		\
+         (void *)(uintptr_t)(_id)						\
+     }
  
  /*
   * Battery Limit (80%)
@@ -959,8 +1817,28 @@ enum acer_predator_v4_thermal_profile {
  } __packed;
  
  
- static acpi_status battery_health_query(int mode, int *enabled){
-     pr_info("battery health query: %d\n",mode);
+ /*
+  * Both attributes read the same status word, so it is fetched once and kept
+  * until a set, a calibration event, resume, or battery_health_cache.max_age_ms.
+  */
+ struct battery_health_cache {
+     u8 status[5];		/* uFunctionStatus, [0] limiter, [1] calibration */
+     bool valid;
+     unsigned long updated;	/* jiffies */
+     unsigned int max_age_ms;
+ };
+
+ static DEFINE_MUTEX(battery_health_lock);
+ static struct battery_health_cache battery_health_cache = {
+     .max_age_ms = 30000,
+ };
+
+ static void battery_health_invalidate(void)
+ {
+     WRITE_ONCE(battery_health_cache.valid, false);
+ }
+
+ static acpi_status battery_health_fetch(u8 *function_status){
      acpi_status status;
      union acpi_object *obj;
      struct get_battery_health_control_status_input params = {
@@ -976,7 +1854,7 @@ enum acer_predator_v4_thermal_profile {
  
      struct acpi_buffer output = { ACPI_ALLOCATE_BUFFER, NULL };
  
-     status = wmi_evaluate_method(WMID_GUID5, 0, ACER_WMID_GET_BATTERY_HEALTH_CONTROL_STATUS_METHODID, &input, &output);
+     status = acer_wmi_evaluate(ACER_WMI_GUID5, ACER_WMID_GET_BATTERY_HEALTH_CONTROL_STATUS_METHODID, &input, &output);
      if (ACPI_FAILURE(status))
          return status;
      
@@ -990,14 +1868,7 @@ enum acer_predator_v4_thermal_profile {
        }
      
        ret = *((struct get_battery_health_control_status_output *)obj->buffer.pointer);
-     
-     if(mode == HEALTH_MODE){
-         *enabled = ret.uFunctionStatus[0];
-     } else if(mode == CALIBRATION_MODE){
-         *enabled = ret.uFunctionStatus[1];
-     } else {
-         goto failed;
-     }
+       memcpy(function_status, ret.uFunctionStatus, sizeof(ret.uFunctionStatus));
  
      kfree(obj);
      return AE_OK;
@@ -1006,6 +1877,37 @@ enum acer_predator_v4_thermal_profile {
            kfree(obj);
            return AE_ERROR;
  }
+
+ /* Caller holds battery_health_lock */
+ static acpi_status battery_health_cache_fill(void)
+ {
+     struct battery_health_cache *cache = &battery_health_cache;
+     acpi_status status = AE_OK;
+
+     if (!cache->valid || !cache->max_age_ms ||
+         time_after(jiffies, cache->updated + msecs_to_jiffies(cache->max_age_ms))) {
+         status = battery_health_fetch(cache->status);
+         cache->valid = ACPI_SUCCESS(status);
+         cache->updated = jiffies;
+     }
+     return status;
+ }
+
+ static acpi_status battery_health_query(int mode, int *enabled){
+     struct battery_health_cache *cache = &battery_health_cache;
+     acpi_status status;
+
+     if (mode != HEALTH_MODE && mode != CALIBRATION_MODE)
+         return AE_BAD_PARAMETER;
+
+     mutex_lock(&battery_health_lock);
+     status = battery_health_cache_fill();
+     if (ACPI_SUCCESS(status))
+         *enabled = cache->status[mode == HEALTH_MODE ? 0 : 1];
+     mutex_unlock(&battery_health_lock);
+
+     return status;
+ }
  
  static acpi_status battery_health_set(u8 function, u8 function_status){
  
@@ -1027,7 +1929,14 @@ enum acer_predator_v4_thermal_profile {
  
      struct acpi_buffer output = { ACPI_ALLOCATE_BUFFER, NULL };
  
-     status = wmi_evaluate_method(WMID_GUID5, 0, ACER_WMID_SET_BATTERY_HEALTH_CONTROL_METHODID, &input, &output);
+     /*
+      * Whatever the outcome, the cached status can't be trusted anymore. Hold
+      * the lock across the call, so no query refills it with the old status.
+      */
+     mutex_lock(&battery_health_lock);
+     status = acer_wmi_evaluate(ACER_WMI_GUID5, ACER_WMID_SET_BATTERY_HEALTH_CONTROL_METHODID, &input, &output);
+     battery_health_invalidate();
+     mutex_unlock(&battery_health_lock);
      if (ACPI_FAILURE(status))
          return status;
      
@@ -1048,14 +1957,54 @@ enum acer_predator_v4_thermal_profile {
      }
  
      kfree(obj);
+
+     /* Read back once, as the settings do, so the cache is never left empty */
+     mutex_lock(&battery_health_lock);
+     battery_health_cache_fill();
+     mutex_unlock(&battery_health_lock);
      return AE_OK;
  
      failed:
            kfree(obj);
            return AE_ERROR;
  }
- 
- 
+
+ /*
+  * Fill the profile, battery and settings caches that are empty, so the state
+  * snapshot can serve them without calling the firmware. Called at probe, on
+  * resume and after events that dropped a cache.
+  */
+ static void acer_state_caches_fill(void)
+ {
+     if (READ_ONCE(thermal_profile_cached) < 0)
+         acer_thermal_profile_refresh();
+
+     if (!has_cap(ACER_CAP_PREDATOR_SENSE))
+         return;
+
+     mutex_lock(&battery_health_lock);
+     if (!battery_health_cache.valid)
+         battery_health_cache_fill();
+     mutex_unlock(&battery_health_lock);
+
+     mutex_lock(&acer_settings_lock);
+     for (int i = 0; i < ACER_SETTING_MAX; i++) {
+         if (!acer_settings[i].valid)
+             acer_setting_fetch(&acer_settings[i]);
+     }
+     mutex_unlock(&acer_settings_lock);
+ }
+
+ /* Drop every firmware cache and refill the snapshot's, after the state may have changed */
+ static void acer_caches_reload(void)
+ {
+     lighting_state_invalidate();
+     battery_health_invalidate();
+     acer_settings_invalidate();
+     WRITE_ONCE(thermal_profile_cached, -1);
+     acer_state_caches_fill();
+ }
+
  static ssize_t predator_battery_limit_show(struct device *dev,
                                             struct device_attribute *attr,
                                             char *buf) {
@@ -1073,10 +2022,8 @@ enum acer_predator_v4_thermal_profile {
                                              struct device_attribute *attr,
                                              const char *buf, size_t count) {
      u8 val;
-       if (sscanf(buf, "%hhd", &val) != 1)
-         return -EINVAL;
- 
-       if ((val != 0) && (val != 1))
+
+     if (kstrtou8(buf, 10, &val) || val > 1)
          return -EINVAL;
        
      if (battery_health_set(HEALTH_MODE,val) != AE_OK)
@@ -1102,10 +2049,8 @@ enum acer_predator_v4_thermal_profile {
                                              struct device_attribute *attr,
                                              const char *buf, size_t count) {
      u8 val;
-       if (sscanf(buf, "%hhd", &val) != 1)
-         return -EINVAL;
-       
-     if ((val != 0) && (val != 1))
+
+     if (kstrtou8(buf, 10, &val) || val > 1)
          return -EINVAL;
        
      if (battery_health_set(CALIBRATION_MODE,val) != AE_OK)
@@ -1114,7 +2059,331 @@ enum acer_predator_v4_thermal_profile {
      return count;
  }
  
+ static ssize_t predator_battery_cache_show(struct device *dev,
+                                            struct device_attribute *attr,
+                                            char *buf) {
+     return sprintf(buf, "%u\n", READ_ONCE(battery_health_cache.max_age_ms));
+ }
+
+ static ssize_t predator_battery_cache_store(struct device *dev,
+                                             struct device_attribute *attr,
+                                             const char *buf, size_t count) {
+     unsigned int val;
+
+     /* 0 re-reads the firmware on every access */
+     if (kstrtouint(buf, 10, &val) || val > 3600000)
+         return -EINVAL;
+
+     mutex_lock(&battery_health_lock);
+     battery_health_cache.max_age_ms = val;
+     mutex_unlock(&battery_health_lock);
+
+     return count;
+ }
+
+ /*
+  * power_supply charge control
+  *
+  * Exposes the limiter as charge_control_end_threshold (80 or 100) and the
+  * calibration as charge_behaviour (auto or force-discharge) on the system
+  * battery, so desktop power managers can drive them. Reads use the cache.
+  */
+ static const enum power_supply_property acer_battery_props[] = {
+     POWER_SUPPLY_PROP_CHARGE_CONTROL_END_THRESHOLD,
+     POWER_SUPPLY_PROP_CHARGE_BEHAVIOUR,
+ };
+
+ static int acer_battery_get_property(struct power_supply *psy, const struct power_supply_ext *ext,
+                                      void *data, enum power_supply_property psp,
+                                      union power_supply_propval *val)
+ {
+     int enabled;
+
+     switch (psp) {
+     case POWER_SUPPLY_PROP_CHARGE_CONTROL_END_THRESHOLD:
+         if (ACPI_FAILURE(battery_health_query(HEALTH_MODE, &enabled)))
+             return -ENODEV;
+         val->intval = enabled ? 80 : 100;
+         return 0;
+     case POWER_SUPPLY_PROP_CHARGE_BEHAVIOUR:
+         if (ACPI_FAILURE(battery_health_query(CALIBRATION_MODE, &enabled)))
+             return -ENODEV;
+         val->intval = enabled ? POWER_SUPPLY_CHARGE_BEHAVIOUR_FORCE_DISCHARGE
+                               : POWER_SUPPLY_CHARGE_BEHAVIOUR_AUTO;
+         return 0;
+     default:
+         return -EINVAL;
+     }
+ }
+
+ static int acer_battery_set_property(struct power_supply *psy, const struct power_supply_ext *ext,
+                                      void *data, enum power_supply_property psp,
+                                      const union power_supply_propval *val)
+ {
+     switch (psp) {
+     case POWER_SUPPLY_PROP_CHARGE_CONTROL_END_THRESHOLD:
+         /* The firmware only knows the fixed 80% limit */
+         if (val->intval != 80 && val->intval != 100)
+             return -EINVAL;
+         if (battery_health_set(HEALTH_MODE, val->intval == 80) != AE_OK)
+             return -ENODEV;
+         return 0;
+     case POWER_SUPPLY_PROP_CHARGE_BEHAVIOUR:
+         if (val->intval != POWER_SUPPLY_CHARGE_BEHAVIOUR_AUTO &&
+             val->intval != POWER_SUPPLY_CHARGE_BEHAVIOUR_FORCE_DISCHARGE)
+             return -EINVAL;
+         if (battery_health_set(CALIBRATION_MODE,
+                                val->intval == POWER_SUPPLY_CHARGE_BEHAVIOUR_FORCE_DISCHARGE) != AE_OK)
+             return -ENODEV;
+         return 0;
+     default:
+         return -EINVAL;
+     }
+ }
+
+ static int acer_battery_property_is_writeable(struct power_supply *psy,
+                                               const struct power_supply_ext *ext,
+                                               void *data, enum power_supply_property psp)
+ {
+     return true;
+ }
+
+ static const struct power_supply_ext acer_battery_ext = {
+     .name = "nekro_sense",
+     .properties = acer_battery_props,
+     .num_properties = ARRAY_SIZE(acer_battery_props),
+     .charge_behaviours = BIT(POWER_SUPPLY_CHARGE_BEHAVIOUR_AUTO) |
+                          BIT(POWER_SUPPLY_CHARGE_BEHAVIOUR_FORCE_DISCHARGE),
+     .get_property = acer_battery_get_property,
+     .set_property = acer_battery_set_property,
+     .property_is_writeable = acer_battery_property_is_writeable,
+ };
+
+ /* Platform device the extension is registered for, set before the hook */
+ static struct device *acer_battery_dev;
+
+ static int acer_battery_add(struct power_supply *battery, struct acpi_battery_hook *hook)
+ {
+     return power_supply_register_extension(battery, &acer_battery_ext,
+                                            acer_battery_dev, NULL);
+ }
+
+ static int acer_battery_remove(struct power_supply *battery, struct acpi_battery_hook *hook)
+ {
+     power_supply_unregister_extension(battery, &acer_battery_ext);
+     return 0;
+ }
+
+ static struct acpi_battery_hook acer_battery_hook = {
+     .add_battery = acer_battery_add,
+     .remove_battery = acer_battery_remove,
+     .name = "Acer Battery Extension",
+ };
  
+ /*
+  * Battery telemetry
+  *
+  * A low-rate sampler records the power source word, limiter, calibration and
+  * platform profile into a ring buffer. The "history" binary attribute
+  * returns the samples oldest first, "summary" the time accounted to each
+  * state since load. Time between samples is attributed to the earlier sample,
+  * gaps longer than two intervals (suspend) are counted as untracked.
+  */
+ #define BATTERY_TELEMETRY_SAMPLES		256
+ #define BATTERY_TELEMETRY_MIN_INTERVAL_S	5
+
+ struct battery_telemetry_sample {
+     u64 timestamp_ms;		/* CLOCK_BOOTTIME */
+     u64 bat_status;		/* ACER_WMID_CMD_GET_PREDATOR_V4_BAT_STATUS word */
+     u8 on_ac;
+     u8 limiter;
+     u8 calibration;
+     u8 profile;		/* raw thermal profile, 0xFF if unknown */
+     u32 reserved;
+ } __packed;
+
+ struct battery_telemetry {
+     unsigned int interval_s;	/* 0 stops the sampler */
+     struct battery_telemetry_sample ring[BATTERY_TELEMETRY_SAMPLES];
+     unsigned int head;		/* next slot to write */
+     unsigned int count;
+     u64 ac_ms;
+     u64 battery_ms;
+     u64 limited_ms;
+     u64 untracked_ms;
+     u64 calibration_runs;
+ };
+
+ static DEFINE_MUTEX(battery_telemetry_lock);
+ static struct battery_telemetry battery_telemetry = {
+     .interval_s = 60,
+ };
+
+ static void battery_telemetry_work_fn(struct work_struct *work);
+ static DECLARE_DELAYED_WORK(battery_telemetry_work, battery_telemetry_work_fn);
+
+ static void battery_telemetry_sample(struct battery_telemetry_sample *s)
+ {
+     int limiter = 0, calibration = 0;
+     u64 bat_status = 0;
+     u8 profile;
+
+     memset(s, 0, sizeof(*s));
+     s->timestamp_ms = div_u64(ktime_get_boottime_ns(), NSEC_PER_MSEC);
+
+     if (ACPI_SUCCESS(WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_SYS_INFO_METHODID,
+                                             ACER_WMID_CMD_GET_PREDATOR_V4_BAT_STATUS, &bat_status)))
+         s->on_ac = bat_status != 0;
+     else
+         s->on_ac = power_supply_is_system_supplied() > 0;
+     s->bat_status = bat_status;
+
+     battery_health_query(HEALTH_MODE, &limiter);
+     battery_health_query(CALIBRATION_MODE, &calibration);
+     s->limiter = limiter;
+     s->calibration = calibration;
+
+     s->profile = WMID_gaming_get_misc_setting(ACER_WMID_MISC_SETTING_PLATFORM_PROFILE, &profile) ?
+                  0xFF : profile;
+ }
+
+ /* Caller holds battery_telemetry_lock */
+ static void battery_telemetry_add(struct battery_telemetry *bt,
+                                   const struct battery_telemetry_sample *s)
+ {
+     if (bt->count) {
+         const struct battery_telemetry_sample *prev =
+             &bt->ring[(bt->head + BATTERY_TELEMETRY_SAMPLES - 1) % BATTERY_TELEMETRY_SAMPLES];
+         u64 delta = s->timestamp_ms - prev->timestamp_ms;
+
+         if (delta > 2000ULL * max_t(unsigned int, bt->interval_s, BATTERY_TELEMETRY_MIN_INTERVAL_S)) {
+             bt->untracked_ms += delta;
+         } else {
+             if (prev->on_ac)
+                 bt->ac_ms += delta;
+             else
+                 bt->battery_ms += delta;
+             if (prev->limiter)
+                 bt->limited_ms += delta;
+         }
+
+         if (!prev->calibration && s->calibration)
+             bt->calibration_runs++;
+     } else if (s->calibration) {
+         bt->calibration_runs++;
+     }
+
+     bt->ring[bt->head] = *s;
+     bt->head = (bt->head + 1) % BATTERY_TELEMETRY_SAMPLES;
+     bt->count = min_t(unsigned int, bt->count + 1, BATTERY_TELEMETRY_SAMPLES);
+ }
+
+ static void battery_telemetry_work_fn(struct work_struct *work)
+ {
+     struct battery_telemetry_sample s;
+     unsigned int interval;
+
+     battery_telemetry_sample(&s);
+
+     mutex_lock(&battery_telemetry_lock);
+     battery_telemetry_add(&battery_telemetry, &s);
+     interval = battery_telemetry.interval_s;
+     mutex_unlock(&battery_telemetry_lock);
+
+     if (interval)
+         schedule_delayed_work(&battery_telemetry_work, interval * HZ);
+ }
+
+ static ssize_t battery_telemetry_interval_show(struct device *dev, struct device_attribute *attr, char *buf)
+ {
+     return sprintf(buf, "%u\n", READ_ONCE(battery_telemetry.interval_s));
+ }
+
+ static ssize_t battery_telemetry_interval_store(struct device *dev, struct device_attribute *attr,
+                                                 const char *buf, size_t count)
+ {
+     unsigned int interval;
+
+     if (kstrtouint(buf, 10, &interval) ||
+         (interval && (interval < BATTERY_TELEMETRY_MIN_INTERVAL_S || interval > 86400)))
+         return -EINVAL;
+
+     mutex_lock(&battery_telemetry_lock);
+     battery_telemetry.interval_s = interval;
+     mutex_unlock(&battery_telemetry_lock);
+
+     if (interval)
+         mod_delayed_work(system_wq, &battery_telemetry_work, interval * HZ);
+     else
+         cancel_delayed_work_sync(&battery_telemetry_work);
+
+     return count;
+ }
+
+ static ssize_t battery_telemetry_summary_show(struct device *dev, struct device_attribute *attr, char *buf)
+ {
+     struct battery_telemetry *bt = &battery_telemetry;
+     ssize_t len;
+
+     mutex_lock(&battery_telemetry_lock);
+     len = sprintf(buf,
+                   "samples=%u\nac_s=%llu\nbattery_s=%llu\nlimited_s=%llu\nuntracked_s=%llu\n"
+                   "calibration_runs=%llu\n",
+                   bt->count, div_u64(bt->ac_ms, MSEC_PER_SEC),
+                   div_u64(bt->battery_ms, MSEC_PER_SEC), div_u64(bt->limited_ms, MSEC_PER_SEC),
+                   div_u64(bt->untracked_ms, MSEC_PER_SEC), bt->calibration_runs);
+     mutex_unlock(&battery_telemetry_lock);
+
+     return len;
+ }
+
+ static ssize_t battery_telemetry_history_read(struct file *filp, struct kobject *kobj,
+                                               const struct bin_attribute *attr, char *buf,
+                                               loff_t off, size_t count)
+ {
+     struct battery_telemetry *bt = &battery_telemetry;
+     struct battery_telemetry_sample *ring;
+     unsigned int first;
+     ssize_t ret;
+
+     ring = kmalloc(sizeof(bt->ring), GFP_KERNEL);
+     if (!ring)
+         return -ENOMEM;
+
+     /* Unroll the ring so the oldest sample comes first */
+     mutex_lock(&battery_telemetry_lock);
+     first = (bt->head + BATTERY_TELEMETRY_SAMPLES - bt->count) % BATTERY_TELEMETRY_SAMPLES;
+     for (unsigned int i = 0; i < bt->count; i++)
+         ring[i] = bt->ring[(first + i) % BATTERY_TELEMETRY_SAMPLES];
+     ret = memory_read_from_buffer(buf, count, &off, ring, bt->count * sizeof(*ring));
+     mutex_unlock(&battery_telemetry_lock);
+
+     kfree(ring);
+     return ret;
+ }
+
+ static struct device_attribute battery_telemetry_interval = __ATTR(interval_s, 0644, battery_telemetry_interval_show, battery_telemetry_interval_store);
+ static struct device_attribute battery_telemetry_summary = __ATTR(summary, 0444, battery_telemetry_summary_show, NULL);
+ static struct attribute *battery_telemetry_attrs[] = {
+     &battery_telemetry_interval.attr,
+     &battery_telemetry_summary.attr,
+     NULL
+ };
+ static const struct bin_attribute battery_telemetry_history = {
+     .attr = { .name = "history", .mode = 0444 },
+     .size = BATTERY_TELEMETRY_SAMPLES * sizeof(struct battery_telemetry_sample),
+     .read = battery_telemetry_history_read,
+ };
+ static const struct bin_attribute *const battery_telemetry_bin_attrs[] = {
+     &battery_telemetry_history,
+     NULL
+ };
+ static const struct attribute_group battery_telemetry_attr_group = {
+     .name = "battery_telemetry",
+     .attrs = battery_telemetry_attrs,
+     .bin_attrs = battery_telemetry_bin_attrs,
+ };
+
  /*
   * FAN CONTROLS
   */
@@ -1216,37 +2485,54 @@ enum acer_predator_v4_thermal_profile {
  }
  
  
+ /*
+  * "cpu,gpu" with both speeds in 0-100. kstrtou8 rejects out-of-range
+  * digits instead of truncating them the way sscanf's %u does.
+  */
+ static int fan_speed_parse(const char *s, u8 *cpu, u8 *gpu)
+ {
+     char tmp[16], *rest = tmp, *tok;
+     u8 c, g;
+
+     if (strscpy(tmp, s, sizeof(tmp)) < 0)
+         return -EINVAL;
+
+     tok = strsep(&rest, ",");
+     if (!rest || kstrtou8(tok, 10, &c) || kstrtou8(rest, 10, &g) ||
+         c > 100 || g > 100)
+         return -EINVAL;
+
+     *cpu = c;
+     *gpu = g;
+     return 0;
+ }
+
+ /* Copies a sysfs write into tmp without its trailing newline */
+ static int sysfs_input_copy(char *tmp, size_t size, const char *buf, size_t count)
+ {
+     if (!count || count >= size)
+         return -EINVAL;
+
+     memcpy(tmp, buf, count);
+     tmp[count] = '\0';
+     if (tmp[count - 1] == '\n')
+         tmp[count - 1] = '\0';
+     return 0;
+ }
+
  static ssize_t predator_fan_speed_store(struct device *dev,
                                              struct device_attribute *attr,
                                              const char *buf, size_t count) {
-     int t_cpu_fan_speed, t_gpu_fan_speed;
-     
      char input[9];
-     char *token;
-     char* input_ptr = input;
-     size_t len = min(count, sizeof(input) - 1);
-     strncpy(input, buf, len);
- 
-     if(input[len-1] == '\n'){
-         input[len-1] = '\0';
-     } else {
-         input[len] = '\0';
-     }
- 
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &t_cpu_fan_speed) || t_cpu_fan_speed < 0 || t_cpu_fan_speed > 100) {
-         pr_err("Invalid CPU speed value.\n");
-         return -EINVAL;
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &t_gpu_fan_speed) || t_gpu_fan_speed < 0 || t_gpu_fan_speed > 100) {
-         pr_err("Invalid GPU speed value.\n");
+     u8 cpu, gpu;
+
+     if (sysfs_input_copy(input, sizeof(input), buf, count) ||
+         fan_speed_parse(input, &cpu, &gpu)) {
+         pr_err("Invalid fan speed, expected cpu,gpu in 0-100.\n");
          return -EINVAL;
      }
- 
-     acpi_status status = acer_set_fan_speed(t_cpu_fan_speed, t_gpu_fan_speed);
+
+     acpi_status status = acer_set_fan_speed(cpu, gpu);
      if(ACPI_FAILURE(status)){
          return -ENODEV;
      } 
@@ -1254,12 +2540,50 @@ enum acer_predator_v4_thermal_profile {
      return count;
  }
  /*
-  * persistent predator states.
+  * Binary fan target: a write must cover the whole struct at offset 0.
+  * 0,0 is auto, 100,100 is max, anything else is custom.
   */
- struct acer_predator_state {
-     int cpu_fan_speed;
-     int gpu_fan_speed;
-     int thermal_profile;
+ struct fan_speed_raw {
+     u8 cpu;		/* 0-100 */
+     u8 gpu;		/* 0-100 */
+     u8 reserved[2];	/* must be 0 */
+ } __packed;
+ 
+ static ssize_t fan_speed_raw_read(struct file *filp, struct kobject *kobj,
+                                   const struct bin_attribute *attr, char *buf,
+                                   loff_t off, size_t count)
+ {
+     struct fan_speed_raw raw = { .cpu = cpu_fan_speed, .gpu = gpu_fan_speed };
+ 
+     return memory_read_from_buffer(buf, count, &off, &raw, sizeof(raw));
+ }
+ 
+ static ssize_t fan_speed_raw_write(struct file *filp, struct kobject *kobj,
+                                    const struct bin_attribute *attr, char *buf,
+                                    loff_t off, size_t count)
+ {
+     struct fan_speed_raw raw;
+ 
+     if (off || count != sizeof(raw))
+         return -EINVAL;
+ 
+     memcpy(&raw, buf, sizeof(raw));
+     if (raw.cpu > 100 || raw.gpu > 100 || memchr_inv(raw.reserved, 0, sizeof(raw.reserved)))
+         return -EINVAL;
+ 
+     if (ACPI_FAILURE(acer_set_fan_speed(raw.cpu, raw.gpu)))
+         return -ENODEV;
+ 
+     return count;
+ }
+ 
+ /*
+  * persistent predator states.
+  */
+ struct acer_predator_state {
+     int cpu_fan_speed;
+     int gpu_fan_speed;
+     int thermal_profile;
  };
  
  struct power_states {
@@ -1317,8 +2641,12 @@ enum acer_predator_v4_thermal_profile {
  }
  
  static acpi_status acer_predator_state_restore(int value){
-     int err = WMID_gaming_set_misc_setting(ACER_WMID_MISC_SETTING_PLATFORM_PROFILE, 
+     int err;
+
+     mutex_lock(&acer_profile_lock);
+     err = WMID_gaming_set_misc_setting(ACER_WMID_MISC_SETTING_PLATFORM_PROFILE, 
                                         value == 0 ? current_states.battery_state.thermal_profile : current_states.ac_state.thermal_profile);
+     mutex_unlock(&acer_profile_lock);
      if (err)
          return err;
  
@@ -1416,106 +2744,6 @@ enum acer_predator_v4_thermal_profile {
      return 0;
  }
  
- /*
-  *LCD OVERRIDE CONTROLS
-  */
- static ssize_t predator_lcd_override_show(struct device *dev, struct device_attribute *attr,char *buf){
-     acpi_status status;
-     u64 result;
-     status = WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_PROFILE_METHODID,0x00,&result);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error getting lcd override status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
-     }
-     pr_info("lcd override get status: %llu\n",result);
-     return sprintf(buf, "%d\n", result == 0x1000001000000 ? 1 : result == 0x1000000 ? 0 : -1);
- }
- 
- static ssize_t predator_lcd_override_store(struct device *dev, struct device_attribute *attr,const char *buf, size_t count){
-     acpi_status status;
-     u64 result;
-     u8 val;
-       if (sscanf(buf, "%hhd", &val) != 1)
-         return -EINVAL;
-       if ((val != 0) && (val != 1))
-         return -EINVAL;
-     pr_info("lcd_override set value: %d\n",val);
-     status = WMI_gaming_execute_u64(ACER_WMID_SET_GAMING_PROFILE_METHODID,val == 1 ? 0x1000000000010 : 0x10, &result);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error setting lcd override status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
-     }
-     pr_info("lcd override set status: %llu\n",result);
-     return count;
- }
- 
- /*
-  * BACKLIGHT 30 SEC TIMEOUT
-  */
- 
- static ssize_t predator_backlight_timeout_show(struct device *dev, struct device_attribute *attr,char *buf){
-     acpi_status status;
-     u64 result;
-     status = WMI_apgeaction_execute_u64(ACER_WMID_GET_FUNCTION,0x88401,&result);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error getting backlight_timeout status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
-     }
-     pr_info("backlight_timeout get status: %llu\n",result);
-     return sprintf(buf, "%d\n", result == 0x1E0000080000 ? 1 : result == 0x80000 ? 0 : -1);
- }
- 
- static ssize_t predator_backlight_timeout_store(struct device *dev, struct device_attribute *attr,const char *buf, size_t count){
-     acpi_status status;
-     u64 result;
-     u8 val;
-       if (sscanf(buf, "%hhd", &val) != 1)
-         return -EINVAL;
-       if ((val != 0) && (val != 1))
-         return -EINVAL;
-     pr_info("bascklight_timeout set value: %d\n",val);
-     status = WMI_apgeaction_execute_u64(ACER_WMID_SET_FUNCTION,val == 1 ? 0x1E0000088402 : 0x88402, &result);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error setting backlight_timeout status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
-     }
-     pr_info("backlight_timeout set status: %llu\n",result);
-     return count;
- }
- 
- /*
-  * System Boot Animation & Sound 
-  */
- static ssize_t predator_boot_animation_sound_show(struct device *dev, struct device_attribute *attr,char *buf){
-     acpi_status status;
-     u64 result;
-     status = WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_MISC_SETTING_METHODID,0x6,&result);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error getting boot_animation_sound status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
-     }
-     pr_info("boot_animation_sound get status: %llu\n",result);
-     return sprintf(buf, "%d\n", result == 0x100 ? 1 : result == 0 ? 0 : -1);
- }
- 
- static ssize_t predator_boot_animation_sound_store(struct device *dev, struct device_attribute *attr,const char *buf, size_t count){
-     acpi_status status;
-     u64 result;
-     u8 val;
-       if (sscanf(buf, "%hhd", &val) != 1)
-         return -EINVAL;
-       if ((val != 0) && (val != 1))
-         return -EINVAL;
-     pr_info("boot_animation_sound set value: %d\n",val);
-     status = WMI_gaming_execute_u64(ACER_WMID_SET_GAMING_MISC_SETTING_METHODID,val == 1 ? 0x106 : 0x6, &result);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error setting boot_animation_sound status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
-     }
-     pr_info("boot_animation_sound set status: %llu\n",result);
-     return count;
- }
-
 /*
  * LIGHTING RESET CONTROL
  * Calls Method 2 (SetGamingLED) to attempt to un-brick/reset the lighting controller.
@@ -1545,28 +2773,42 @@ static ssize_t predator_lighting_reset_store(struct device *dev, struct device_a
  /*
   * predator sense attributes
   */
- static struct device_attribute boot_animation_sound = __ATTR(boot_animation_sound, 0644, predator_boot_animation_sound_show, predator_boot_animation_sound_store);
+ ACER_SETTING_ATTR(boot_animation_sound, ACER_SETTING_BOOT_ANIMATION_SOUND);
 static struct device_attribute lighting_reset = __ATTR(lighting_reset, 0200, NULL, predator_lighting_reset_store); /* Write-only */
- static struct device_attribute backlight_timeout = __ATTR(backlight_timeout, 0644, predator_backlight_timeout_show, predator_backlight_timeout_store);
- static struct device_attribute usb_charging = __ATTR(usb_charging, 0644, predator_usb_charging_show, predator_usb_charging_store);
+ ACER_SETTING_ATTR(backlight_timeout, ACER_SETTING_BACKLIGHT_TIMEOUT);
+ ACER_SETTING_ATTR(usb_charging, ACER_SETTING_USB_CHARGING);
  static struct device_attribute battery_calibration = __ATTR(battery_calibration, 0644, predator_battery_calibration_show, preadtor_battery_calibration_store);
  static struct device_attribute battery_limiter = __ATTR(battery_limiter, 0644, predator_battery_limit_show, predator_battery_limit_store);
+ static struct device_attribute battery_cache_ms = __ATTR(battery_cache_ms, 0644, predator_battery_cache_show, predator_battery_cache_store);
  static struct device_attribute fan_speed = __ATTR(fan_speed, 0644, predator_fan_speed_show, predator_fan_speed_store);
- static struct device_attribute lcd_override = __ATTR(lcd_override, 0644, predator_lcd_override_show, predator_lcd_override_store);
+ ACER_SETTING_ATTR(lcd_override, ACER_SETTING_LCD_OVERRIDE);
  static struct attribute *predator_sense_attrs[] = {
-     &lcd_override.attr,
+     &lcd_override.attr.attr,
     &lighting_reset.attr,
      &fan_speed.attr,
      &battery_limiter.attr,
      &battery_calibration.attr,
-     &usb_charging.attr,
-     &backlight_timeout.attr,
-     &boot_animation_sound.attr,
+     &battery_cache_ms.attr,
+     &usb_charging.attr.attr,
+     &backlight_timeout.attr.attr,
+     &boot_animation_sound.attr.attr,
+     NULL
+ };
+ 
+ static const struct bin_attribute fan_speed_raw = {
+     .attr = { .name = "fan_speed_raw", .mode = 0644 },
+     .size = sizeof(struct fan_speed_raw),
+     .read = fan_speed_raw_read,
+     .write = fan_speed_raw_write,
+ };
+ static const struct bin_attribute *const predator_sense_bin_attrs[] = {
+     &fan_speed_raw,
      NULL
  };
  
  static struct attribute_group preadtor_sense_attr_group = {
-     .name = "predator_sense", .attrs = predator_sense_attrs
+     .name = "predator_sense", .attrs = predator_sense_attrs,
+     .bin_attrs = predator_sense_bin_attrs,
  };
  
 
@@ -1590,7 +2832,7 @@ static struct device_attribute lighting_reset = __ATTR(lighting_reset, 0200, NUL
      struct acpi_buffer output = { ACPI_ALLOCATE_BUFFER, NULL };
      struct acpi_buffer input = { (acpi_size)sizeof(gmInput), (void *)(gmInput) };
      
-     status = wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID, &input, &output);
+     status = acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID, &input, &output);
      if (ACPI_FAILURE(status))
          return status;
  
@@ -1624,7 +2866,7 @@ static struct device_attribute lighting_reset = __ATTR(lighting_reset, 0200, NUL
      struct acpi_buffer output = { ACPI_ALLOCATE_BUFFER, NULL };
      struct acpi_buffer input = { (acpi_size) sizeof(u64), (void *)(&in) };
  
-     status = wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_GET_GAMING_KB_BACKLIGHT_METHODID, &input, &output);
+     status = acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_GET_GAMING_KB_BACKLIGHT_METHODID, &input, &output);
      if (ACPI_FAILURE(status))
          return status;
      
@@ -1647,21 +2889,49 @@ static struct device_attribute lighting_reset = __ATTR(lighting_reset, 0200, NUL
            return AE_ERROR;
  }
 
-/* Back logo/lightbar (LB) unified setter/getter via WMBH (WMID_GUID4) */
+/* Last back logo state written by the driver */
+struct logo_state {
+    u8 red;
+    u8 green;
+    u8 blue;
+    u8 brightness;
+    u8 enable;
+} __packed;
+
+static struct logo_state current_logo_state;
+static bool logo_state_valid;
+
+/*
+ * Back logo/lightbar (LB) unified setter/getter via WMBH (WMID_GUID4)
+ *
+ * While the shadow state is valid only what changed is sent: the color write
+ * is skipped when it would be a no-op, and the LBLE gate only follows enable
+ * transitions, so a color-only change takes a single call.
+ */
 static acpi_status set_logo_status(int enable, int brightness, int effect,
                                    int red, int green, int blue)
 {
+    bool valid = READ_ONCE(logo_state_valid);
+    bool color_changed = !valid ||
+                         current_logo_state.red != (u8)red ||
+                         current_logo_state.green != (u8)green ||
+                         current_logo_state.blue != (u8)blue ||
+                         current_logo_state.brightness != (u8)brightness;
+    bool enable_changed = !valid || current_logo_state.enable != (u8)enable;
+
     /* Set logo RGB + brightness + enable using Arg1=0x0C (LBLR/LBLG/LBLB/LBLT/LBLF) */
-    {
+    if (color_changed || enable_changed) {
         u8 bhgk[6] = { 1 /* select LB set */, (u8)red, (u8)green, (u8)blue, (u8)brightness, (u8)enable };
         struct acpi_buffer in = { (acpi_size)sizeof(bhgk), (void *)bhgk };
-        acpi_status st = wmi_evaluate_method(WMID_GUID4, 0, 12 /* 0x0C */, &in, NULL);
-        if (ACPI_FAILURE(st))
+        acpi_status st = acer_wmi_evaluate(ACER_WMI_GUID4, 12 /* 0x0C */, &in, NULL);
+        if (ACPI_FAILURE(st)) {
+            WRITE_ONCE(logo_state_valid, false);
             return st;
+        }
     }
 
     /* Also drive the LBLE gate via unified setter (0x14), which some firmware uses for power */
-    {
+    if (enable_changed) {
         u8 bhlk[16] = {
             (u8)enable, /* LBLE */
             0,           /* LBLS */
@@ -1675,12 +2945,21 @@ static acpi_status set_logo_status(int enable, int brightness, int effect,
         };
         struct acpi_buffer out = { ACPI_ALLOCATE_BUFFER, NULL };
         struct acpi_buffer in = { (acpi_size)sizeof(bhlk), (void *)(bhlk) };
-        acpi_status st = wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID, &in, &out);
-        if (ACPI_FAILURE(st))
+        acpi_status st = acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID, &in, &out);
+        if (ACPI_FAILURE(st)) {
+            WRITE_ONCE(logo_state_valid, false);
             return st;
+        }
         if (out.pointer) kfree(out.pointer);
     }
 
+    current_logo_state.red = (u8)red;
+    current_logo_state.green = (u8)green;
+    current_logo_state.blue = (u8)blue;
+    current_logo_state.brightness = (u8)brightness;
+    current_logo_state.enable = (u8)enable;
+    WRITE_ONCE(logo_state_valid, true);
+
     return AE_OK;
 }
 
@@ -1697,7 +2976,7 @@ static acpi_status get_logo_status(struct get_four_zoned_kb_output *out)
     union acpi_object *obj;
 
     /* Get color via method id 13 (0x0D) */
-    if (ACPI_FAILURE(wmi_evaluate_method(WMID_GUID4, 0, 13, &in_col, &out_col)))
+    if (ACPI_FAILURE(acer_wmi_evaluate(ACER_WMI_GUID4, 13, &in_col, &out_col)))
         goto fallback_unified;
     obj = out_col.pointer;
     if (!obj || obj->type != ACPI_TYPE_BUFFER || obj->buffer.length < 6) {
@@ -1725,7 +3004,7 @@ fallback_unified:
         u64 sel = 2;
         struct acpi_buffer out_gkb = { ACPI_ALLOCATE_BUFFER, NULL };
         struct acpi_buffer in_gkb = { (acpi_size) sizeof(u64), (void *)(&sel) };
-        if (ACPI_FAILURE(wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_GET_GAMING_KB_BACKLIGHT_METHODID, &in_gkb, &out_gkb)))
+        if (ACPI_FAILURE(acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_GET_GAMING_KB_BACKLIGHT_METHODID, &in_gkb, &out_gkb)))
             return AE_ERROR;
         obj = out_gkb.pointer;
         if (!obj || obj->type != ACPI_TYPE_BUFFER || obj->buffer.length != 16) {
@@ -1759,124 +3038,296 @@ fallback_unified:
  } __packed;
  
  static struct kb_state current_kb_state;
+ static bool kb_state_valid;
+
+ /* Firmware zone ids used by methods 6/7, in zone order */
+ static const u8 kb_zone_ids[4] = { 0x1, 0x2, 0x4, 0x8 };
+
+ /*
+  * Serializes lighting firmware calls and the shadow state above. Taken by the
+  * sysfs stores and by the LED class callbacks, which may run concurrently.
+  */
+ static DEFINE_MUTEX(lighting_lock);
+
+/*
+ * The show attributes are served from the shadow state, which the driver keeps
+ * in sync with its own writes. It is re-read from the firmware on the first
+ * read after resume, after a hotkey event, or on a write to "refresh".
+ */
+static int four_zone_kb_state_update(void);
+
+static void lighting_state_invalidate(void)
+{
+    WRITE_ONCE(kb_state_valid, false);
+    WRITE_ONCE(logo_state_valid, false);
+}
+
+/* Caller holds lighting_lock */
+static int kb_state_refresh(void)
+{
+    if (four_zone_kb_state_update()) {
+        WRITE_ONCE(kb_state_valid, false);
+        return -ENODEV;
+    }
+    WRITE_ONCE(kb_state_valid, true);
+    return 0;
+}
+
+/* Caller holds lighting_lock */
+static int kb_state_get(struct kb_state *out)
+{
+    int ret = 0;
+
+    if (!READ_ONCE(kb_state_valid))
+        ret = kb_state_refresh();
+    if (!ret)
+        *out = current_kb_state;
+    return ret;
+}
+
+/* Caller holds lighting_lock */
+static int logo_state_refresh(void)
+{
+    struct get_four_zoned_kb_output out;
+
+    if (ACPI_FAILURE(get_logo_status(&out))) {
+        WRITE_ONCE(logo_state_valid, false);
+        return -ENODEV;
+    }
+
+    /* gmOutput indices: [5]=R, [6]=G, [7]=B, [2]=brightness, [0]=enable */
+    current_logo_state.enable = out.gmOutput[0];
+    current_logo_state.brightness = out.gmOutput[2];
+    current_logo_state.red = out.gmOutput[5];
+    current_logo_state.green = out.gmOutput[6];
+    current_logo_state.blue = out.gmOutput[7];
+    WRITE_ONCE(logo_state_valid, true);
+    return 0;
+}
+
+/* Caller holds lighting_lock */
+static int logo_state_get(struct logo_state *out)
+{
+    int ret = 0;
+
+    if (!READ_ONCE(logo_state_valid))
+        ret = logo_state_refresh();
+    if (!ret)
+        *out = current_logo_state;
+    return ret;
+}
  
  
  /* four zone mode */
  static ssize_t four_zoned_rgb_kb_show(struct device *dev, struct device_attribute *attr,char *buf){
-     acpi_status status;
-     struct get_four_zoned_kb_output output;
-     status = get_kb_status(&output);
-     if(ACPI_FAILURE(status)){
-         pr_err("Error getting kb status: %s\n",acpi_format_exception(status));
-         return -ENODEV;
-     }
-     return sprintf(buf, "%d,%d,%d,%d,%d,%d,%d\n",output.gmOutput[0],output.gmOutput[1],output.gmOutput[2],output.gmOutput[4],output.gmOutput[5],output.gmOutput[6],output.gmOutput[7]);
+     struct kb_state kb;
+     int ret;
+
+     mutex_lock(&lighting_lock);
+     ret = kb_state_get(&kb);
+     mutex_unlock(&lighting_lock);
+     if (ret)
+         return ret;
+     return sprintf(buf, "%d,%d,%d,%d,%d,%d,%d\n",kb.mode,kb.speed,kb.brightness,kb.direction,kb.red,kb.green,kb.blue);
  }
  
- static ssize_t four_zoned_rgb_kb_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count) {
-     acpi_status status;
- 
-     int mode, speed, brightness, direction, red, green, blue;
-     char input_buf[30];
-     char *token;
-     char *input_ptr = input_buf;
-     size_t len = min(count, sizeof(input_buf) - 1);
- 
-     strncpy(input_buf, buf, len);
- 
-     if(input_buf[len-1] == '\n'){
-         input_buf[len-1] = '\0';
-     } else {
-         input_buf[len] = '\0';
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &mode) || mode < 0 || mode > 7) {
-         pr_err("Invalid mode value.\n");
-         return -EINVAL;
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &speed) || speed < 0 || speed > 9) {
-         pr_err("Invalid speed value.\n");
-         return -EINVAL;
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &brightness) || brightness < 0 || brightness > 100) {
-         pr_err("Invalid brightness value.\n");
-         return -EINVAL;
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &direction) || ((direction <= 0) && (mode == 0x3 || mode == 0x4 )) || direction < 0 || direction > 2) {
-         pr_err("Invalid direction value.\n");
-         return -EINVAL;
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &red) || red < 0 || red > 255) {
-         pr_err("Invalid red value.\n");
-         return -EINVAL;
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &green) || green < 0 || green > 255) {
-         pr_err("Invalid green value.\n");
-         return -EINVAL;
-     }
- 
-     token = strsep(&input_ptr, ",");
-     if (!token || kstrtoint(token, 10, &blue) || blue < 0 || blue > 255) {
-         pr_err("Invalid blue value.\n");
-         return -EINVAL;
-     }
- 
-     switch (mode) {
+ /* Clear the effect parameters the mode ignores */
+ static int four_zone_mode_normalize(struct kb_state *kb)
+ {
+     switch (kb->mode) {
          case 0x0:  // Static mode: Ignore speed and direction
-             speed = 0;
-             direction = 0;
+             kb->speed = 0;
+             kb->direction = 0;
              break;
          case 0x1:  // Breathing mode: Ignore speed
-             speed = 0;
-             direction = 0;
+             kb->speed = 0;
+             kb->direction = 0;
              break;
          case 0x2:  // Neon mode: Ignore red, green, blue, and direction
-             red = 0;
-             green = 0;
-             blue = 0;
-             direction = 0;
+             kb->red = 0;
+             kb->green = 0;
+             kb->blue = 0;
+             kb->direction = 0;
              break;
          case 0x3:  // Wave mode: Ignore red, green, and blue
-             red = 0;
-             green = 0;
-             blue = 0;
+             kb->red = 0;
+             kb->green = 0;
+             kb->blue = 0;
              break;
          case 0x4:  // Shifting mode: No restrictions (all values allowed)
              break;
          case 0x5:  // Zoom mode: Ignore direction
-             direction = 0;
+             kb->direction = 0;
              break;
          case 0x6:  // Meteor mode: Ignore direction
-             direction = 0;
+             kb->direction = 0;
              break;
          case 0x7:  // Twinkling mode: Ignore direction
-             direction = 0;
+             kb->direction = 0;
              break;
          default:
              pr_err("Invalid mode value.\n");
              return -EINVAL;
      }
- 
-     status = set_kb_status(mode,speed,brightness,direction,red,green,blue);
+
+     return 0;
+ }
+
+ /* Apply a normalized effect and record it. Caller holds lighting_lock */
+ static acpi_status __set_four_zone_mode(const struct kb_state *kb)
+ {
+     acpi_status status;
+
+     status = set_kb_status(kb->mode, kb->speed, kb->brightness, kb->direction,
+                            kb->red, kb->green, kb->blue);
+     if (ACPI_FAILURE(status))
+         return status;
+
+     /* Set per_zone to 0 */
+     current_kb_state.per_zone = 0;
+     current_kb_state.mode = kb->mode;
+     current_kb_state.speed = kb->speed;
+     current_kb_state.brightness = kb->brightness;
+     current_kb_state.direction = kb->direction;
+     current_kb_state.red = kb->red;
+     current_kb_state.green = kb->green;
+     current_kb_state.blue = kb->blue;
+
+     return AE_OK;
+ }
+
+ /* Normalize the effect parameters for the mode and apply them */
+ static int set_four_zone_mode(int mode, int speed, int brightness, int direction,
+                               int red, int green, int blue)
+ {
+     struct kb_state kb = {
+         .mode = mode, .speed = speed, .brightness = brightness,
+         .direction = direction, .red = red, .green = green, .blue = blue,
+     };
+     acpi_status status;
+
+     if (four_zone_mode_normalize(&kb))
+         return -EINVAL;
+
+     mutex_lock(&lighting_lock);
+     status = __set_four_zone_mode(&kb);
+     mutex_unlock(&lighting_lock);
      if (ACPI_FAILURE(status)) {
          pr_err("Error setting RGB KB status.\n");
          return -ENODEV;
      }
+
+     return 0;
+ }
  
-     /* Set per_zone to 0 */
-     current_kb_state.per_zone = 0;
- 
+/* RRGGBB */
+static int lighting_parse_rgb(const char *s, u64 *rgb)
+{
+    if (strlen(s) != 6 || kstrtoull(s, 16, rgb))
+        return -EINVAL;
+    return 0;
+}
+
+/* RRGGBB,RRGGBB,RRGGBB,RRGGBB,brightness */
+static int lighting_parse_zones(char *s, struct kb_state *kb)
+{
+    u8 brightness;
+    char *tok;
+
+    for (int i = 0; i < 4; i++) {
+        tok = strsep(&s, ",");
+        if (!tok || lighting_parse_rgb(tok, &((u64 *)&kb->zones)[i]))
+            return -EINVAL;
+    }
+    if (!s || kstrtou8(s, 10, &brightness) || brightness > 100)
+        return -EINVAL;
+
+    kb->zones.brightness = brightness;
+    kb->per_zone = 1;
+    return 0;
+}
+
+/* Checks an effect against the four_zone_mode ranges and normalizes it */
+static int lighting_check_effect(struct kb_state *kb)
+{
+    if (kb->mode > 7 || kb->speed > 9 || kb->brightness > 100 || kb->direction > 2 ||
+        (!kb->direction && (kb->mode == 0x3 || kb->mode == 0x4)))
+        return -EINVAL;
+
+    kb->per_zone = 0;
+    return four_zone_mode_normalize(kb);
+}
+
+/* mode,speed,brightness,direction,R,G,B with the four_zone_mode ranges */
+static int lighting_parse_effect(const char *s, struct kb_state *kb)
+{
+    char tmp[32], *rest = tmp, *tok;
+    u8 v[7];
+
+    if (strscpy(tmp, s, sizeof(tmp)) < 0)
+        return -EINVAL;
+    for (int i = 0; i < ARRAY_SIZE(v); i++) {
+        tok = strsep(&rest, ",");
+        if (!tok || kstrtou8(tok, 10, &v[i]))
+            return -EINVAL;
+    }
+    if (rest)
+        return -EINVAL;
+
+    kb->mode = v[0];
+    kb->speed = v[1];
+    kb->brightness = v[2];
+    kb->direction = v[3];
+    kb->red = v[4];
+    kb->green = v[5];
+    kb->blue = v[6];
+    return lighting_check_effect(kb);
+}
+
+/* RRGGBB,brightness[,enable] */
+static int lighting_parse_logo(char *s, struct logo_state *logo)
+{
+    u8 brightness, enable;
+    char *tok;
+    u64 rgb;
+
+    tok = strsep(&s, ",");
+    if (!tok || lighting_parse_rgb(tok, &rgb))
+        return -EINVAL;
+    tok = strsep(&s, ",");
+    if (!tok || kstrtou8(tok, 10, &brightness) || brightness > 100)
+        return -EINVAL;
+    if (s) {
+        if (kstrtou8(s, 10, &enable) || enable > 1)
+            return -EINVAL;
+    } else {
+        enable = brightness > 0;
+    }
+
+    logo->red = (rgb >> 16) & 0xFF;
+    logo->green = (rgb >> 8) & 0xFF;
+    logo->blue = rgb & 0xFF;
+    logo->brightness = brightness;
+    logo->enable = enable;
+    return 0;
+}
+
+ static ssize_t four_zoned_rgb_kb_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count) {
+     struct kb_state kb = {};
+     char input_buf[30];
+     int ret;
+
+     if (sysfs_input_copy(input_buf, sizeof(input_buf), buf, count) ||
+         lighting_parse_effect(input_buf, &kb)) {
+         pr_err("Invalid four zone mode, expected mode,speed,brightness,direction,R,G,B.\n");
+         return -EINVAL;
+     }
+
+     ret = set_four_zone_mode(kb.mode, kb.speed, kb.brightness, kb.direction,
+                              kb.red, kb.green, kb.blue);
+     if (ret)
+         return ret;
+
      return count;
  }
  
@@ -1886,10 +3337,9 @@ fallback_unified:
  static acpi_status get_per_zone_color(struct per_zone_color *output) {
      acpi_status status;
      u64 *zones[] = { &output->zone1, &output->zone2, &output->zone3, &output->zone4 };
-     u8 zone_ids[] = { 0x1, 0x2, 0x4, 0x8 };
  
      for (int i = 0; i < 4; i++) {
-         status = WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_RGB_KB_METHODID, zone_ids[i], zones[i]);
+         status = WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_RGB_KB_METHODID, kb_zone_ids[i], zones[i]);
          if (ACPI_FAILURE(status)) {
              pr_err("Error getting kb status (zone %d): %s\n", i + 1, acpi_format_exception(status));
              return status;
@@ -1924,16 +3374,52 @@ fallback_unified:
      u8 blue;
  } __packed;
 
- static acpi_status set_per_zone_color(struct per_zone_color *input) {
-     acpi_status status;
-     u64 zone_vals[4] = { input->zone1, input->zone2, input->zone3, input->zone4 };
-     const u8 zone_ids[4] = { 0x1, 0x2, 0x4, 0x8 };
+/* Write a single zone (0x1/0x2/0x4/0x8) with one method 6 call, rgb is 0xRRGGBB */
+static acpi_status set_zone_color(u8 zone_id, u64 rgb)
+{
+    u64 v = rgb & 0xFFFFFFULL; /* RRGGBB */
+    /* Method id 6 expects a u64 (8 bytes). Pad the struct to 8 bytes. */
+    u64 payload = 0;
+    /*
+     * Construct payload: 0x00BBGGRRZZ (Little Endian in memory: ZZ RR GG BB 00 00 00 00)
+     * Struct is {zone, red, green, blue} -> 4 bytes
+     */
+    struct ls_led_zone_set_param *p = (struct ls_led_zone_set_param *)&payload;
+    struct acpi_buffer in = { sizeof(u64), &payload };
 
-     /* Ensure keyboard is in static mode with desired brightness first */
-     status = set_kb_status(0 /* static */, 0 /* speed */, input->brightness, 0 /* dir */, 0, 0, 0);
-     if (ACPI_FAILURE(status)) {
-         pr_err("Error setting KB status.\n");
-         return -ENODEV;
+    p->zone = zone_id;
+    p->red = (u8)((v >> 16) & 0xFF);
+    p->green = (u8)((v >> 8) & 0xFF);
+    p->blue = (u8)(v & 0xFF);
+
+    /* Method id 6 under WMID_GUID4 */
+    return acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_SET_GAMING_RGB_KB_METHODID, &in, NULL);
+}
+
+/* SetGamingLED(1) with the 16-byte payload the firmware expects */
+static acpi_status gaming_led_wake(void)
+{
+    u8 enable_cmd[16] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    struct acpi_buffer input_buf = { sizeof(enable_cmd), enable_cmd };
+    struct acpi_buffer output_buf = { ACPI_ALLOCATE_BUFFER, NULL };
+    acpi_status status;
+
+    status = acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_SET_GAMING_LED_METHODID, &input_buf, &output_buf);
+    if (ACPI_SUCCESS(status))
+        kfree(output_buf.pointer);
+
+    return status;
+}
+
+ static acpi_status __set_per_zone_color(struct per_zone_color *input, bool wake) {
+     acpi_status status;
+     u64 zone_vals[4] = { input->zone1, input->zone2, input->zone3, input->zone4 };
+
+     /* Ensure keyboard is in static mode with desired brightness first */
+     status = set_kb_status(0 /* static */, 0 /* speed */, input->brightness, 0 /* dir */, 0, 0, 0);
+     if (ACPI_FAILURE(status)) {
+         pr_err("Error setting KB status.\n");
+         return -ENODEV;
      }
 
     /*
@@ -1942,98 +3428,126 @@ fallback_unified:
      * the RGB controller to ensure it accepts the new color data.
      * Without this, the keyboard may become partially unresponsive or "stuck".
      */
-     if (has_cap(ACER_CAP_PREDATOR_SENSE)) {
-        u8 enable_cmd[16] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-        struct acpi_buffer input_buf = { sizeof(enable_cmd), enable_cmd };
-        struct acpi_buffer output_buf = { ACPI_ALLOCATE_BUFFER, NULL };
-
-        status = wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_SET_GAMING_LED_METHODID, &input_buf, &output_buf);
+     if (wake) {
+        status = gaming_led_wake();
         if (ACPI_FAILURE(status)) {
             pr_warn("Failed to wake up Gaming LED engine: %s\n", acpi_format_exception(status));
             /* Continue anyway, as it might just be already active or not supported on some FW */
-        } else {
-            kfree(output_buf.pointer);
         }
      }
 
      for (int i = 0; i < 4; i++) {
-         u64 v = zone_vals[i] & 0xFFFFFFULL; /* RRGGBB */
-        /* Method id 6 expects a u64 (8 bytes). Pad the struct to 8 bytes. */
-        u64 payload = 0;
-        /*
-         * Construct payload: 0x00BBGGRRZZ (Little Endian in memory: ZZ RR GG BB 00 00 00 00)
-         * Struct is {zone, red, green, blue} -> 4 bytes
-         */
-        struct ls_led_zone_set_param *p = (struct ls_led_zone_set_param *)&payload;
-        p->zone = zone_ids[i];
-        p->red = (u8)((v >> 16) & 0xFF);
-        p->green = (u8)((v >> 8) & 0xFF);
-        p->blue = (u8)(v & 0xFF);
-
-        struct acpi_buffer in = { sizeof(u64), &payload };
-
-        /* Method id 6 under WMID_GUID4 */
-        status = wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_SET_GAMING_RGB_KB_METHODID, &in, NULL);
+        status = set_zone_color(kb_zone_ids[i], zone_vals[i]);
         if (ACPI_FAILURE(status)) {
             pr_err("Error setting KB color (zone %d): %s\n", i + 1, acpi_format_exception(status));
+            /* The effect is already static, the shadow state no longer matches */
+            WRITE_ONCE(kb_state_valid, false);
             return status;
         }
      }
 
-     /* Mark state as per-zone */
+     /* Mark state as per-zone and remember what was written, static effect included */
      current_kb_state.per_zone = 1;
+     current_kb_state.mode = 0;
+     current_kb_state.speed = 0;
+     current_kb_state.brightness = input->brightness;
+     current_kb_state.direction = 0;
+     current_kb_state.red = 0;
+     current_kb_state.green = 0;
+     current_kb_state.blue = 0;
+     if (input != &current_kb_state.zones)
+         current_kb_state.zones = *input;
+     /* Every field is known now, whatever the firmware did before */
+     WRITE_ONCE(kb_state_valid, true);
 
      return AE_OK;
  }
+
+ static acpi_status set_per_zone_color(struct per_zone_color *input)
+ {
+     return __set_per_zone_color(input, has_cap(ACER_CAP_PREDATOR_SENSE));
+ }
  
+/*
+ * Reach the given per-zone state with as few firmware calls as possible: when
+ * the keyboard is known to be static per-zone at the same brightness only the
+ * zones whose color changed are written, otherwise fall back to the full
+ * set_per_zone_color() sequence. Caller holds lighting_lock.
+ */
+static acpi_status update_per_zone_color(struct per_zone_color *input)
+{
+    acpi_status status;
+
+    if (!READ_ONCE(kb_state_valid) || !current_kb_state.per_zone ||
+        current_kb_state.zones.brightness != input->brightness)
+        return set_per_zone_color(input);
+
+    for (int i = 0; i < 4; i++) {
+        u64 rgb = ((u64 *)input)[i] & 0xFFFFFFULL;
+
+        if (((u64 *)&current_kb_state.zones)[i] == rgb)
+            continue;
+
+        status = set_zone_color(kb_zone_ids[i], rgb);
+        if (ACPI_FAILURE(status)) {
+            pr_err("Error setting KB color (zone %d): %s\n", i + 1, acpi_format_exception(status));
+            return status;
+        }
+        ((u64 *)&current_kb_state.zones)[i] = rgb;
+    }
+
+    return AE_OK;
+}
+
+/* Change the brightness, keeping the current mode and colors. Caller holds lighting_lock */
+static acpi_status __set_kb_brightness(int brightness)
+{
+    acpi_status status;
+
+    if (current_kb_state.per_zone) {
+        struct per_zone_color zones = current_kb_state.zones;
+
+        zones.brightness = brightness;
+        return set_per_zone_color(&zones);
+    }
+
+    status = set_kb_status(current_kb_state.mode, current_kb_state.speed, brightness,
+                           current_kb_state.direction, current_kb_state.red,
+                           current_kb_state.green, current_kb_state.blue);
+    if (ACPI_SUCCESS(status))
+        current_kb_state.brightness = brightness;
+
+    return status;
+}
+
  static ssize_t per_zoned_rgb_kb_show(struct device *dev, struct device_attribute *attr,char *buf){
-     struct per_zone_color output;
-     acpi_status status;
-     status = get_per_zone_color(&output);
-     if(ACPI_FAILURE(status)){
-         return -ENODEV;
-     }
-     return sprintf(buf,"%06llx,%06llx,%06llx,%06llx,%d\n",output.zone1,output.zone2,output.zone3,output.zone4,output.brightness);
+     struct kb_state kb;
+     int ret;
+
+     mutex_lock(&lighting_lock);
+     ret = kb_state_get(&kb);
+     mutex_unlock(&lighting_lock);
+     if (ret)
+         return ret;
+     return sprintf(buf,"%06llx,%06llx,%06llx,%06llx,%d\n",kb.zones.zone1,kb.zones.zone2,kb.zones.zone3,kb.zones.zone4,kb.zones.brightness);
  }
  
  static ssize_t per_zoned_rgb_kb_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count) {
-     int i = 0;
-     size_t len;
-     char *token;
+     struct kb_state kb = {};
      char str_buf[34];
-     struct per_zone_color colors;
-     char *input_ptr = str_buf;
-     len = min(count, sizeof(str_buf) - 1);
-     strncpy(str_buf, buf, len);
-     if(str_buf[len-1] == '\n'){
-         str_buf[len-1] = '\0';
-     } else {
-         str_buf[len] = '\0';
-     }
- 
      acpi_status status;
- 
-     /* zone1,zone2,zone3,zone4 */
-     
-     while ((token = strsep(&input_ptr, ",")) && i < 4) {
-         if (strlen(token) != 6) {
-             pr_err("Invalid rgb length: %s (%lu) (must be 3 bytes)\n", token, strlen(token));
-             return -EINVAL;
-         }
-         if (kstrtoull(token, 16, &((u64 *)&colors)[i])) {
-             pr_err("Invalid hex value: %s\n", token);
-             return -EINVAL;
-         }
-         i++;
-     }
- 
-     if (!token || kstrtoint(token, 10, &colors.brightness) || colors.brightness < 0 || colors.brightness > 100) {
-         pr_err("Invalid brightness value.\n");
+
+     /* zone1,zone2,zone3,zone4,brightness */
+     if (sysfs_input_copy(str_buf, sizeof(str_buf), buf, count) ||
+         lighting_parse_zones(str_buf, &kb)) {
+         pr_err("Invalid per zone colors, expected RRGGBB,RRGGBB,RRGGBB,RRGGBB,brightness.\n");
          return -EINVAL;
      }
- 
+
      /* set per zone colors */
-     status = set_per_zone_color(&colors);
+     mutex_lock(&lighting_lock);
+     status = set_per_zone_color(&kb.zones);
+     mutex_unlock(&lighting_lock);
      if(ACPI_FAILURE(status)){
          pr_err("Error setting RGB KB status.\n");
          return -ENODEV;
@@ -2061,6 +3575,9 @@ fallback_unified:
      current_kb_state.red = out.gmOutput[5];
      current_kb_state.green = out.gmOutput[6];
      current_kb_state.blue = out.gmOutput[7];
+     /* Per-zone writes leave the keyboard in the static effect with no color */
+     current_kb_state.per_zone = current_kb_state.mode == 0 && !current_kb_state.red &&
+                                 !current_kb_state.green && !current_kb_state.blue;
  
      // Get per-zone color data
      status = get_per_zone_color(&current_kb_state.zones);
@@ -2138,152 +3655,2959 @@ fallback_unified:
          }
      }
  
+     /* The shadow state now matches what was just written */
+     WRITE_ONCE(kb_state_valid, true);
      pr_info("KB states restored successfully\n");
      return 0;
  }
  
+ /*
+  * Binary keyboard attributes. Layouts are fixed, all fields are single bytes,
+  * and a write must cover the whole struct at offset 0.
+  */
+ struct per_zone_raw {
+     u8 zone[4][3];	/* R, G, B for zones 1-4 */
+     u8 brightness;	/* 0-100 */
+     u8 reserved[3];	/* must be 0 */
+ } __packed;
+ 
+ struct four_zone_raw {
+     u8 mode;		/* 0-7 */
+     u8 speed;		/* 0-9 */
+     u8 brightness;	/* 0-100 */
+     u8 direction;	/* 0-2, 1-2 for wave and shifting */
+     u8 red;
+     u8 green;
+     u8 blue;
+     u8 reserved;	/* must be 0 */
+ } __packed;
+ 
+ static ssize_t per_zone_raw_read(struct file *filp, struct kobject *kobj,
+                                  const struct bin_attribute *attr, char *buf,
+                                  loff_t off, size_t count)
+ {
+     struct per_zone_raw raw = {};
+     struct kb_state kb;
+     int ret;
+ 
+     mutex_lock(&lighting_lock);
+     ret = kb_state_get(&kb);
+     mutex_unlock(&lighting_lock);
+     if (ret)
+         return ret;
+ 
+     for (int i = 0; i < 4; i++) {
+         u64 rgb = ((u64 *)&kb.zones)[i];
+ 
+         raw.zone[i][0] = (rgb >> 16) & 0xFF;
+         raw.zone[i][1] = (rgb >> 8) & 0xFF;
+         raw.zone[i][2] = rgb & 0xFF;
+     }
+     raw.brightness = kb.zones.brightness;
+ 
+     return memory_read_from_buffer(buf, count, &off, &raw, sizeof(raw));
+ }
+ 
+ static ssize_t per_zone_raw_write(struct file *filp, struct kobject *kobj,
+                                   const struct bin_attribute *attr, char *buf,
+                                   loff_t off, size_t count)
+ {
+     struct per_zone_color colors;
+     struct per_zone_raw raw;
+     acpi_status status;
+ 
+     if (off || count != sizeof(raw))
+         return -EINVAL;
+ 
+     memcpy(&raw, buf, sizeof(raw));
+     if (raw.brightness > 100 || memchr_inv(raw.reserved, 0, sizeof(raw.reserved)))
+         return -EINVAL;
+ 
+     for (int i = 0; i < 4; i++)
+         ((u64 *)&colors)[i] = ((u64)raw.zone[i][0] << 16) |
+                               ((u64)raw.zone[i][1] << 8) | raw.zone[i][2];
+     colors.brightness = raw.brightness;
+ 
+     mutex_lock(&lighting_lock);
+     status = set_per_zone_color(&colors);
+     mutex_unlock(&lighting_lock);
+     if (ACPI_FAILURE(status))
+         return -ENODEV;
+ 
+     return count;
+ }
+ 
+ static ssize_t four_zone_raw_read(struct file *filp, struct kobject *kobj,
+                                   const struct bin_attribute *attr, char *buf,
+                                   loff_t off, size_t count)
+ {
+     struct four_zone_raw raw = {};
+     struct kb_state kb;
+     int ret;
+ 
+     mutex_lock(&lighting_lock);
+     ret = kb_state_get(&kb);
+     mutex_unlock(&lighting_lock);
+     if (ret)
+         return ret;
+ 
+     raw.mode = kb.mode;
+     raw.speed = kb.speed;
+     raw.brightness = kb.brightness;
+     raw.direction = kb.direction;
+     raw.red = kb.red;
+     raw.green = kb.green;
+     raw.blue = kb.blue;
+ 
+     return memory_read_from_buffer(buf, count, &off, &raw, sizeof(raw));
+ }
+ 
+ static ssize_t four_zone_raw_write(struct file *filp, struct kobject *kobj,
+                                    const struct bin_attribute *attr, char *buf,
+                                    loff_t off, size_t count)
+ {
+     struct four_zone_raw raw;
+     int ret;
+ 
+     if (off || count != sizeof(raw))
+         return -EINVAL;
+ 
+     memcpy(&raw, buf, sizeof(raw));
+     if (raw.mode > 7 || raw.speed > 9 || raw.brightness > 100 || raw.direction > 2 ||
+         (!raw.direction && (raw.mode == 0x3 || raw.mode == 0x4)) || raw.reserved)
+         return -EINVAL;
+ 
+     ret = set_four_zone_mode(raw.mode, raw.speed, raw.brightness, raw.direction,
+                              raw.red, raw.green, raw.blue);
+     if (ret)
+         return ret;
+ 
+     return count;
+ }
+ 
+ static ssize_t kb_refresh_store(struct device *dev, struct device_attribute *attr,
+                                 const char *buf, size_t count)
+ {
+     int ret;
+
+     mutex_lock(&lighting_lock);
+     ret = kb_state_refresh();
+     mutex_unlock(&lighting_lock);
+     if (ret)
+         return ret;
+
+     return count;
+ }
+
  /* Four Zoned Keyboard Attributes */
  static struct device_attribute four_zoned_rgb_mode = __ATTR(four_zone_mode, 0644, four_zoned_rgb_kb_show, four_zoned_rgb_kb_store);
  static struct device_attribute per_zoned_rgb_mode = __ATTR(per_zone_mode, 0644, per_zoned_rgb_kb_show, per_zoned_rgb_kb_store);
+ static struct device_attribute kb_refresh = __ATTR(refresh, 0200, NULL, kb_refresh_store);
  static struct attribute *four_zoned_kb_attrs[] = {
      &four_zoned_rgb_mode.attr,
      &per_zoned_rgb_mode.attr,
+     &kb_refresh.attr,
+     NULL
+ };
+ 
+ static const struct bin_attribute per_zone_raw = {
+     .attr = { .name = "per_zone_raw", .mode = 0644 },
+     .size = sizeof(struct per_zone_raw),
+     .read = per_zone_raw_read,
+     .write = per_zone_raw_write,
+ };
+ static const struct bin_attribute four_zone_raw = {
+     .attr = { .name = "four_zone_raw", .mode = 0644 },
+     .size = sizeof(struct four_zone_raw),
+     .read = four_zone_raw_read,
+     .write = four_zone_raw_write,
+ };
+ static const struct bin_attribute *const four_zoned_kb_bin_attrs[] = {
+     &per_zone_raw,
+     &four_zone_raw,
      NULL
  };
  
  /* Four Zoned RGB Keyboard */
  static struct attribute_group four_zoned_kb_attr_group = {
-     .name = "four_zoned_kb", .attrs = four_zoned_kb_attrs
+     .name = "four_zoned_kb", .attrs = four_zoned_kb_attrs,
+     .bin_attrs = four_zoned_kb_bin_attrs,
  };
 
 /* Back logo/lightbar sysfs: expose a simple color+brightness control */
 static ssize_t back_logo_show(struct device *dev, struct device_attribute *attr, char *buf)
 {
-    struct get_four_zoned_kb_output out;
-    acpi_status status = get_logo_status(&out);
+    struct logo_state logo;
+    int ret;
+
+    mutex_lock(&lighting_lock);
+    ret = logo_state_get(&logo);
+    mutex_unlock(&lighting_lock);
+    if (ret)
+        return ret;
+    return sprintf(buf, "%02x%02x%02x,%d,%d\n",
+                   logo.red, logo.green, logo.blue, logo.brightness, logo.enable);
+}
+
+static int set_back_logo(u8 r, u8 g, u8 b, int brightness, int enable)
+{
+    acpi_status status;
+
+    /* Some firmware ignores the enable flag for LB; enforce off by forcing brightness=0 */
+    if (enable == 0)
+        brightness = 0;
+
+    /* effect 0 = static */
+    mutex_lock(&lighting_lock);
+    status = set_logo_status(enable, brightness, 0, r, g, b);
+    mutex_unlock(&lighting_lock);
     if (ACPI_FAILURE(status))
         return -ENODEV;
-    /* gmOutput indices: [5]=R, [6]=G, [7]=B, [2]=brightness, [0]=enable */
-    return sprintf(buf, "%02x%02x%02x,%d,%d\n",
-                   out.gmOutput[5], out.gmOutput[6], out.gmOutput[7],
-                   out.gmOutput[2], out.gmOutput[0]);
+
+    return 0;
 }
 
 static ssize_t back_logo_store(struct device *dev, struct device_attribute *attr, const char *buf, size_t count)
 {
-    /* Accept: RRGGBB,brightness[,enable] */
+    struct logo_state logo;
     char tmp[40];
-    size_t len = min(count, sizeof(tmp) - 1);
-    int brightness = -1, enable = -1;
-    unsigned int r = 0, g = 0, b = 0;
-    char *p, *tok;
-    acpi_status status;
+    int ret;
 
-    strncpy(tmp, buf, len);
-    if (tmp[len-1] == '\n')
-        tmp[len-1] = '\0';
-    else
-        tmp[len] = '\0';
-
-    p = tmp;
-    tok = strsep(&p, ",");
-    if (!tok || strlen(tok) != 6 ||
-        sscanf(tok, "%02x%02x%02x", &r, &g, &b) != 3) {
-        pr_err("Invalid color, expected RRGGBB\n");
+    if (sysfs_input_copy(tmp, sizeof(tmp), buf, count) ||
+        lighting_parse_logo(tmp, &logo)) {
+        pr_err("Invalid logo, expected RRGGBB,brightness[,enable]\n");
         return -EINVAL;
     }
-    tok = strsep(&p, ",");
-    if (!tok || kstrtoint(tok, 10, &brightness) || brightness < 0 || brightness > 100) {
-        pr_err("Invalid brightness 0-100\n");
+
+    ret = set_back_logo(logo.red, logo.green, logo.blue, logo.brightness, logo.enable);
+    if (ret)
+        return ret;
+    return count;
+}
+
+/* Binary logo color: a write must cover the whole struct at offset 0 */
+struct back_logo_raw {
+    u8 red;
+    u8 green;
+    u8 blue;
+    u8 brightness;	/* 0-100 */
+    u8 enable;		/* 0/1 */
+    u8 reserved[3];	/* must be 0 */
+} __packed;
+
+static ssize_t color_raw_read(struct file *filp, struct kobject *kobj,
+                              const struct bin_attribute *attr, char *buf,
+                              loff_t off, size_t count)
+{
+    struct back_logo_raw raw = {};
+    struct logo_state logo;
+    int ret;
+
+    mutex_lock(&lighting_lock);
+    ret = logo_state_get(&logo);
+    mutex_unlock(&lighting_lock);
+    if (ret)
+        return ret;
+
+    raw.red = logo.red;
+    raw.green = logo.green;
+    raw.blue = logo.blue;
+    raw.brightness = logo.brightness;
+    raw.enable = logo.enable;
+
+    return memory_read_from_buffer(buf, count, &off, &raw, sizeof(raw));
+}
+
+static ssize_t color_raw_write(struct file *filp, struct kobject *kobj,
+                               const struct bin_attribute *attr, char *buf,
+                               loff_t off, size_t count)
+{
+    struct back_logo_raw raw;
+    int ret;
+
+    if (off || count != sizeof(raw))
         return -EINVAL;
-    }
-    if (p && *p) {
-        tok = strsep(&p, ",");
-        if (!tok || kstrtoint(tok, 10, &enable) || (enable != 0 && enable != 1)) {
-            pr_err("Invalid enable (0/1)\n");
-            return -EINVAL;
-        }
-    }
 
-    if (enable < 0)
-        enable = brightness > 0 ? 1 : 0;
+    memcpy(&raw, buf, sizeof(raw));
+    if (raw.brightness > 100 || raw.enable > 1 || memchr_inv(raw.reserved, 0, sizeof(raw.reserved)))
+        return -EINVAL;
 
-    /* Some firmware ignores the enable flag for LB; enforce off by forcing brightness=0 */
-    if (enable == 0)
-        brightness = 0;
+    ret = set_back_logo(raw.red, raw.green, raw.blue, raw.brightness, raw.enable);
+    if (ret)
+        return ret;
+
+    return count;
+}
+
+static ssize_t logo_refresh_store(struct device *dev, struct device_attribute *attr,
+                                  const char *buf, size_t count)
+{
+    int ret;
+
+    mutex_lock(&lighting_lock);
+    ret = logo_state_refresh();
+    mutex_unlock(&lighting_lock);
+    if (ret)
+        return ret;
 
-    /* effect 0 = static */
-    status = set_logo_status(enable, brightness, 0, (int)r, (int)g, (int)b);
-    if (ACPI_FAILURE(status))
-        return -ENODEV;
     return count;
 }
 
 static struct device_attribute back_logo_attr = __ATTR(color, 0644, back_logo_show, back_logo_store);
+static struct device_attribute logo_refresh = __ATTR(refresh, 0200, NULL, logo_refresh_store);
 static struct attribute *back_logo_attrs[] = {
     &back_logo_attr.attr,
+    &logo_refresh.attr,
+    NULL
+};
+static const struct bin_attribute back_logo_color_raw = {
+    .attr = { .name = "color_raw", .mode = 0644 },
+    .size = sizeof(struct back_logo_raw),
+    .read = color_raw_read,
+    .write = color_raw_write,
+};
+static const struct bin_attribute *const back_logo_bin_attrs[] = {
+    &back_logo_color_raw,
     NULL
 };
 static const struct attribute_group back_logo_attr_group = {
     .name = "back_logo",
     .attrs = back_logo_attrs,
+    .bin_attrs = back_logo_bin_attrs,
 };
- /*
-  * Platform device
-  */
- 
-static void acer_gaming_init_lighting(void)
-{
-    acpi_status status;
-    /* 
-     * Windows WMI verification confirms proper payload size is 16 bytes.
-     * 8-byte (u64) payloads are rejected with "Invalid Parameter".
-     * Structure is likely u128 or specific struct with padding.
-     * Value 1 starts the engine.
-     */
-    u8 enable_cmd[16] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-    struct acpi_buffer input = { sizeof(enable_cmd), enable_cmd };
-    struct acpi_buffer output = { ACPI_ALLOCATE_BUFFER, NULL };
 
-    /*
-     * The official Windows driver sends a SetGamingLED(1) command 
-     * during service startup (boot) and likely on resume.
-     * This appears to be required to "unbrick" or enable the RGB controller
-     * if the BIOS disabled it (e.g. on AC plug event during boot).
-     */
-    if (has_cap(ACER_CAP_PREDATOR_SENSE)) {
-        /* 
-         * Try standard Method 2 (Gaming LED) with 16-byte payload 
-         */
-        status = wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_SET_GAMING_LED_METHODID, &input, &output);
-        if (ACPI_FAILURE(status))
-            pr_warn("Failed to enable Gaming LED engine (Method 2): %s\n", acpi_format_exception(status));
-        else {
-            pr_debug("Gaming LED engine enabled (Method 2)\n");
-            kfree(output.pointer);
-        }
+/*
+ * Combined lighting updates
+ *
+ * Applies a keyboard and a back logo change as one ordered batch under
+ * lighting_lock, so userspace never sees one without the other. Parts that
+ * already match the shadow state are skipped and keyboard zones are diffed one
+ * by one, which keeps the firmware call sequence as short as possible.
+ */
+#define LIGHTING_UPDATE_KB	BIT(0)
+#define LIGHTING_UPDATE_LOGO	BIT(1)
 
-        /* 
-         * Try Method 6 (Gaming RGB KB) with 8-byte payload of '1'
-         * Uncovered via WMI tracing of official driver service.
-         */
-        u64 magic = 1;
-        struct acpi_buffer input6 = { sizeof(u64), &magic };
-        struct acpi_buffer output6 = { ACPI_ALLOCATE_BUFFER, NULL };
-        
-        status = wmi_evaluate_method(WMID_GUID4, 0, ACER_WMID_SET_GAMING_RGB_KB_METHODID, &input6, &output6);
-        if (ACPI_FAILURE(status))
-             pr_warn("Failed to init Gaming RGB KB (Method 6): %s\n", acpi_format_exception(status));
-        else {
-             pr_info("Predator Sense: Gaming RGB KB initialized (Method 6, val=1)\n");
-             kfree(output6.pointer);
-        }
-    }
+struct lighting_update {
+    unsigned int flags;
+    struct kb_state kb;		/* per_zone selects zones or the effect fields */
+    struct logo_state logo;
+};
+
+/* Protected by lighting_lock */
+struct lighting_batch_stats {
+    u64 applied;
+    u64 failed;
+    u64 last_latency_us;
+    u64 max_latency_us;
+    u64 total_latency_us;
+};
+
+static struct lighting_batch_stats lighting_batch_stats;
+
+static bool kb_effect_equal(const struct kb_state *a, const struct kb_state *b)
+{
+    return a->mode == b->mode && a->speed == b->speed &&
+           a->brightness == b->brightness && a->direction == b->direction &&
+           a->red == b->red && a->green == b->green && a->blue == b->blue;
 }
 
-static int acer_platform_probe(struct platform_device *device)
+/* Caller holds lighting_lock */
+static acpi_status __lighting_update_apply(const struct lighting_update *u)
 {
-    int err;
+    acpi_status status;
+
+    if ((u->flags & LIGHTING_UPDATE_KB) && quirks->four_zone_kb) {
+        if (u->kb.per_zone) {
+            struct per_zone_color zones = u->kb.zones;
+
+            status = update_per_zone_color(&zones);
+        } else if (!READ_ONCE(kb_state_valid) || current_kb_state.per_zone ||
+                   !kb_effect_equal(&current_kb_state, &u->kb)) {
+            status = __set_four_zone_mode(&u->kb);
+        } else {
+            status = AE_OK;
+        }
+        if (ACPI_FAILURE(status))
+            return status;
+    }
+
+    if ((u->flags & LIGHTING_UPDATE_LOGO) && has_cap(ACER_CAP_BACK_LOGO)) {
+        /* As in set_back_logo, enforce off by forcing brightness=0 */
+        status = set_logo_status(u->logo.enable, u->logo.enable ? u->logo.brightness : 0, 0,
+                                 u->logo.red, u->logo.green, u->logo.blue);
+        if (ACPI_FAILURE(status))
+            return status;
+    }
+
+    return AE_OK;
+}
+
+static int lighting_update_apply(const struct lighting_update *u)
+{
+    acpi_status status;
+    ktime_t start;
+    u64 latency;
+
+    mutex_lock(&lighting_lock);
+    start = ktime_get();
+    status = __lighting_update_apply(u);
+    latency = ktime_us_delta(ktime_get(), start);
+    if (ACPI_SUCCESS(status)) {
+        lighting_batch_stats.applied++;
+        lighting_batch_stats.last_latency_us = latency;
+        lighting_batch_stats.total_latency_us += latency;
+        lighting_batch_stats.max_latency_us = max(lighting_batch_stats.max_latency_us, latency);
+    } else {
+        lighting_batch_stats.failed++;
+    }
+    mutex_unlock(&lighting_lock);
+
+    return ACPI_FAILURE(status) ? -ENODEV : 0;
+}
+
+static ssize_t batch_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct logo_state logo = {};
+    struct kb_state kb = {};
+    int len = 0;
+
+    mutex_lock(&lighting_lock);
+    if (quirks->four_zone_kb && kb_state_get(&kb))
+        goto failed;
+    if (has_cap(ACER_CAP_BACK_LOGO) && logo_state_get(&logo))
+        goto failed;
+    mutex_unlock(&lighting_lock);
+
+    if (quirks->four_zone_kb && kb.per_zone)
+        len += sprintf(buf + len, "kb=%06llx,%06llx,%06llx,%06llx,%d",
+                       kb.zones.zone1, kb.zones.zone2, kb.zones.zone3, kb.zones.zone4,
+                       kb.zones.brightness);
+    else if (quirks->four_zone_kb)
+        len += sprintf(buf + len, "kb_mode=%d,%d,%d,%d,%d,%d,%d", kb.mode, kb.speed,
+                       kb.brightness, kb.direction, kb.red, kb.green, kb.blue);
+    if (has_cap(ACER_CAP_BACK_LOGO))
+        len += sprintf(buf + len, "%slogo=%02x%02x%02x,%d,%d", len ? " " : "",
+                       logo.red, logo.green, logo.blue, logo.brightness, logo.enable);
+    len += sprintf(buf + len, "\n");
+
+    return len;
+
+failed:
+    mutex_unlock(&lighting_lock);
+    return -ENODEV;
+}
+
+/*
+ * Accepts space separated items, each at most once:
+ *   kb=RRGGBB,RRGGBB,RRGGBB,RRGGBB,brightness
+ *   kb_mode=mode,speed,brightness,direction,R,G,B
+ *   logo=RRGGBB,brightness[,enable]
+ */
+static ssize_t batch_store(struct device *dev, struct device_attribute *attr,
+                           const char *buf, size_t count)
+{
+    struct lighting_update u = {};
+    char tmp[96], *p = tmp, *tok;
+    int ret;
+
+    if (count >= sizeof(tmp))
+        return -EINVAL;
+    memcpy(tmp, buf, count);
+    tmp[count] = '\0';
+
+    while ((tok = strsep(&p, " \n"))) {
+        if (!*tok)
+            continue;
+
+        if (str_has_prefix(tok, "kb=") && !(u.flags & LIGHTING_UPDATE_KB)) {
+            ret = lighting_parse_zones(tok + 3, &u.kb);
+            u.flags |= LIGHTING_UPDATE_KB;
+        } else if (str_has_prefix(tok, "kb_mode=") && !(u.flags & LIGHTING_UPDATE_KB)) {
+            ret = lighting_parse_effect(tok + 8, &u.kb);
+            u.flags |= LIGHTING_UPDATE_KB;
+        } else if (str_has_prefix(tok, "logo=") && !(u.flags & LIGHTING_UPDATE_LOGO)) {
+            ret = lighting_parse_logo(tok + 5, &u.logo);
+            u.flags |= LIGHTING_UPDATE_LOGO;
+        } else {
+            ret = -EINVAL;
+        }
+        if (ret) {
+            pr_err("Invalid lighting batch item: %s\n", tok);
+            return ret;
+        }
+    }
+
+    if (!u.flags)
+        return -EINVAL;
+    if (((u.flags & LIGHTING_UPDATE_KB) && !quirks->four_zone_kb) ||
+        ((u.flags & LIGHTING_UPDATE_LOGO) && !has_cap(ACER_CAP_BACK_LOGO)))
+        return -EOPNOTSUPP;
+
+    ret = lighting_update_apply(&u);
+    if (ret)
+        return ret;
+
+    return count;
+}
+
+static ssize_t batch_stats_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct lighting_batch_stats st;
+
+    mutex_lock(&lighting_lock);
+    st = lighting_batch_stats;
+    mutex_unlock(&lighting_lock);
+
+    return sprintf(buf,
+                   "applied=%llu\nfailed=%llu\n"
+                   "latency_last_us=%llu\nlatency_avg_us=%llu\nlatency_max_us=%llu\n",
+                   st.applied, st.failed, st.last_latency_us,
+                   st.applied ? div64_u64(st.total_latency_us, st.applied) : 0,
+                   st.max_latency_us);
+}
+
+static struct device_attribute lighting_batch_attr = __ATTR(batch, 0644, batch_show, batch_store);
+static struct device_attribute lighting_batch_stats_attr = __ATTR(batch_stats, 0444, batch_stats_show, NULL);
+static struct attribute *lighting_attrs[] = {
+    &lighting_batch_attr.attr,
+    &lighting_batch_stats_attr.attr,
+    NULL
+};
+static const struct attribute_group lighting_attr_group = {
+    .name = "lighting",
+    .attrs = lighting_attrs,
+};
+
+/*
+ * Thermal-reactive lighting
+ *
+ * Colors the keyboard and/or the back logo along a two-point gradient driven
+ * by the CPU/GPU temperature. The temperature is sampled from the gaming
+ * sys-info sensors and mapped to one of THERMAL_LIGHTING_STEPS colors, so
+ * firmware writes only happen when the quantized color actually changes.
+ */
+#define THERMAL_LIGHTING_STEPS		16
+#define THERMAL_LIGHTING_MIN_INTERVAL_MS	250
+
+enum thermal_lighting_target {
+    THERMAL_LIGHTING_OFF,
+    THERMAL_LIGHTING_KEYBOARD,
+    THERMAL_LIGHTING_LOGO,
+    THERMAL_LIGHTING_BOTH,
+};
+
+static const char * const thermal_lighting_target_names[] = {
+    [THERMAL_LIGHTING_OFF] = "off",
+    [THERMAL_LIGHTING_KEYBOARD] = "keyboard",
+    [THERMAL_LIGHTING_LOGO] = "logo",
+    [THERMAL_LIGHTING_BOTH] = "both",
+};
+
+enum thermal_lighting_sensor {
+    THERMAL_LIGHTING_SENSOR_CPU,
+    THERMAL_LIGHTING_SENSOR_GPU,
+    THERMAL_LIGHTING_SENSOR_MAX,
+};
+
+static const char * const thermal_lighting_sensor_names[] = {
+    [THERMAL_LIGHTING_SENSOR_CPU] = "cpu",
+    [THERMAL_LIGHTING_SENSOR_GPU] = "gpu",
+    [THERMAL_LIGHTING_SENSOR_MAX] = "max",
+};
+
+struct thermal_lighting {
+    enum thermal_lighting_target target;
+    enum thermal_lighting_sensor sensor;
+    int cold_temp;
+    int hot_temp;
+    u32 cold_rgb;
+    u32 hot_rgb;
+    unsigned int interval_ms;
+    /* last color written, U32_MAX forces the next write */
+    u32 kb_rgb;
+    u32 logo_rgb;
+    int last_temp;
+    /* lighting from before a target was driven, put back when it stops */
+    struct lighting_update saved;
+};
+
+/* Protected by lighting_lock */
+static struct thermal_lighting thermal_lighting = {
+    .target = THERMAL_LIGHTING_OFF,
+    .sensor = THERMAL_LIGHTING_SENSOR_MAX,
+    .cold_temp = 40,
+    .hot_temp = 95,
+    .cold_rgb = 0x0000FF,
+    .hot_rgb = 0xFF0000,
+    .interval_ms = 2000,
+    .kb_rgb = U32_MAX,
+    .logo_rgb = U32_MAX,
+};
+
+static void thermal_lighting_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(thermal_lighting_work, thermal_lighting_work_fn);
+
+static int thermal_lighting_read_temp(enum thermal_lighting_sensor sensor, int *temp)
+{
+    u64 cpu = 0, gpu = 0;
+    int ret;
+
+    if (sensor != THERMAL_LIGHTING_SENSOR_GPU) {
+        ret = WMID_gaming_get_sensor_reading(ACER_WMID_SENSOR_CPU_TEMPERATURE, &cpu);
+        if (ret)
+            return ret;
+    }
+
+    if (sensor != THERMAL_LIGHTING_SENSOR_CPU) {
+        ret = WMID_gaming_get_sensor_reading(ACER_WMID_SENSOR_GPU_TEMPERATURE, &gpu);
+        if (ret)
+            return ret;
+    }
+
+    *temp = (int)max(cpu, gpu);
+
+    return 0;
+}
+
+static u32 thermal_lighting_color(const struct thermal_lighting *tl, int temp)
+{
+    int span = tl->hot_temp - tl->cold_temp;
+    u32 rgb = 0;
+    int step;
+
+    temp = clamp(temp, tl->cold_temp, tl->hot_temp);
+    step = (temp - tl->cold_temp) * THERMAL_LIGHTING_STEPS / span;
+
+    for (int shift = 0; shift <= 16; shift += 8) {
+        int cold = (tl->cold_rgb >> shift) & 0xFF;
+        int hot = (tl->hot_rgb >> shift) & 0xFF;
+        int c = cold + (hot - cold) * step / THERMAL_LIGHTING_STEPS;
+
+        rgb |= (u32)c << shift;
+    }
+
+    return rgb;
+}
+
+static void thermal_lighting_apply(struct thermal_lighting *tl, u32 rgb)
+{
+    bool keyboard = tl->target == THERMAL_LIGHTING_KEYBOARD || tl->target == THERMAL_LIGHTING_BOTH;
+    bool logo = tl->target == THERMAL_LIGHTING_LOGO || tl->target == THERMAL_LIGHTING_BOTH;
+    acpi_status status;
+
+    if (keyboard && quirks->four_zone_kb && rgb != tl->kb_rgb) {
+        struct per_zone_color zones = {
+            .zone1 = rgb, .zone2 = rgb, .zone3 = rgb, .zone4 = rgb,
+        };
+
+        if (current_kb_state.per_zone)
+            zones.brightness = current_kb_state.zones.brightness;
+        else
+            zones.brightness = current_kb_state.brightness ? current_kb_state.brightness : 100;
+
+        status = update_per_zone_color(&zones);
+        tl->kb_rgb = ACPI_SUCCESS(status) ? rgb : U32_MAX;
+    }
+
+    if (logo && has_cap(ACER_CAP_BACK_LOGO) && rgb != tl->logo_rgb) {
+        int brightness = current_logo_state.brightness ? current_logo_state.brightness : 100;
+
+        status = set_logo_status(1, brightness, 0, (rgb >> 16) & 0xFF,
+                                 (rgb >> 8) & 0xFF, rgb & 0xFF);
+        tl->logo_rgb = ACPI_SUCCESS(status) ? rgb : U32_MAX;
+    }
+}
+
+static void thermal_lighting_work_fn(struct work_struct *work)
+{
+    struct thermal_lighting *tl = &thermal_lighting;
+    unsigned int interval;
+    int temp;
+
+    mutex_lock(&lighting_lock);
+    if (tl->target == THERMAL_LIGHTING_OFF) {
+        mutex_unlock(&lighting_lock);
+        return;
+    }
+
+    if (!thermal_lighting_read_temp(tl->sensor, &temp)) {
+        tl->last_temp = temp;
+        thermal_lighting_apply(tl, thermal_lighting_color(tl, temp));
+    }
+    interval = tl->interval_ms;
+    mutex_unlock(&lighting_lock);
+
+    schedule_delayed_work(&thermal_lighting_work, msecs_to_jiffies(interval));
+}
+
+/* Called with lighting_lock held, forces a rewrite on the next sample */
+static void thermal_lighting_kick(struct thermal_lighting *tl)
+{
+    tl->kb_rgb = U32_MAX;
+    tl->logo_rgb = U32_MAX;
+
+    if (tl->target != THERMAL_LIGHTING_OFF)
+        mod_delayed_work(system_wq, &thermal_lighting_work, 0);
+}
+
+static unsigned int thermal_lighting_flags(enum thermal_lighting_target target)
+{
+    switch (target) {
+    case THERMAL_LIGHTING_KEYBOARD:
+        return LIGHTING_UPDATE_KB;
+    case THERMAL_LIGHTING_LOGO:
+        return LIGHTING_UPDATE_LOGO;
+    case THERMAL_LIGHTING_BOTH:
+        return LIGHTING_UPDATE_KB | LIGHTING_UPDATE_LOGO;
+    default:
+        return 0;
+    }
+}
+
+/* Called with lighting_lock held, before the targets in flags start being driven */
+static void thermal_lighting_save(struct thermal_lighting *tl, unsigned int flags)
+{
+    if ((flags & LIGHTING_UPDATE_KB) && quirks->four_zone_kb && !kb_state_get(&tl->saved.kb))
+        tl->saved.flags |= LIGHTING_UPDATE_KB;
+    if ((flags & LIGHTING_UPDATE_LOGO) && has_cap(ACER_CAP_BACK_LOGO) &&
+        !logo_state_get(&tl->saved.logo))
+        tl->saved.flags |= LIGHTING_UPDATE_LOGO;
+}
+
+/* Called with lighting_lock held, once the targets in flags are no longer driven */
+static void thermal_lighting_restore(struct thermal_lighting *tl, unsigned int flags)
+{
+    struct lighting_update u = tl->saved;
+
+    u.flags &= flags;
+    tl->saved.flags &= ~flags;
+    if (u.flags && ACPI_FAILURE(__lighting_update_apply(&u)))
+        pr_warn("Failed to restore lighting after thermal lighting\n");
+}
+
+static ssize_t thermal_lighting_mode_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%s\n", thermal_lighting_target_names[READ_ONCE(thermal_lighting.target)]);
+}
+
+static ssize_t thermal_lighting_mode_store(struct device *dev, struct device_attribute *attr,
+                                           const char *buf, size_t count)
+{
+    int target = sysfs_match_string(thermal_lighting_target_names, buf);
+    unsigned int driven, next;
+
+    if (target < 0)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    driven = thermal_lighting_flags(thermal_lighting.target);
+    next = thermal_lighting_flags(target);
+    thermal_lighting_save(&thermal_lighting, next & ~driven);
+    thermal_lighting.target = target;
+    thermal_lighting_restore(&thermal_lighting, driven & ~next);
+    thermal_lighting_kick(&thermal_lighting);
+    mutex_unlock(&lighting_lock);
+
+    if (target == THERMAL_LIGHTING_OFF)
+        cancel_delayed_work_sync(&thermal_lighting_work);
+
+    return count;
+}
+
+static ssize_t thermal_lighting_sensor_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%s\n", thermal_lighting_sensor_names[READ_ONCE(thermal_lighting.sensor)]);
+}
+
+static ssize_t thermal_lighting_sensor_store(struct device *dev, struct device_attribute *attr,
+                                             const char *buf, size_t count)
+{
+    int sensor = sysfs_match_string(thermal_lighting_sensor_names, buf);
+
+    if (sensor < 0)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    thermal_lighting.sensor = sensor;
+    thermal_lighting_kick(&thermal_lighting);
+    mutex_unlock(&lighting_lock);
+
+    return count;
+}
+
+static ssize_t thermal_lighting_gradient_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    ssize_t len;
+
+    mutex_lock(&lighting_lock);
+    len = sprintf(buf, "%d:%06x,%d:%06x\n", thermal_lighting.cold_temp, thermal_lighting.cold_rgb,
+                  thermal_lighting.hot_temp, thermal_lighting.hot_rgb);
+    mutex_unlock(&lighting_lock);
+
+    return len;
+}
+
+static ssize_t thermal_lighting_gradient_store(struct device *dev, struct device_attribute *attr,
+                                               const char *buf, size_t count)
+{
+    /* Accept: COLD_TEMP:RRGGBB,HOT_TEMP:RRGGBB */
+    int cold_temp, hot_temp;
+    unsigned int cold_rgb, hot_rgb;
+
+    if (sscanf(buf, "%d:%6x,%d:%6x", &cold_temp, &cold_rgb, &hot_temp, &hot_rgb) != 4) {
+        pr_err("Invalid gradient, expected COLD:RRGGBB,HOT:RRGGBB\n");
+        return -EINVAL;
+    }
+
+    if (cold_temp < 0 || hot_temp > 120 || hot_temp <= cold_temp) {
+        pr_err("Invalid gradient temperatures (0-120, cold < hot)\n");
+        return -EINVAL;
+    }
+
+    mutex_lock(&lighting_lock);
+    thermal_lighting.cold_temp = cold_temp;
+    thermal_lighting.hot_temp = hot_temp;
+    thermal_lighting.cold_rgb = cold_rgb;
+    thermal_lighting.hot_rgb = hot_rgb;
+    thermal_lighting_kick(&thermal_lighting);
+    mutex_unlock(&lighting_lock);
+
+    return count;
+}
+
+static ssize_t thermal_lighting_interval_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", READ_ONCE(thermal_lighting.interval_ms));
+}
+
+static ssize_t thermal_lighting_interval_store(struct device *dev, struct device_attribute *attr,
+                                               const char *buf, size_t count)
+{
+    unsigned int interval;
+
+    if (kstrtouint(buf, 10, &interval) || interval < THERMAL_LIGHTING_MIN_INTERVAL_MS)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    thermal_lighting.interval_ms = interval;
+    mutex_unlock(&lighting_lock);
+
+    return count;
+}
+
+static ssize_t thermal_lighting_temp_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%d\n", READ_ONCE(thermal_lighting.last_temp));
+}
+
+static struct device_attribute thermal_lighting_mode = __ATTR(mode, 0644, thermal_lighting_mode_show, thermal_lighting_mode_store);
+static struct device_attribute thermal_lighting_sensor = __ATTR(sensor, 0644, thermal_lighting_sensor_show, thermal_lighting_sensor_store);
+static struct device_attribute thermal_lighting_gradient = __ATTR(gradient, 0644, thermal_lighting_gradient_show, thermal_lighting_gradient_store);
+static struct device_attribute thermal_lighting_interval = __ATTR(interval_ms, 0644, thermal_lighting_interval_show, thermal_lighting_interval_store);
+static struct device_attribute thermal_lighting_temp = __ATTR(temperature, 0444, thermal_lighting_temp_show, NULL);
+static struct attribute *thermal_lighting_attrs[] = {
+    &thermal_lighting_mode.attr,
+    &thermal_lighting_sensor.attr,
+    &thermal_lighting_gradient.attr,
+    &thermal_lighting_interval.attr,
+    &thermal_lighting_temp.attr,
+    NULL
+};
+static const struct attribute_group thermal_lighting_attr_group = {
+    .name = "thermal_lighting",
+    .attrs = thermal_lighting_attrs,
+};
+
+/*
+ * Keypress-reactive lighting
+ *
+ * An input handler watches the internal keyboard and flashes the zone of every
+ * pressed key, then fades it back to the per-zone color in
+ * REACTIVE_LIGHTING_STEPS method-6 writes. Key events only record a timestamp;
+ * a single work item does the firmware writes at most once per
+ * REACTIVE_LIGHTING_MIN_INTERVAL_MS and only for zones whose fade level
+ * changed, so fast typing coalesces into a bounded call rate.
+ */
+#define REACTIVE_LIGHTING_STEPS			4
+#define REACTIVE_LIGHTING_MIN_INTERVAL_MS	40
+
+/* Key code to zone (1-4, 0 = no zone), left to right as on the 4-zone keyboards */
+static const u8 reactive_lighting_zones[128] = {
+    [KEY_ESC] = 1, [KEY_F1] = 1, [KEY_F2] = 1, [KEY_F3] = 1, [KEY_F4] = 1,
+    [KEY_GRAVE] = 1, [KEY_1] = 1, [KEY_2] = 1, [KEY_3] = 1, [KEY_4] = 1, [KEY_5] = 1,
+    [KEY_TAB] = 1, [KEY_Q] = 1, [KEY_W] = 1, [KEY_E] = 1, [KEY_R] = 1,
+    [KEY_CAPSLOCK] = 1, [KEY_A] = 1, [KEY_S] = 1, [KEY_D] = 1, [KEY_F] = 1,
+    [KEY_LEFTSHIFT] = 1, [KEY_102ND] = 1, [KEY_Z] = 1, [KEY_X] = 1, [KEY_C] = 1, [KEY_V] = 1,
+    [KEY_LEFTCTRL] = 1, [KEY_LEFTMETA] = 1, [KEY_LEFTALT] = 1,
+
+    [KEY_F5] = 2, [KEY_F6] = 2, [KEY_F7] = 2, [KEY_F8] = 2,
+    [KEY_6] = 2, [KEY_7] = 2, [KEY_8] = 2, [KEY_9] = 2,
+    [KEY_T] = 2, [KEY_Y] = 2, [KEY_U] = 2, [KEY_I] = 2, [KEY_O] = 2,
+    [KEY_G] = 2, [KEY_H] = 2, [KEY_J] = 2, [KEY_K] = 2,
+    [KEY_B] = 2, [KEY_N] = 2, [KEY_M] = 2, [KEY_COMMA] = 2, [KEY_SPACE] = 2,
+
+    [KEY_F9] = 3, [KEY_F10] = 3, [KEY_F11] = 3, [KEY_F12] = 3,
+    [KEY_SYSRQ] = 3, [KEY_SCROLLLOCK] = 3, [KEY_PAUSE] = 3,
+    [KEY_0] = 3, [KEY_MINUS] = 3, [KEY_EQUAL] = 3, [KEY_BACKSPACE] = 3,
+    [KEY_P] = 3, [KEY_LEFTBRACE] = 3, [KEY_RIGHTBRACE] = 3, [KEY_BACKSLASH] = 3,
+    [KEY_L] = 3, [KEY_SEMICOLON] = 3, [KEY_APOSTROPHE] = 3, [KEY_ENTER] = 3,
+    [KEY_DOT] = 3, [KEY_SLASH] = 3, [KEY_RIGHTSHIFT] = 3,
+    [KEY_RIGHTALT] = 3, [KEY_RIGHTMETA] = 3, [KEY_COMPOSE] = 3, [KEY_RIGHTCTRL] = 3,
+    [KEY_INSERT] = 3, [KEY_DELETE] = 3, [KEY_HOME] = 3, [KEY_END] = 3,
+    [KEY_PAGEUP] = 3, [KEY_PAGEDOWN] = 3,
+    [KEY_UP] = 3, [KEY_DOWN] = 3, [KEY_LEFT] = 3, [KEY_RIGHT] = 3,
+
+    [KEY_NUMLOCK] = 4, [KEY_KPSLASH] = 4, [KEY_KPASTERISK] = 4, [KEY_KPMINUS] = 4,
+    [KEY_KP7] = 4, [KEY_KP8] = 4, [KEY_KP9] = 4, [KEY_KPPLUS] = 4,
+    [KEY_KP4] = 4, [KEY_KP5] = 4, [KEY_KP6] = 4,
+    [KEY_KP1] = 4, [KEY_KP2] = 4, [KEY_KP3] = 4, [KEY_KPENTER] = 4,
+    [KEY_KP0] = 4, [KEY_KPDOT] = 4,
+};
+
+struct reactive_lighting {
+    /* configuration, written under lighting_lock */
+    bool enabled;
+    bool any_source;		/* react to every keyboard, e.g. uinput, not only i8042 */
+    u32 rgb;
+    unsigned int fade_ms;
+    /* protected by reactive_lighting_lock */
+    ktime_t pressed[4];
+    ktime_t last_run;
+    u64 events;
+    /* protected by lighting_lock */
+    u8 level[4];		/* fade level last written per zone */
+    u64 calls;
+    u64 failed;
+    ktime_t window_start;
+    unsigned int window_calls;
+    unsigned int calls_per_sec;
+    unsigned int max_calls_per_sec;
+};
+
+static DEFINE_SPINLOCK(reactive_lighting_lock);
+static struct reactive_lighting reactive_lighting = {
+    .rgb = 0xFFFFFF,
+    .fade_ms = 400,
+};
+
+static void reactive_lighting_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(reactive_lighting_work, reactive_lighting_work_fn);
+
+/* Mix the flash color into the zone color, level 0 is the zone color itself */
+static u64 reactive_lighting_blend(u64 base, u32 flash, unsigned int level)
+{
+    u64 rgb = 0;
+
+    for (int shift = 0; shift <= 16; shift += 8) {
+        int b = (base >> shift) & 0xFF;
+        int f = (flash >> shift) & 0xFF;
+
+        rgb |= (u64)(b + (f - b) * (int)level / REACTIVE_LIGHTING_STEPS) << shift;
+    }
+
+    return rgb;
+}
+
+/* Caller holds lighting_lock */
+static void reactive_lighting_count_call(struct reactive_lighting *rl, ktime_t now)
+{
+    s64 elapsed = ktime_ms_delta(now, rl->window_start);
+
+    if (elapsed >= MSEC_PER_SEC) {
+        rl->calls_per_sec = div_u64((u64)rl->window_calls * MSEC_PER_SEC, elapsed);
+        rl->max_calls_per_sec = max(rl->max_calls_per_sec, rl->calls_per_sec);
+        rl->window_start = now;
+        rl->window_calls = 0;
+    }
+    rl->window_calls++;
+    rl->calls++;
+}
+
+static void reactive_lighting_work_fn(struct work_struct *work)
+{
+    struct reactive_lighting *rl = &reactive_lighting;
+    u64 fade_ns = (u64)READ_ONCE(rl->fade_ms) * NSEC_PER_MSEC;
+    ktime_t pressed[4], now = ktime_get();
+    bool active = false;
+
+    spin_lock_irq(&reactive_lighting_lock);
+    memcpy(pressed, rl->pressed, sizeof(pressed));
+    rl->last_run = now;
+    spin_unlock_irq(&reactive_lighting_lock);
+
+    mutex_lock(&lighting_lock);
+    for (int i = 0; i < 4; i++) {
+        s64 left = fade_ns - ktime_to_ns(ktime_sub(now, pressed[i]));
+        unsigned int level = 0;
+        u64 rgb;
+
+        /* The zone colors only show in per-zone mode, nothing to restore otherwise */
+        if (!READ_ONCE(kb_state_valid) || !current_kb_state.per_zone) {
+            rl->level[i] = 0;
+            continue;
+        }
+
+        if (rl->enabled && left > 0)
+            level = div64_u64((u64)left * REACTIVE_LIGHTING_STEPS + fade_ns - 1, fade_ns);
+        if (level)
+            active = true;
+        if (level == rl->level[i])
+            continue;
+
+        rgb = reactive_lighting_blend(((u64 *)&current_kb_state.zones)[i], rl->rgb, level);
+        if (ACPI_FAILURE(set_zone_color(kb_zone_ids[i], rgb)))
+            rl->failed++;
+        reactive_lighting_count_call(rl, now);
+        rl->level[i] = level;
+    }
+    mutex_unlock(&lighting_lock);
+
+    if (active)
+        schedule_delayed_work(&reactive_lighting_work,
+                              msecs_to_jiffies(max(READ_ONCE(rl->fade_ms) / REACTIVE_LIGHTING_STEPS,
+                                                   REACTIVE_LIGHTING_MIN_INTERVAL_MS)));
+}
+
+/* Atomic context, from the input handler */
+static void reactive_lighting_key(struct input_dev *dev, unsigned int code)
+{
+    struct reactive_lighting *rl = &reactive_lighting;
+    unsigned long flags, delay = 0;
+    ktime_t now, next;
+    u8 zone;
+
+    if (!READ_ONCE(rl->enabled) || code >= ARRAY_SIZE(reactive_lighting_zones))
+        return;
+    if (!READ_ONCE(rl->any_source) && dev->id.bustype != BUS_I8042)
+        return;
+
+    zone = reactive_lighting_zones[code];
+    if (!zone)
+        return;
+
+    now = ktime_get();
+    spin_lock_irqsave(&reactive_lighting_lock, flags);
+    rl->pressed[zone - 1] = now;
+    rl->events++;
+    next = ktime_add_ms(rl->last_run, REACTIVE_LIGHTING_MIN_INTERVAL_MS);
+    spin_unlock_irqrestore(&reactive_lighting_lock, flags);
+
+    if (ktime_after(next, now))
+        delay = msecs_to_jiffies(ktime_ms_delta(next, now));
+    mod_delayed_work(system_wq, &reactive_lighting_work, delay);
+}
+
+/* Binds the lighting input handler while a consumer needs it, see below */
+static int lighting_input_update(void);
+
+static ssize_t reactive_lighting_enable_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%d\n", READ_ONCE(reactive_lighting.enabled));
+}
+
+static ssize_t reactive_lighting_enable_store(struct device *dev, struct device_attribute *attr,
+                                              const char *buf, size_t count)
+{
+    bool enable;
+    int err;
+
+    if (kstrtobool(buf, &enable))
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    WRITE_ONCE(reactive_lighting.enabled, enable);
+    mutex_unlock(&lighting_lock);
+
+    /* Let the work put back any zone that is still lit */
+    if (!enable)
+        mod_delayed_work(system_wq, &reactive_lighting_work, 0);
+
+    err = lighting_input_update();
+
+    return err ? err : count;
+}
+
+static ssize_t reactive_lighting_color_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%06x\n", READ_ONCE(reactive_lighting.rgb));
+}
+
+static ssize_t reactive_lighting_color_store(struct device *dev, struct device_attribute *attr,
+                                             const char *buf, size_t count)
+{
+    unsigned int rgb;
+
+    /* Accept: RRGGBB */
+    if (sscanf(buf, "%6x", &rgb) != 1)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    WRITE_ONCE(reactive_lighting.rgb, rgb);
+    mutex_unlock(&lighting_lock);
+
+    return count;
+}
+
+static ssize_t reactive_lighting_fade_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%u\n", READ_ONCE(reactive_lighting.fade_ms));
+}
+
+static ssize_t reactive_lighting_fade_store(struct device *dev, struct device_attribute *attr,
+                                            const char *buf, size_t count)
+{
+    unsigned int fade;
+
+    if (kstrtouint(buf, 10, &fade) || fade < 100 || fade > 5000)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    WRITE_ONCE(reactive_lighting.fade_ms, fade);
+    mutex_unlock(&lighting_lock);
+
+    return count;
+}
+
+static const char * const reactive_lighting_source_names[] = { "internal", "any" };
+
+static ssize_t reactive_lighting_source_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return sprintf(buf, "%s\n", reactive_lighting_source_names[READ_ONCE(reactive_lighting.any_source)]);
+}
+
+static ssize_t reactive_lighting_source_store(struct device *dev, struct device_attribute *attr,
+                                              const char *buf, size_t count)
+{
+    int source = sysfs_match_string(reactive_lighting_source_names, buf);
+
+    if (source < 0)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    WRITE_ONCE(reactive_lighting.any_source, source);
+    mutex_unlock(&lighting_lock);
+
+    return count;
+}
+
+static ssize_t reactive_lighting_stats_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct reactive_lighting *rl = &reactive_lighting;
+    unsigned int calls_per_sec;
+    u64 events, calls, failed;
+    unsigned int max_rate;
+
+    spin_lock_irq(&reactive_lighting_lock);
+    events = rl->events;
+    spin_unlock_irq(&reactive_lighting_lock);
+
+    mutex_lock(&lighting_lock);
+    calls = rl->calls;
+    failed = rl->failed;
+    max_rate = rl->max_calls_per_sec;
+    /* The rate is per completed second, a stale window means it went idle */
+    calls_per_sec = ktime_ms_delta(ktime_get(), rl->window_start) < 2 * MSEC_PER_SEC ?
+                    rl->calls_per_sec : 0;
+    mutex_unlock(&lighting_lock);
+
+    return sprintf(buf, "events=%llu\ncalls=%llu\nfailed=%llu\ncalls_per_sec=%u\nmax_calls_per_sec=%u\n",
+                   events, calls, failed, calls_per_sec, max_rate);
+}
+
+static struct device_attribute reactive_lighting_enable = __ATTR(enable, 0644, reactive_lighting_enable_show, reactive_lighting_enable_store);
+static struct device_attribute reactive_lighting_color = __ATTR(color, 0644, reactive_lighting_color_show, reactive_lighting_color_store);
+static struct device_attribute reactive_lighting_fade = __ATTR(fade_ms, 0644, reactive_lighting_fade_show, reactive_lighting_fade_store);
+static struct device_attribute reactive_lighting_source = __ATTR(source, 0644, reactive_lighting_source_show, reactive_lighting_source_store);
+static struct device_attribute reactive_lighting_stats = __ATTR(stats, 0444, reactive_lighting_stats_show, NULL);
+static struct attribute *reactive_lighting_attrs[] = {
+    &reactive_lighting_enable.attr,
+    &reactive_lighting_color.attr,
+    &reactive_lighting_fade.attr,
+    &reactive_lighting_source.attr,
+    &reactive_lighting_stats.attr,
+    NULL
+};
+static const struct attribute_group reactive_lighting_attr_group = {
+    .name = "reactive_lighting",
+    .attrs = reactive_lighting_attrs,
+};
+
+/*
+ * Idle lighting power-down
+ *
+ * Switches the keyboard and the back logo off after a period without input
+ * and puts the previous brightness back on the next input event. Activity
+ * comes from the lighting input handler, the timeout depends on whether the
+ * system runs on AC or on battery. Going idle and waking up cost at most one
+ * keyboard and one logo update each.
+ */
+struct lighting_idle {
+    /* seconds, 0 disables, written under lighting_lock */
+    unsigned int timeout_ac;
+    unsigned int timeout_battery;
+    /* jiffies of the last input event, written from atomic context */
+    unsigned long last_activity;
+    /* protected by lighting_lock */
+    bool idle;
+    bool kb_off;		/* keyboard switched off by the idle policy */
+    bool logo_off;		/* logo switched off by the idle policy */
+    u8 kb_brightness;		/* brightness to restore */
+    u8 logo_brightness;
+    u64 idle_count;
+    u64 wake_count;
+};
+
+static struct lighting_idle lighting_idle;
+
+static void lighting_idle_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(lighting_idle_work, lighting_idle_work_fn);
+static void lighting_idle_wake_fn(struct work_struct *work);
+static DECLARE_WORK(lighting_idle_wake_work, lighting_idle_wake_fn);
+
+static unsigned int lighting_idle_timeout(void)
+{
+    if (power_supply_is_system_supplied() > 0)
+        return READ_ONCE(lighting_idle.timeout_ac);
+    return READ_ONCE(lighting_idle.timeout_battery);
+}
+
+/* Re-evaluate the deadline, e.g. after a timeout or power source change */
+static void lighting_idle_kick(void)
+{
+    mod_delayed_work(system_wq, &lighting_idle_work, 0);
+}
+
+static void lighting_idle_work_fn(struct work_struct *work)
+{
+    struct lighting_idle *li = &lighting_idle;
+    unsigned int timeout = lighting_idle_timeout();
+    struct logo_state logo;
+    struct kb_state kb;
+    unsigned long deadline;
+
+    if (!timeout)
+        return;
+
+    deadline = READ_ONCE(li->last_activity) + timeout * HZ;
+    if (time_before(jiffies, deadline)) {
+        schedule_delayed_work(&lighting_idle_work, deadline - jiffies);
+        return;
+    }
+
+    mutex_lock(&lighting_lock);
+    if (li->idle)
+        goto out;
+
+    /* Go through the getters, the shadow state may be stale after a hotkey */
+    if (quirks->four_zone_kb && !kb_state_get(&kb)) {
+        li->kb_brightness = kb.per_zone ? kb.zones.brightness : kb.brightness;
+        li->kb_off = li->kb_brightness && ACPI_SUCCESS(__set_kb_brightness(0));
+    }
+
+    if (has_cap(ACER_CAP_BACK_LOGO) && !logo_state_get(&logo) && logo.enable) {
+        li->logo_brightness = logo.brightness;
+        li->logo_off = ACPI_SUCCESS(set_logo_status(0, 0, 0, logo.red, logo.green, logo.blue));
+    }
+
+    li->idle = true;
+    li->idle_count++;
+out:
+    mutex_unlock(&lighting_lock);
+}
+
+/* Put back what going idle switched off, without restarting the timer */
+static void __lighting_idle_wake(void)
+{
+    struct lighting_idle *li = &lighting_idle;
+    struct logo_state logo;
+    struct kb_state kb;
+
+    mutex_lock(&lighting_lock);
+    if (!li->idle)
+        goto out;
+
+    /* Only undo what is still off, a write while idle takes precedence */
+    if (li->kb_off && !kb_state_get(&kb) && !(kb.per_zone ? kb.zones.brightness : kb.brightness))
+        __set_kb_brightness(li->kb_brightness);
+
+    if (li->logo_off && !logo_state_get(&logo) && !logo.enable)
+        set_logo_status(1, li->logo_brightness, 0, logo.red, logo.green, logo.blue);
+
+    li->kb_off = false;
+    li->logo_off = false;
+    li->idle = false;
+    li->wake_count++;
+out:
+    mutex_unlock(&lighting_lock);
+}
+
+static void lighting_idle_wake_fn(struct work_struct *work)
+{
+    __lighting_idle_wake();
+    lighting_idle_kick();
+}
+
+/* Atomic context, from the input handler */
+static void lighting_idle_activity(void)
+{
+    WRITE_ONCE(lighting_idle.last_activity, jiffies);
+
+    if (READ_ONCE(lighting_idle.idle))
+        schedule_work(&lighting_idle_wake_work);
+}
+
+static ssize_t lighting_idle_timeout_show(unsigned int *timeout, char *buf)
+{
+    return sprintf(buf, "%u\n", READ_ONCE(*timeout));
+}
+
+static ssize_t lighting_idle_timeout_store(unsigned int *timeout, const char *buf, size_t count)
+{
+    unsigned int val;
+    int err;
+
+    /* 0 disables, up to one day */
+    if (kstrtouint(buf, 10, &val) || val > 86400)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    WRITE_ONCE(*timeout, val);
+    mutex_unlock(&lighting_lock);
+
+    /* With both timeouts off no input will wake the lighting, so do it now */
+    if (!READ_ONCE(lighting_idle.timeout_ac) && !READ_ONCE(lighting_idle.timeout_battery))
+        __lighting_idle_wake();
+
+    /* Count from now, not from the last key press */
+    WRITE_ONCE(lighting_idle.last_activity, jiffies);
+    lighting_idle_kick();
+
+    err = lighting_input_update();
+
+    return err ? err : count;
+}
+
+static ssize_t lighting_idle_ac_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return lighting_idle_timeout_show(&lighting_idle.timeout_ac, buf);
+}
+
+static ssize_t lighting_idle_ac_store(struct device *dev, struct device_attribute *attr,
+                                      const char *buf, size_t count)
+{
+    return lighting_idle_timeout_store(&lighting_idle.timeout_ac, buf, count);
+}
+
+static ssize_t lighting_idle_battery_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    return lighting_idle_timeout_show(&lighting_idle.timeout_battery, buf);
+}
+
+static ssize_t lighting_idle_battery_store(struct device *dev, struct device_attribute *attr,
+                                           const char *buf, size_t count)
+{
+    return lighting_idle_timeout_store(&lighting_idle.timeout_battery, buf, count);
+}
+
+static ssize_t lighting_idle_state_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct lighting_idle *li = &lighting_idle;
+    ssize_t len;
+
+    mutex_lock(&lighting_lock);
+    len = sprintf(buf, "state=%s\nidle_count=%llu\nwake_count=%llu\n",
+                  li->idle ? "idle" : "active", li->idle_count, li->wake_count);
+    mutex_unlock(&lighting_lock);
+
+    return len;
+}
+
+static struct device_attribute lighting_idle_ac = __ATTR(timeout_ac, 0644, lighting_idle_ac_show, lighting_idle_ac_store);
+static struct device_attribute lighting_idle_battery = __ATTR(timeout_battery, 0644, lighting_idle_battery_show, lighting_idle_battery_store);
+static struct device_attribute lighting_idle_state = __ATTR(state, 0444, lighting_idle_state_show, NULL);
+static struct attribute *lighting_idle_attrs[] = {
+    &lighting_idle_ac.attr,
+    &lighting_idle_battery.attr,
+    &lighting_idle_state.attr,
+    NULL
+};
+static const struct attribute_group lighting_idle_attr_group = {
+    .name = "lighting_idle",
+    .attrs = lighting_idle_attrs,
+};
+
+/*
+ * Lighting input handler
+ *
+ * Binds to keyboards, mice and touchpads; the consumers filter the events they
+ * care about. Runs in atomic context, so it never talks to the firmware itself.
+ * The handler is only registered while reactive lighting or an idle timeout
+ * is enabled, so key events cost nothing extra otherwise.
+ */
+static void lighting_input_event(struct input_handle *handle, unsigned int type,
+                                 unsigned int code, int value)
+{
+    if (type == EV_SYN || type == EV_MSC)
+        return;
+
+    /* Pointer motion and touches count as activity too */
+    lighting_idle_activity();
+
+    /* Presses only, no autorepeat or release */
+    if (type == EV_KEY && value == 1)
+        reactive_lighting_key(handle->dev, code);
+}
+
+static int lighting_input_connect(struct input_handler *handler, struct input_dev *dev,
+                                  const struct input_device_id *id)
+{
+    struct input_handle *handle;
+    int err;
+
+    handle = kzalloc(sizeof(*handle), GFP_KERNEL);
+    if (!handle)
+        return -ENOMEM;
+
+    handle->dev = dev;
+    handle->handler = handler;
+    handle->name = "nekro_sense";
+
+    err = input_register_handle(handle);
+    if (err)
+        goto err_free;
+
+    err = input_open_device(handle);
+    if (err)
+        goto err_unregister;
+
+    return 0;
+
+err_unregister:
+    input_unregister_handle(handle);
+err_free:
+    kfree(handle);
+    return err;
+}
+
+static void lighting_input_disconnect(struct input_handle *handle)
+{
+    input_close_device(handle);
+    input_unregister_handle(handle);
+    kfree(handle);
+}
+
+static const struct input_device_id lighting_input_ids[] = {
+    {
+        .flags = INPUT_DEVICE_ID_MATCH_EVBIT | INPUT_DEVICE_ID_MATCH_KEYBIT,
+        .evbit = { BIT_MASK(EV_KEY) },
+        .keybit = { [BIT_WORD(KEY_A)] = BIT_MASK(KEY_A) },
+    },
+    {	/* mice and pointing sticks */
+        .flags = INPUT_DEVICE_ID_MATCH_EVBIT | INPUT_DEVICE_ID_MATCH_RELBIT,
+        .evbit = { BIT_MASK(EV_REL) },
+        .relbit = { BIT_MASK(REL_X) },
+    },
+    {	/* touchpads and touchscreens, not accelerometers */
+        .flags = INPUT_DEVICE_ID_MATCH_EVBIT | INPUT_DEVICE_ID_MATCH_KEYBIT |
+                 INPUT_DEVICE_ID_MATCH_ABSBIT,
+        .evbit = { BIT_MASK(EV_KEY) | BIT_MASK(EV_ABS) },
+        .keybit = { [BIT_WORD(BTN_TOUCH)] = BIT_MASK(BTN_TOUCH) },
+        .absbit = { BIT_MASK(ABS_X) },
+    },
+    { }
+};
+
+static struct input_handler lighting_input_handler = {
+    .event = lighting_input_event,
+    .connect = lighting_input_connect,
+    .disconnect = lighting_input_disconnect,
+    .name = "nekro_sense",
+    .id_table = lighting_input_ids,
+};
+
+/* Protected by lighting_input_lock */
+static bool lighting_input_available;	/* set while the device is bound */
+static bool lighting_input_registered;
+static DEFINE_MUTEX(lighting_input_lock);
+
+static int lighting_input_update(void)
+{
+    bool wanted;
+    int err = 0;
+
+    mutex_lock(&lighting_input_lock);
+    wanted = lighting_input_available &&
+             (READ_ONCE(reactive_lighting.enabled) || READ_ONCE(lighting_idle.timeout_ac) ||
+              READ_ONCE(lighting_idle.timeout_battery));
+    if (wanted && !lighting_input_registered) {
+        err = input_register_handler(&lighting_input_handler);
+        if (err)
+            pr_warn("Could not register lighting input handler: %d\n", err);
+        else
+            lighting_input_registered = true;
+    } else if (!wanted && lighting_input_registered) {
+        input_unregister_handler(&lighting_input_handler);
+        lighting_input_registered = false;
+    }
+    mutex_unlock(&lighting_input_lock);
+
+    return err;
+}
+
+static void lighting_input_set_available(bool available)
+{
+    mutex_lock(&lighting_input_lock);
+    lighting_input_available = available;
+    mutex_unlock(&lighting_input_lock);
+
+    lighting_input_update();
+}
+
+/*
+ * LED class devices
+ *
+ * Each keyboard zone and the back logo is a multicolor LED, plus a plain
+ * kbd_backlight device for the global keyboard brightness. This lets LED
+ * triggers and UPower drive the lighting without going through the text
+ * attributes above. All writes go through the same firmware helpers.
+ */
+struct acer_rgb_led {
+    struct led_classdev_mc mc_cdev;
+    struct mc_subled subled[3];
+    int index; /* zone index 0-3, unused for the logo */
+};
+
+static struct acer_rgb_led kb_zone_leds[4];
+static struct acer_rgb_led back_logo_led;
+static struct led_classdev kbd_backlight_led;
+
+static u64 acer_rgb_led_color(struct acer_rgb_led *led, bool scaled)
+{
+    struct mc_subled *sub = led->subled;
+
+    if (scaled)
+        return ((u64)sub[0].brightness << 16) | ((u64)sub[1].brightness << 8) | sub[2].brightness;
+
+    return ((u64)sub[0].intensity << 16) | ((u64)sub[1].intensity << 8) | sub[2].intensity;
+}
+
+static int kb_zone_led_set(struct led_classdev *cdev, enum led_brightness brightness)
+{
+    struct led_classdev_mc *mc_cdev = lcdev_to_mccdev(cdev);
+    struct acer_rgb_led *led = container_of(mc_cdev, struct acer_rgb_led, mc_cdev);
+    acpi_status status;
+    u64 rgb;
+
+    /* Zones have no brightness of their own, so scale the color instead */
+    led_mc_calc_color_components(mc_cdev, brightness);
+    rgb = acer_rgb_led_color(led, true);
+
+    mutex_lock(&lighting_lock);
+    if (READ_ONCE(kb_state_valid) && current_kb_state.per_zone) {
+        /* Already static per-zone: a single method 6 write is enough */
+        status = set_zone_color(kb_zone_ids[led->index], rgb);
+        if (ACPI_SUCCESS(status))
+            ((u64 *)&current_kb_state.zones)[led->index] = rgb;
+    } else {
+        struct per_zone_color zones = current_kb_state.zones;
+
+        ((u64 *)&zones)[led->index] = rgb;
+        if (!zones.brightness)
+            zones.brightness = 100;
+        status = set_per_zone_color(&zones);
+    }
+    mutex_unlock(&lighting_lock);
+
+    return ACPI_FAILURE(status) ? -EIO : 0;
+}
+
+static int back_logo_led_set(struct led_classdev *cdev, enum led_brightness brightness)
+{
+    struct led_classdev_mc *mc_cdev = lcdev_to_mccdev(cdev);
+    struct acer_rgb_led *led = container_of(mc_cdev, struct acer_rgb_led, mc_cdev);
+    u64 rgb = acer_rgb_led_color(led, false);
+    acpi_status status;
+
+    /* The logo has a real brightness register (0-100), pass it through */
+    mutex_lock(&lighting_lock);
+    status = set_logo_status(brightness ? 1 : 0, brightness, 0,
+                             (rgb >> 16) & 0xFF, (rgb >> 8) & 0xFF, rgb & 0xFF);
+    mutex_unlock(&lighting_lock);
+
+    return ACPI_FAILURE(status) ? -EIO : 0;
+}
+
+static int kbd_backlight_led_set(struct led_classdev *cdev, enum led_brightness brightness)
+{
+    acpi_status status;
+
+    mutex_lock(&lighting_lock);
+    status = __set_kb_brightness(brightness);
+    mutex_unlock(&lighting_lock);
+
+    return ACPI_FAILURE(status) ? -EIO : 0;
+}
+
+static enum led_brightness kbd_backlight_led_get(struct led_classdev *cdev)
+{
+    enum led_brightness brightness;
+
+    mutex_lock(&lighting_lock);
+    brightness = current_kb_state.per_zone ? current_kb_state.zones.brightness
+                                           : current_kb_state.brightness;
+    mutex_unlock(&lighting_lock);
+
+    return brightness;
+}
+
+static void acer_rgb_led_setup(struct acer_rgb_led *led, const char *name,
+                               unsigned int max_brightness, u64 rgb, unsigned int brightness)
+{
+    const unsigned int color_ids[3] = { LED_COLOR_ID_RED, LED_COLOR_ID_GREEN, LED_COLOR_ID_BLUE };
+
+    for (int i = 0; i < 3; i++) {
+        led->subled[i].color_index = color_ids[i];
+        led->subled[i].channel = i;
+        led->subled[i].intensity = (rgb >> (16 - 8 * i)) & 0xFF;
+    }
+
+    led->mc_cdev.subled_info = led->subled;
+    led->mc_cdev.num_colors = 3;
+    led->mc_cdev.led_cdev.name = name;
+    led->mc_cdev.led_cdev.max_brightness = max_brightness;
+    led->mc_cdev.led_cdev.brightness = brightness;
+}
+
+static int acer_lighting_leds_init(struct device *dev)
+{
+    static const char * const zone_names[4] = {
+        "acer-wmi:rgb:kbd_zoned_backlight-1",
+        "acer-wmi:rgb:kbd_zoned_backlight-2",
+        "acer-wmi:rgb:kbd_zoned_backlight-3",
+        "acer-wmi:rgb:kbd_zoned_backlight-4",
+    };
+    int err;
+
+    if (quirks->four_zone_kb) {
+        for (int i = 0; i < 4; i++) {
+            struct acer_rgb_led *led = &kb_zone_leds[i];
+
+            acer_rgb_led_setup(led, zone_names[i], LED_FULL,
+                               ((u64 *)&current_kb_state.zones)[i],
+                               current_kb_state.per_zone ? LED_FULL : 0);
+            led->index = i;
+            led->mc_cdev.led_cdev.brightness_set_blocking = kb_zone_led_set;
+
+            err = devm_led_classdev_multicolor_register(dev, &led->mc_cdev);
+            if (err)
+                return err;
+        }
+
+        kbd_backlight_led.name = "acer-wmi::kbd_backlight";
+        kbd_backlight_led.max_brightness = 100;
+        kbd_backlight_led.brightness_set_blocking = kbd_backlight_led_set;
+        kbd_backlight_led.brightness_get = kbd_backlight_led_get;
+        kbd_backlight_led.flags = LED_CORE_SUSPENDRESUME;
+
+        err = devm_led_classdev_register(dev, &kbd_backlight_led);
+        if (err)
+            return err;
+    }
+
+    if (has_cap(ACER_CAP_BACK_LOGO)) {
+        /* Seed the shadow state so the LED starts from what the firmware has */
+        mutex_lock(&lighting_lock);
+        logo_state_refresh();
+        mutex_unlock(&lighting_lock);
+
+        acer_rgb_led_setup(&back_logo_led, "acer-wmi:rgb:back_logo", 100,
+                           ((u64)current_logo_state.red << 16) |
+                           ((u64)current_logo_state.green << 8) | current_logo_state.blue,
+                           current_logo_state.enable ? current_logo_state.brightness : 0);
+        back_logo_led.mc_cdev.led_cdev.brightness_set_blocking = back_logo_led_set;
+
+        err = devm_led_classdev_multicolor_register(dev, &back_logo_led.mc_cdev);
+        if (err)
+            return err;
+    }
+
+    return 0;
+}
+/*
+ * Streaming lighting frames
+ *
+ * /dev/nekro_sense_frames takes fixed-size binary frames. Writers never
+ * block: a frame replaces any frame that has not been applied yet (counted
+ * as dropped), and a worker applies the newest frame as fast as the embedded
+ * controller accepts calls, writing only what changed since the last frame.
+ */
+#define LIGHTING_FRAME_KB	BIT(0)
+#define LIGHTING_FRAME_LOGO	BIT(1)
+
+struct lighting_frame {
+    u8 zone[4][3];		/* R, G, B for zones 1-4 */
+    u8 kb_brightness;		/* 0-100 */
+    u8 logo[3];			/* R, G, B */
+    u8 logo_brightness;		/* 0-100 */
+    u8 logo_enable;		/* 0/1 */
+    u8 flags;			/* LIGHTING_FRAME_KB | LIGHTING_FRAME_LOGO */
+    u8 reserved;		/* must be 0 */
+} __packed;
+
+struct lighting_frame_stats {
+    u64 received;
+    u64 delivered;
+    u64 dropped;
+    u64 failed;
+    u64 last_latency_us;
+    u64 max_latency_us;
+    u64 total_latency_us;
+};
+
+static DEFINE_SPINLOCK(lighting_frame_lock);
+static struct lighting_frame pending_frame;
+static bool lighting_frame_pending;
+static struct lighting_frame_stats lighting_frame_stats;
+
+static void lighting_frame_work_fn(struct work_struct *work);
+static DECLARE_WORK(lighting_frame_work, lighting_frame_work_fn);
+
+static int lighting_frame_validate(const struct lighting_frame *frame)
+{
+    if (frame->reserved || (frame->flags & ~(LIGHTING_FRAME_KB | LIGHTING_FRAME_LOGO)))
+        return -EINVAL;
+
+    if (frame->kb_brightness > 100 || frame->logo_brightness > 100 || frame->logo_enable > 1)
+        return -EINVAL;
+
+    return 0;
+}
+
+/* Caller holds lighting_lock */
+static acpi_status lighting_frame_apply(const struct lighting_frame *frame)
+{
+    struct lighting_update u = {};
+
+    if (frame->flags & LIGHTING_FRAME_KB) {
+        u.flags |= LIGHTING_UPDATE_KB;
+        u.kb.per_zone = 1;
+        u.kb.zones.brightness = frame->kb_brightness;
+        for (int i = 0; i < 4; i++)
+            ((u64 *)&u.kb.zones)[i] = ((u64)frame->zone[i][0] << 16) |
+                                      ((u64)frame->zone[i][1] << 8) | frame->zone[i][2];
+    }
+
+    if (frame->flags & LIGHTING_FRAME_LOGO) {
+        u.flags |= LIGHTING_UPDATE_LOGO;
+        u.logo.red = frame->logo[0];
+        u.logo.green = frame->logo[1];
+        u.logo.blue = frame->logo[2];
+        u.logo.brightness = frame->logo_brightness;
+        u.logo.enable = frame->logo_enable;
+    }
+
+    return __lighting_update_apply(&u);
+}
+
+static void lighting_frame_work_fn(struct work_struct *work)
+{
+    struct lighting_frame frame;
+    acpi_status status;
+    ktime_t start;
+    u64 latency;
+
+    for (;;) {
+        spin_lock(&lighting_frame_lock);
+        if (!lighting_frame_pending) {
+            spin_unlock(&lighting_frame_lock);
+            return;
+        }
+        frame = pending_frame;
+        lighting_frame_pending = false;
+        spin_unlock(&lighting_frame_lock);
+
+        start = ktime_get();
+        mutex_lock(&lighting_lock);
+        status = lighting_frame_apply(&frame);
+        mutex_unlock(&lighting_lock);
+        latency = ktime_us_delta(ktime_get(), start);
+
+        spin_lock(&lighting_frame_lock);
+        if (ACPI_SUCCESS(status)) {
+            lighting_frame_stats.delivered++;
+            lighting_frame_stats.last_latency_us = latency;
+            lighting_frame_stats.total_latency_us += latency;
+            lighting_frame_stats.max_latency_us = max(lighting_frame_stats.max_latency_us, latency);
+        } else {
+            lighting_frame_stats.failed++;
+        }
+        spin_unlock(&lighting_frame_lock);
+    }
+}
+
+static ssize_t lighting_frame_write(struct file *file, const char __user *buf,
+                                    size_t count, loff_t *ppos)
+{
+    struct lighting_frame frame;
+
+    /* Several frames in one write are allowed, only the newest one matters */
+    if (!count || count % sizeof(frame))
+        return -EINVAL;
+
+    if (copy_from_user(&frame, buf + count - sizeof(frame), sizeof(frame)))
+        return -EFAULT;
+
+    if (lighting_frame_validate(&frame))
+        return -EINVAL;
+
+    spin_lock(&lighting_frame_lock);
+    lighting_frame_stats.received += count / sizeof(frame);
+    lighting_frame_stats.dropped += count / sizeof(frame) - 1;
+    if (lighting_frame_pending)
+        lighting_frame_stats.dropped++;
+    pending_frame = frame;
+    lighting_frame_pending = true;
+    spin_unlock(&lighting_frame_lock);
+
+    queue_work(system_long_wq, &lighting_frame_work);
+
+    return count;
+}
+
+static ssize_t stats_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    struct lighting_frame_stats st;
+
+    spin_lock(&lighting_frame_lock);
+    st = lighting_frame_stats;
+    spin_unlock(&lighting_frame_lock);
+
+    return sprintf(buf,
+                   "received=%llu\ndelivered=%llu\ndropped=%llu\nfailed=%llu\n"
+                   "latency_last_us=%llu\nlatency_avg_us=%llu\nlatency_max_us=%llu\n",
+                   st.received, st.delivered, st.dropped, st.failed,
+                   st.last_latency_us,
+                   st.delivered ? div64_u64(st.total_latency_us, st.delivered) : 0,
+                   st.max_latency_us);
+}
+static DEVICE_ATTR_RO(stats);
+
+static struct attribute *lighting_frame_attrs[] = {
+    &dev_attr_stats.attr,
+    NULL
+};
+static const struct attribute_group lighting_frame_attr_group = {
+    .attrs = lighting_frame_attrs,
+};
+static const struct attribute_group *lighting_frame_attr_groups[] = {
+    &lighting_frame_attr_group,
+    NULL
+};
+
+static const struct file_operations lighting_frame_fops = {
+    .owner = THIS_MODULE,
+    .open = nonseekable_open,
+    .write = lighting_frame_write,
+    .llseek = noop_llseek,
+};
+
+static struct miscdevice lighting_frame_dev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = "nekro_sense_frames",
+    .fops = &lighting_frame_fops,
+    .groups = lighting_frame_attr_groups,
+    .mode = 0660,
+};
+
+/*
+ * State snapshot
+ *
+ * One read of "state" returns everything the status tools poll, as key=value
+ * lines, from the driver's caches. The whole snapshot is taken under
+ * scenes_lock, which scenes, netlink SET and ioctl batches hold while they
+ * apply, so it never shows one of them half done. The profile, battery and
+ * settings caches are kept filled at probe, on resume and by the events that
+ * change them, so a read makes no firmware calls; only the lighting is
+ * re-read once after a hotkey or resume. Keys the machine does not support,
+ * or whose cache could not be filled, are left out.
+ */
+static const char *acer_thermal_profile_name(int tp)
+{
+    switch (tp) {
+    case ACER_PREDATOR_V4_THERMAL_PROFILE_ECO:
+        return "low-power";
+    case ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET:
+        return "quiet";
+    case ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED:
+        return "balanced";
+    case ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE:
+        return "balanced-performance";
+    case ACER_PREDATOR_V4_THERMAL_PROFILE_TURBO:
+        return "performance";
+    default:
+        return NULL;
+    }
+}
+
+#define ACER_SNAPSHOT_PROFILE		BIT(0)
+#define ACER_SNAPSHOT_FAN		BIT(1)
+#define ACER_SNAPSHOT_BATTERY		BIT(2)
+#define ACER_SNAPSHOT_KB		BIT(3)
+#define ACER_SNAPSHOT_LOGO		BIT(4)
+#define ACER_SNAPSHOT_SETTING(id)	BIT(8 + (id))
+
+/* Protects scenes[] and scene_active, and serializes scene switches and batches */
+static DEFINE_MUTEX(scenes_lock);
+
+struct acer_snapshot {
+    unsigned int valid;		/* ACER_SNAPSHOT_* for the fields filled in */
+    int thermal_profile;
+    int cpu_fan;
+    int gpu_fan;
+    u8 battery_limiter;
+    u8 battery_calibration;
+    int settings[ACER_SETTING_MAX];
+    struct kb_state kb;
+    struct logo_state logo;
+};
+
+static void acer_snapshot_take(struct acer_snapshot *snap)
+{
+    memset(snap, 0, sizeof(*snap));
+
+    mutex_lock(&scenes_lock);
+    if (has_cap(ACER_CAP_PLATFORM_PROFILE)) {
+        int tp = READ_ONCE(thermal_profile_cached);
+
+        if (acer_thermal_profile_name(tp)) {
+            snap->thermal_profile = tp;
+            snap->valid |= ACER_SNAPSHOT_PROFILE;
+        }
+    }
+
+    if (has_cap(ACER_CAP_PREDATOR_SENSE)) {
+        snap->cpu_fan = READ_ONCE(cpu_fan_speed);
+        snap->gpu_fan = READ_ONCE(gpu_fan_speed);
+        snap->valid |= ACER_SNAPSHOT_FAN;
+
+        /* Any cached status will do, whatever its age */
+        mutex_lock(&battery_health_lock);
+        if (battery_health_cache.valid) {
+            snap->battery_limiter = battery_health_cache.status[0];
+            snap->battery_calibration = battery_health_cache.status[1];
+            snap->valid |= ACER_SNAPSHOT_BATTERY;
+        }
+        mutex_unlock(&battery_health_lock);
+
+        mutex_lock(&acer_settings_lock);
+        for (int i = 0; i < ACER_SETTING_MAX; i++) {
+            if (!acer_settings[i].valid)
+                continue;
+            snap->settings[i] = acer_settings[i].cached;
+            snap->valid |= ACER_SNAPSHOT_SETTING(i);
+        }
+        mutex_unlock(&acer_settings_lock);
+    }
+
+    if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+        mutex_lock(&lighting_lock);
+        if (quirks->four_zone_kb && !kb_state_get(&snap->kb))
+            snap->valid |= ACER_SNAPSHOT_KB;
+        if (has_cap(ACER_CAP_BACK_LOGO) && !logo_state_get(&snap->logo))
+            snap->valid |= ACER_SNAPSHOT_LOGO;
+        mutex_unlock(&lighting_lock);
+    }
+    mutex_unlock(&scenes_lock);
+}
+
+static ssize_t acer_state_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    const struct kb_state *kb;
+    struct acer_snapshot snap;
+    ssize_t len = 0;
+
+    acer_snapshot_take(&snap);
+    kb = &snap.kb;
+
+    if (snap.valid & ACER_SNAPSHOT_PROFILE)
+        len += sysfs_emit_at(buf, len, "profile=%s\n",
+                             acer_thermal_profile_name(snap.thermal_profile));
+    if (snap.valid & ACER_SNAPSHOT_FAN)
+        len += sysfs_emit_at(buf, len, "fan_speed=%d,%d\n", snap.cpu_fan, snap.gpu_fan);
+    if (snap.valid & ACER_SNAPSHOT_BATTERY)
+        len += sysfs_emit_at(buf, len, "battery_limiter=%d\nbattery_calibration=%d\n",
+                             snap.battery_limiter, snap.battery_calibration);
+    for (int i = 0; i < ACER_SETTING_MAX; i++) {
+        if (snap.valid & ACER_SNAPSHOT_SETTING(i))
+            len += sysfs_emit_at(buf, len, "%s=%d\n", acer_settings[i].name, snap.settings[i]);
+    }
+    if (snap.valid & ACER_SNAPSHOT_KB) {
+        len += sysfs_emit_at(buf, len, "kb_per_zone=%d\n", kb->per_zone);
+        len += sysfs_emit_at(buf, len, "four_zone_mode=%d,%d,%d,%d,%d,%d,%d\n",
+                             kb->mode, kb->speed, kb->brightness, kb->direction,
+                             kb->red, kb->green, kb->blue);
+        len += sysfs_emit_at(buf, len, "per_zone_mode=%06llx,%06llx,%06llx,%06llx,%d\n",
+                             kb->zones.zone1, kb->zones.zone2, kb->zones.zone3,
+                             kb->zones.zone4, kb->zones.brightness);
+    }
+    if (snap.valid & ACER_SNAPSHOT_LOGO)
+        len += sysfs_emit_at(buf, len, "back_logo=%02x%02x%02x,%d,%d\n", snap.logo.red,
+                             snap.logo.green, snap.logo.blue, snap.logo.brightness,
+                             snap.logo.enable);
+
+    return len;
+}
+
+static struct device_attribute acer_state = __ATTR(state, 0444, acer_state_show, NULL);
+
+static struct attribute *acer_state_attrs[] = {
+    &acer_state.attr,
+    NULL
+};
+
+static struct attribute_group acer_state_attr_group = {
+    .attrs = acer_state_attrs,
+};
+
+/*
+ * Scenes
+ *
+ * A scene is a named bundle of platform profile, fan targets, lighting and
+ * battery limiter. "define" stores one, and a write of its name to "apply"
+ * applies it in one ordered batch. The profile goes first, because quiet and
+ * low-power reset the fans. Then come the fans, the lighting as a single
+ * lighting update, and the limiter last. A part that already matches the
+ * driver's cached state is skipped, so switching between similar scenes only
+ * costs the firmware calls for what actually differs.
+ */
+#define SCENE_MAX		8
+#define SCENE_NAME_LEN		16
+
+#define SCENE_PROFILE		BIT(0)
+#define SCENE_FAN		BIT(1)
+#define SCENE_BATTERY		BIT(2)
+
+static const struct {
+    const char *name;
+    enum platform_profile_option option;
+} scene_profiles[] = {
+    { "low-power", PLATFORM_PROFILE_LOW_POWER },
+    { "quiet", PLATFORM_PROFILE_QUIET },
+    { "balanced", PLATFORM_PROFILE_BALANCED },
+    { "balanced-performance", PLATFORM_PROFILE_BALANCED_PERFORMANCE },
+    { "performance", PLATFORM_PROFILE_PERFORMANCE },
+};
+
+struct scene {
+    char name[SCENE_NAME_LEN];	/* empty for a free slot */
+    unsigned int flags;
+    unsigned int profile;	/* index into scene_profiles */
+    int cpu_fan;
+    int gpu_fan;
+    u8 battery_limiter;
+    struct lighting_update lighting;
+};
+
+static struct scene scenes[SCENE_MAX];
+static char scene_active[SCENE_NAME_LEN];
+
+/* Caller holds scenes_lock */
+static struct scene *scene_find(const char *name)
+{
+    for (int i = 0; i < SCENE_MAX; i++) {
+        if (scenes[i].name[0] && !strcmp(scenes[i].name, name))
+            return &scenes[i];
+    }
+    return NULL;
+}
+
+static int scene_parse_name(const char *s)
+{
+    size_t len = strlen(s);
+
+    if (!len || len >= SCENE_NAME_LEN)
+        return -EINVAL;
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum(s[i]) && s[i] != '-' && s[i] != '_')
+            return -EINVAL;
+    }
+    return 0;
+}
+
+/* Caller holds scenes_lock */
+static int scene_apply(const struct scene *sc)
+{
+    int ret;
+
+    if (sc->flags & SCENE_PROFILE) {
+        const char *active;
+        bool changed = false;
+
+        /*
+         * The platform_profile core only locks its own sysfs writes, so
+         * take the driver's profile lock to keep a concurrent
+         * platform_profile or mode key change from interleaving.
+         */
+        mutex_lock(&acer_profile_lock);
+        active = acer_thermal_profile_name(READ_ONCE(thermal_profile_cached));
+        ret = 0;
+        if (!active || strcmp(active, scene_profiles[sc->profile].name)) {
+            ret = __acer_predator_v4_platform_profile_set(scene_profiles[sc->profile].option);
+            changed = !ret;
+        }
+        mutex_unlock(&acer_profile_lock);
+        if (ret)
+            return ret;
+        if (changed)
+            platform_profile_notify(platform_profile_device);
+    }
+
+    if ((sc->flags & SCENE_FAN) &&
+        (READ_ONCE(cpu_fan_speed) != sc->cpu_fan || READ_ONCE(gpu_fan_speed) != sc->gpu_fan)) {
+        if (ACPI_FAILURE(acer_set_fan_speed(sc->cpu_fan, sc->gpu_fan)))
+            return -EIO;
+    }
+
+    if (sc->lighting.flags) {
+        ret = lighting_update_apply(&sc->lighting);
+        if (ret)
+            return ret;
+    }
+
+    if (sc->flags & SCENE_BATTERY) {
+        int enabled;
+
+        if (ACPI_FAILURE(battery_health_query(HEALTH_MODE, &enabled)) ||
+            enabled != sc->battery_limiter) {
+            if (battery_health_set(HEALTH_MODE, sc->battery_limiter) != AE_OK)
+                return -ENODEV;
+        }
+    }
+
+    return 0;
+}
+
+/* Parses "profile=... fan=C,G kb=... kb_mode=... logo=... battery_limiter=N" */
+static int scene_parse_items(char *p, struct scene *sc)
+{
+    u8 cpu = 0, gpu = 0;
+    char *tok;
+    int ret;
+
+    while ((tok = strsep(&p, " \n"))) {
+        if (!*tok)
+            continue;
+
+        if (str_has_prefix(tok, "profile=") && !(sc->flags & SCENE_PROFILE)) {
+            ret = -EINVAL;
+            for (unsigned int i = 0; i < ARRAY_SIZE(scene_profiles); i++) {
+                if (!strcmp(tok + 8, scene_profiles[i].name)) {
+                    sc->profile = i;
+                    ret = 0;
+                }
+            }
+            if (!ret && !has_cap(ACER_CAP_PLATFORM_PROFILE))
+                ret = -EOPNOTSUPP;
+            sc->flags |= SCENE_PROFILE;
+        } else if (str_has_prefix(tok, "fan=") && !(sc->flags & SCENE_FAN)) {
+            ret = fan_speed_parse(tok + 4, &cpu, &gpu);
+            if (!ret && !has_cap(ACER_CAP_PREDATOR_SENSE))
+                ret = -EOPNOTSUPP;
+            sc->cpu_fan = cpu;
+            sc->gpu_fan = gpu;
+            sc->flags |= SCENE_FAN;
+        } else if (str_has_prefix(tok, "battery_limiter=") && !(sc->flags & SCENE_BATTERY)) {
+            ret = (kstrtou8(tok + 16, 10, &sc->battery_limiter) || sc->battery_limiter > 1) ?
+                  -EINVAL : 0;
+            if (!ret && !has_cap(ACER_CAP_PREDATOR_SENSE))
+                ret = -EOPNOTSUPP;
+            sc->flags |= SCENE_BATTERY;
+        } else if (str_has_prefix(tok, "kb=") && !(sc->lighting.flags & LIGHTING_UPDATE_KB)) {
+            ret = lighting_parse_zones(tok + 3, &sc->lighting.kb);
+            if (!ret && !quirks->four_zone_kb)
+                ret = -EOPNOTSUPP;
+            sc->lighting.flags |= LIGHTING_UPDATE_KB;
+        } else if (str_has_prefix(tok, "kb_mode=") && !(sc->lighting.flags & LIGHTING_UPDATE_KB)) {
+            ret = lighting_parse_effect(tok + 8, &sc->lighting.kb);
+            if (!ret && !quirks->four_zone_kb)
+                ret = -EOPNOTSUPP;
+            sc->lighting.flags |= LIGHTING_UPDATE_KB;
+        } else if (str_has_prefix(tok, "logo=") && !(sc->lighting.flags & LIGHTING_UPDATE_LOGO)) {
+            ret = lighting_parse_logo(tok + 5, &sc->lighting.logo);
+            if (!ret && !has_cap(ACER_CAP_BACK_LOGO))
+                ret = -EOPNOTSUPP;
+            sc->lighting.flags |= LIGHTING_UPDATE_LOGO;
+        } else {
+            ret = -EINVAL;
+        }
+        if (ret) {
+            pr_err("Invalid scene item: %s\n", tok);
+            return ret;
+        }
+    }
+
+    return (sc->flags || sc->lighting.flags) ? 0 : -EINVAL;
+}
+
+/* Same syntax as "define", so a listed scene can be written back as is */
+static int scene_format(const struct scene *sc, char *buf, int len)
+{
+    const struct kb_state *kb = &sc->lighting.kb;
+    const struct logo_state *logo = &sc->lighting.logo;
+
+    len += sysfs_emit_at(buf, len, "%s", sc->name);
+    if (sc->flags & SCENE_PROFILE)
+        len += sysfs_emit_at(buf, len, " profile=%s", scene_profiles[sc->profile].name);
+    if (sc->flags & SCENE_FAN)
+        len += sysfs_emit_at(buf, len, " fan=%d,%d", sc->cpu_fan, sc->gpu_fan);
+    if ((sc->lighting.flags & LIGHTING_UPDATE_KB) && kb->per_zone)
+        len += sysfs_emit_at(buf, len, " kb=%06llx,%06llx,%06llx,%06llx,%d",
+                             kb->zones.zone1, kb->zones.zone2, kb->zones.zone3,
+                             kb->zones.zone4, kb->zones.brightness);
+    else if (sc->lighting.flags & LIGHTING_UPDATE_KB)
+        len += sysfs_emit_at(buf, len, " kb_mode=%d,%d,%d,%d,%d,%d,%d", kb->mode, kb->speed,
+                             kb->brightness, kb->direction, kb->red, kb->green, kb->blue);
+    if (sc->lighting.flags & LIGHTING_UPDATE_LOGO)
+        len += sysfs_emit_at(buf, len, " logo=%02x%02x%02x,%d,%d", logo->red, logo->green,
+                             logo->blue, logo->brightness, logo->enable);
+    if (sc->flags & SCENE_BATTERY)
+        len += sysfs_emit_at(buf, len, " battery_limiter=%d", sc->battery_limiter);
+    len += sysfs_emit_at(buf, len, "\n");
+
+    return len;
+}
+
+static ssize_t scene_list_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    int len = 0;
+
+    mutex_lock(&scenes_lock);
+    for (int i = 0; i < SCENE_MAX; i++) {
+        if (scenes[i].name[0])
+            len = scene_format(&scenes[i], buf, len);
+    }
+    mutex_unlock(&scenes_lock);
+
+    return len;
+}
+
+/* NAME item... ; replaces a scene of the same name */
+static ssize_t scene_define_store(struct device *dev, struct device_attribute *attr,
+                                  const char *buf, size_t count)
+{
+    struct scene sc = {}, *slot;
+    char tmp[192], *p = tmp, *name;
+    int ret;
+
+    if (count >= sizeof(tmp))
+        return -EINVAL;
+    memcpy(tmp, buf, count);
+    tmp[count] = '\0';
+
+    name = strsep(&p, " \n");
+    if (scene_parse_name(name) || !p)
+        return -EINVAL;
+    strscpy(sc.name, name, sizeof(sc.name));
+
+    ret = scene_parse_items(p, &sc);
+    if (ret)
+        return ret;
+
+    mutex_lock(&scenes_lock);
+    slot = scene_find(sc.name);
+    for (int i = 0; !slot && i < SCENE_MAX; i++) {
+        if (!scenes[i].name[0])
+            slot = &scenes[i];
+    }
+    if (slot)
+        *slot = sc;
+    mutex_unlock(&scenes_lock);
+
+    return slot ? count : -ENOSPC;
+}
+
+static ssize_t scene_remove_store(struct device *dev, struct device_attribute *attr,
+                                  const char *buf, size_t count)
+{
+    char name[SCENE_NAME_LEN];
+    struct scene *sc;
+
+    if (count > sizeof(name) || sscanf(buf, "%15s", name) != 1)
+        return -EINVAL;
+
+    mutex_lock(&scenes_lock);
+    sc = scene_find(name);
+    if (sc) {
+        memset(sc, 0, sizeof(*sc));
+        if (!strcmp(scene_active, name))
+            scene_active[0] = '\0';
+    }
+    mutex_unlock(&scenes_lock);
+
+    return sc ? count : -ENOENT;
+}
+
+static ssize_t scene_apply_show(struct device *dev, struct device_attribute *attr, char *buf)
+{
+    ssize_t len;
+
+    mutex_lock(&scenes_lock);
+    len = sprintf(buf, "%s\n", scene_active);
+    mutex_unlock(&scenes_lock);
+
+    return len;
+}
+
+static ssize_t scene_apply_store(struct device *dev, struct device_attribute *attr,
+                                 const char *buf, size_t count)
+{
+    char name[SCENE_NAME_LEN];
+    struct scene *sc;
+    int ret;
+
+    if (count > sizeof(name) || sscanf(buf, "%15s", name) != 1)
+        return -EINVAL;
+
+    mutex_lock(&scenes_lock);
+    sc = scene_find(name);
+    if (!sc) {
+        ret = -ENOENT;
+    } else {
+        ret = scene_apply(sc);
+        /* A partly applied scene is not the active one */
+        if (ret) {
+            pr_err("Failed to apply scene %s: %d\n", name, ret);
+            scene_active[0] = '\0';
+        } else {
+            strscpy(scene_active, name, sizeof(scene_active));
+        }
+    }
+    mutex_unlock(&scenes_lock);
+
+    return ret ? ret : count;
+}
+
+static struct device_attribute scene_define = __ATTR(define, 0200, NULL, scene_define_store);
+static struct device_attribute scene_apply_attr = __ATTR(apply, 0644, scene_apply_show, scene_apply_store);
+static struct device_attribute scene_remove = __ATTR(remove, 0200, NULL, scene_remove_store);
+static struct device_attribute scene_list = __ATTR(list, 0444, scene_list_show, NULL);
+static struct attribute *scenes_attrs[] = {
+    &scene_define.attr,
+    &scene_apply_attr.attr,
+    &scene_remove.attr,
+    &scene_list.attr,
+    NULL
+};
+static const struct attribute_group scenes_attr_group = {
+    .name = "scenes",
+    .attrs = scenes_attrs,
+};
+
+/*
+ * Generic netlink
+ *
+ * Family "nekro_sense" gives daemons the same controls as sysfs as typed
+ * attributes. NEKRO_CMD_GET replies with the state snapshot. NEKRO_CMD_SET
+ * takes any mix of control attributes and applies them in one round trip,
+ * in the scene order (profile, fans, lighting, limiter) plus the firmware
+ * settings (USB charging, LCD override, backlight timeout, boot sound).
+ * The whole request is validated before anything is written. The "events"
+ * multicast group carries the WMI events and temperature threshold alerts.
+ * The commands, attributes and payloads are in nekro_sense.h.
+ */
+static_assert(sizeof(struct nekro_genl_kb_zones) == 13);
+static_assert(sizeof(struct nekro_genl_kb_effect) == 7);
+static_assert(sizeof(struct nekro_genl_logo) == 5);
+
+#define NEKRO_GENL_ALERT_INTERVAL_MS	2000
+#define NEKRO_GENL_ALERT_HYSTERESIS	2
+
+static const struct nla_policy nekro_genl_policy[NEKRO_ATTR_MAX + 1] = {
+    [NEKRO_ATTR_PROFILE] = NLA_POLICY_MAX(NLA_U8, ARRAY_SIZE(scene_profiles) - 1),
+    [NEKRO_ATTR_FAN_CPU] = NLA_POLICY_MAX(NLA_U8, 100),
+    [NEKRO_ATTR_FAN_GPU] = NLA_POLICY_MAX(NLA_U8, 100),
+    [NEKRO_ATTR_KB_ZONES] = NLA_POLICY_EXACT_LEN(sizeof(struct nekro_genl_kb_zones)),
+    [NEKRO_ATTR_KB_EFFECT] = NLA_POLICY_EXACT_LEN(sizeof(struct nekro_genl_kb_effect)),
+    [NEKRO_ATTR_LOGO] = NLA_POLICY_EXACT_LEN(sizeof(struct nekro_genl_logo)),
+    [NEKRO_ATTR_BATTERY_LIMITER] = NLA_POLICY_MAX(NLA_U8, 1),
+    [NEKRO_ATTR_USB_CHARGING] = NLA_POLICY_MAX(NLA_U8, 30),
+    [NEKRO_ATTR_TEMP_ALERT] = NLA_POLICY_MAX(NLA_U8, 120),
+    [NEKRO_ATTR_LCD_OVERRIDE] = NLA_POLICY_MAX(NLA_U8, 1),
+    [NEKRO_ATTR_BACKLIGHT_TIMEOUT] = NLA_POLICY_MAX(NLA_U8, 1),
+    [NEKRO_ATTR_BOOT_ANIMATION_SOUND] = NLA_POLICY_MAX(NLA_U8, 1),
+};
+
+static struct genl_family nekro_genl_family;
+static bool nekro_genl_registered;
+
+/* Alert state, only touched by nekro_genl_alert_work */
+static u8 nekro_genl_alert_threshold;
+static bool nekro_genl_alert_above[2];
+
+static void nekro_genl_alert_work_fn(struct work_struct *work);
+static DECLARE_DELAYED_WORK(nekro_genl_alert_work, nekro_genl_alert_work_fn);
+
+/* The attribute carrying each acer_settings[] entry */
+static const u8 nekro_genl_setting_attr[ACER_SETTING_MAX] = {
+    [ACER_SETTING_USB_CHARGING] = NEKRO_ATTR_USB_CHARGING,
+    [ACER_SETTING_LCD_OVERRIDE] = NEKRO_ATTR_LCD_OVERRIDE,
+    [ACER_SETTING_BACKLIGHT_TIMEOUT] = NEKRO_ATTR_BACKLIGHT_TIMEOUT,
+    [ACER_SETTING_BOOT_ANIMATION_SOUND] = NEKRO_ATTR_BOOT_ANIMATION_SOUND,
+};
+
+static int scene_profile_index(int tp)
+{
+    const char *name = acer_thermal_profile_name(tp);
+
+    for (int i = 0; name && i < ARRAY_SIZE(scene_profiles); i++) {
+        if (!strcmp(scene_profiles[i].name, name))
+            return i;
+    }
+    return -1;
+}
+
+static int nekro_genl_put_snapshot(struct sk_buff *msg, const struct acer_snapshot *snap)
+{
+    if ((snap->valid & ACER_SNAPSHOT_PROFILE) &&
+        nla_put_u8(msg, NEKRO_ATTR_PROFILE, scene_profile_index(snap->thermal_profile)))
+        return -EMSGSIZE;
+
+    if ((snap->valid & ACER_SNAPSHOT_FAN) &&
+        (nla_put_u8(msg, NEKRO_ATTR_FAN_CPU, snap->cpu_fan) ||
+         nla_put_u8(msg, NEKRO_ATTR_FAN_GPU, snap->gpu_fan)))
+        return -EMSGSIZE;
+
+    if ((snap->valid & ACER_SNAPSHOT_BATTERY) &&
+        (nla_put_u8(msg, NEKRO_ATTR_BATTERY_LIMITER, snap->battery_limiter) ||
+         nla_put_u8(msg, NEKRO_ATTR_BATTERY_CALIBRATION, snap->battery_calibration)))
+        return -EMSGSIZE;
+
+    for (int i = 0; i < ACER_SETTING_MAX; i++) {
+        if ((snap->valid & ACER_SNAPSHOT_SETTING(i)) &&
+            nla_put_u8(msg, nekro_genl_setting_attr[i], snap->settings[i]))
+            return -EMSGSIZE;
+    }
+
+    if ((snap->valid & ACER_SNAPSHOT_KB) && snap->kb.per_zone) {
+        const u64 *zones = (const u64 *)&snap->kb.zones;
+        struct nekro_genl_kb_zones kz = { .brightness = snap->kb.zones.brightness };
+
+        for (int i = 0; i < 4; i++) {
+            kz.zone[i][0] = (zones[i] >> 16) & 0xFF;
+            kz.zone[i][1] = (zones[i] >> 8) & 0xFF;
+            kz.zone[i][2] = zones[i] & 0xFF;
+        }
+        if (nla_put(msg, NEKRO_ATTR_KB_ZONES, sizeof(kz), &kz))
+            return -EMSGSIZE;
+    } else if (snap->valid & ACER_SNAPSHOT_KB) {
+        struct nekro_genl_kb_effect ke = {
+            .mode = snap->kb.mode, .speed = snap->kb.speed,
+            .brightness = snap->kb.brightness, .direction = snap->kb.direction,
+            .red = snap->kb.red, .green = snap->kb.green, .blue = snap->kb.blue,
+        };
+
+        if (nla_put(msg, NEKRO_ATTR_KB_EFFECT, sizeof(ke), &ke))
+            return -EMSGSIZE;
+    }
+
+    if (snap->valid & ACER_SNAPSHOT_LOGO) {
+        struct nekro_genl_logo lg = {
+            .red = snap->logo.red, .green = snap->logo.green, .blue = snap->logo.blue,
+            .brightness = snap->logo.brightness, .enable = snap->logo.enable,
+        };
+
+        if (nla_put(msg, NEKRO_ATTR_LOGO, sizeof(lg), &lg))
+            return -EMSGSIZE;
+    }
+
+    return 0;
+}
+
+static int nekro_genl_get(struct sk_buff *skb, struct genl_info *info)
+{
+    struct acer_snapshot snap;
+    struct sk_buff *msg;
+    void *hdr;
+
+    acer_snapshot_take(&snap);
+
+    msg = genlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    if (!msg)
+        return -ENOMEM;
+
+    hdr = genlmsg_put_reply(msg, info, &nekro_genl_family, 0, NEKRO_CMD_GET);
+    if (!hdr)
+        goto nla_failure;
+    if (nekro_genl_put_snapshot(msg, &snap) ||
+        nla_put_u8(msg, NEKRO_ATTR_TEMP_ALERT, READ_ONCE(nekro_genl_alert_threshold)))
+        goto nla_failure;
+    genlmsg_end(msg, hdr);
+
+    return genlmsg_reply(msg, info);
+
+nla_failure:
+    nlmsg_free(msg);
+    return -EMSGSIZE;
+}
+
+/* Builds an unnamed scene from the request, so SET goes through scene_apply */
+static int nekro_genl_parse_set(struct genl_info *info, struct scene *sc)
+{
+    struct nlattr **attrs = info->attrs;
+
+    if (attrs[NEKRO_ATTR_PROFILE]) {
+        if (!has_cap(ACER_CAP_PLATFORM_PROFILE))
+            return -EOPNOTSUPP;
+        sc->profile = nla_get_u8(attrs[NEKRO_ATTR_PROFILE]);
+        sc->flags |= SCENE_PROFILE;
+    }
+
+    if (attrs[NEKRO_ATTR_FAN_CPU] || attrs[NEKRO_ATTR_FAN_GPU]) {
+        if (!attrs[NEKRO_ATTR_FAN_CPU] || !attrs[NEKRO_ATTR_FAN_GPU]) {
+            GENL_SET_ERR_MSG(info, "CPU and GPU fan targets are set together");
+            return -EINVAL;
+        }
+        if (!has_cap(ACER_CAP_PREDATOR_SENSE))
+            return -EOPNOTSUPP;
+        sc->cpu_fan = nla_get_u8(attrs[NEKRO_ATTR_FAN_CPU]);
+        sc->gpu_fan = nla_get_u8(attrs[NEKRO_ATTR_FAN_GPU]);
+        sc->flags |= SCENE_FAN;
+    }
+
+    if (attrs[NEKRO_ATTR_KB_ZONES] && attrs[NEKRO_ATTR_KB_EFFECT]) {
+        GENL_SET_ERR_MSG(info, "Keyboard zones and effect are exclusive");
+        return -EINVAL;
+    }
+    if (attrs[NEKRO_ATTR_KB_ZONES]) {
+        const struct nekro_genl_kb_zones *kz = nla_data(attrs[NEKRO_ATTR_KB_ZONES]);
+        u64 *zones = (u64 *)&sc->lighting.kb.zones;
+
+        if (!quirks->four_zone_kb)
+            return -EOPNOTSUPP;
+        if (kz->brightness > 100) {
+            NL_SET_ERR_MSG_ATTR(info->extack, attrs[NEKRO_ATTR_KB_ZONES], "Brightness above 100");
+            return -EINVAL;
+        }
+        for (int i = 0; i < 4; i++)
+            zones[i] = ((u64)kz->zone[i][0] << 16) | ((u64)kz->zone[i][1] << 8) | kz->zone[i][2];
+        sc->lighting.kb.zones.brightness = kz->brightness;
+        sc->lighting.kb.per_zone = 1;
+        sc->lighting.flags |= LIGHTING_UPDATE_KB;
+    }
+    if (attrs[NEKRO_ATTR_KB_EFFECT]) {
+        const struct nekro_genl_kb_effect *ke = nla_data(attrs[NEKRO_ATTR_KB_EFFECT]);
+        struct kb_state *kb = &sc->lighting.kb;
+
+        if (!quirks->four_zone_kb)
+            return -EOPNOTSUPP;
+        kb->mode = ke->mode;
+        kb->speed = ke->speed;
+        kb->brightness = ke->brightness;
+        kb->direction = ke->direction;
+        kb->red = ke->red;
+        kb->green = ke->green;
+        kb->blue = ke->blue;
+        if (lighting_check_effect(kb)) {
+            NL_SET_ERR_MSG_ATTR(info->extack, attrs[NEKRO_ATTR_KB_EFFECT], "Invalid effect");
+            return -EINVAL;
+        }
+        sc->lighting.flags |= LIGHTING_UPDATE_KB;
+    }
+
+    if (attrs[NEKRO_ATTR_LOGO]) {
+        const struct nekro_genl_logo *lg = nla_data(attrs[NEKRO_ATTR_LOGO]);
+
+        if (!has_cap(ACER_CAP_BACK_LOGO))
+            return -EOPNOTSUPP;
+        if (lg->brightness > 100 || lg->enable > 1) {
+            NL_SET_ERR_MSG_ATTR(info->extack, attrs[NEKRO_ATTR_LOGO], "Invalid logo state");
+            return -EINVAL;
+        }
+        sc->lighting.logo.red = lg->red;
+        sc->lighting.logo.green = lg->green;
+        sc->lighting.logo.blue = lg->blue;
+        sc->lighting.logo.brightness = lg->brightness;
+        sc->lighting.logo.enable = lg->enable;
+        sc->lighting.flags |= LIGHTING_UPDATE_LOGO;
+    }
+
+    if (attrs[NEKRO_ATTR_BATTERY_LIMITER]) {
+        if (!has_cap(ACER_CAP_PREDATOR_SENSE))
+            return -EOPNOTSUPP;
+        sc->battery_limiter = nla_get_u8(attrs[NEKRO_ATTR_BATTERY_LIMITER]);
+        sc->flags |= SCENE_BATTERY;
+    }
+
+    for (int i = 0; i < ACER_SETTING_MAX; i++) {
+        if (attrs[nekro_genl_setting_attr[i]] && !has_cap(ACER_CAP_PREDATOR_SENSE))
+            return -EOPNOTSUPP;
+    }
+    if (attrs[NEKRO_ATTR_USB_CHARGING]) {
+        u8 value = nla_get_u8(attrs[NEKRO_ATTR_USB_CHARGING]);
+
+        if (value % 10) {
+            NL_SET_ERR_MSG_ATTR(info->extack, attrs[NEKRO_ATTR_USB_CHARGING],
+                                "USB charging is 0, 10, 20 or 30");
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+static int nekro_genl_set(struct sk_buff *skb, struct genl_info *info)
+{
+    struct scene sc = {};
+    int ret;
+
+    ret = nekro_genl_parse_set(info, &sc);
+    if (ret)
+        return ret;
+
+    mutex_lock(&scenes_lock);
+    ret = scene_apply(&sc);
+    /* What this request changed is no longer the active scene */
+    if (sc.flags || sc.lighting.flags)
+        scene_active[0] = '\0';
+    for (int i = 0; !ret && i < ACER_SETTING_MAX; i++) {
+        struct nlattr *attr = info->attrs[nekro_genl_setting_attr[i]];
+        int cur;
+
+        if (attr && (acer_setting_get(i, &cur) || cur != nla_get_u8(attr)))
+            ret = acer_setting_set(i, nla_get_u8(attr));
+    }
+    mutex_unlock(&scenes_lock);
+    if (ret)
+        return ret;
+
+    if (info->attrs[NEKRO_ATTR_TEMP_ALERT]) {
+        WRITE_ONCE(nekro_genl_alert_threshold, nla_get_u8(info->attrs[NEKRO_ATTR_TEMP_ALERT]));
+        mod_delayed_work(system_wq, &nekro_genl_alert_work, 0);
+    }
+
+    return 0;
+}
+
+static const struct genl_small_ops nekro_genl_ops[] = {
+    {
+        .cmd = NEKRO_CMD_GET,
+        .doit = nekro_genl_get,
+    },
+    {
+        .cmd = NEKRO_CMD_SET,
+        .doit = nekro_genl_set,
+        .flags = GENL_ADMIN_PERM,
+    },
+};
+
+static const struct genl_multicast_group nekro_genl_mcgrps[] = {
+    [NEKRO_GENL_MCGRP_EVENTS] = { .name = "events" },
+};
+
+static struct genl_family nekro_genl_family = {
+    .name = NEKRO_GENL_NAME,
+    .version = NEKRO_GENL_VERSION,
+    .maxattr = NEKRO_ATTR_MAX,
+    .policy = nekro_genl_policy,
+    .module = THIS_MODULE,
+    .small_ops = nekro_genl_ops,
+    .n_small_ops = ARRAY_SIZE(nekro_genl_ops),
+    .resv_start_op = __NEKRO_CMD_MAX,
+    .mcgrps = nekro_genl_mcgrps,
+    .n_mcgrps = ARRAY_SIZE(nekro_genl_mcgrps),
+};
+
+/* Sends NEKRO_CMD_EVENT or NEKRO_CMD_ALERT with two or three u8 attributes */
+static void nekro_genl_multicast(u8 cmd, int attr1, u8 val1, int attr2, u8 val2, int attr3, u8 val3)
+{
+    struct sk_buff *msg;
+    void *hdr;
+
+    if (!READ_ONCE(nekro_genl_registered) ||
+        !genl_has_listeners(&nekro_genl_family, &init_net, NEKRO_GENL_MCGRP_EVENTS))
+        return;
+
+    msg = genlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+    if (!msg)
+        return;
+
+    hdr = genlmsg_put(msg, 0, 0, &nekro_genl_family, 0, cmd);
+    if (!hdr || nla_put_u8(msg, attr1, val1) || nla_put_u8(msg, attr2, val2) ||
+        (attr3 && nla_put_u8(msg, attr3, val3))) {
+        nlmsg_free(msg);
+        return;
+    }
+    genlmsg_end(msg, hdr);
+
+    genlmsg_multicast(&nekro_genl_family, msg, 0, NEKRO_GENL_MCGRP_EVENTS, GFP_KERNEL);
+}
+
+static void nekro_genl_event(u8 function, u8 key)
+{
+    nekro_genl_multicast(NEKRO_CMD_EVENT, NEKRO_ATTR_EVENT_FUNCTION, function,
+                         NEKRO_ATTR_EVENT_KEY, key, 0, 0);
+}
+
+/* Alerts once when a sensor crosses the threshold and once when it drops back */
+static void nekro_genl_alert_work_fn(struct work_struct *work)
+{
+    static const u8 sensors[2] = {
+        ACER_WMID_SENSOR_CPU_TEMPERATURE,
+        ACER_WMID_SENSOR_GPU_TEMPERATURE,
+    };
+    u8 threshold = READ_ONCE(nekro_genl_alert_threshold);
+    u64 temp;
+
+    if (!threshold) {
+        memset(nekro_genl_alert_above, 0, sizeof(nekro_genl_alert_above));
+        return;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(sensors); i++) {
+        bool above = nekro_genl_alert_above[i];
+
+        if (WMID_gaming_get_sensor_reading(sensors[i], &temp))
+            continue;
+
+        if (!above && temp >= threshold)
+            above = true;
+        else if (above && temp + NEKRO_GENL_ALERT_HYSTERESIS < threshold)
+            above = false;
+        if (above == nekro_genl_alert_above[i])
+            continue;
+
+        nekro_genl_alert_above[i] = above;
+        nekro_genl_multicast(NEKRO_CMD_ALERT, NEKRO_ATTR_ALERT_SENSOR, i,
+                             NEKRO_ATTR_ALERT_TEMP, min_t(u64, temp, U8_MAX),
+                             NEKRO_ATTR_ALERT_ACTIVE, above);
+    }
+
+    schedule_delayed_work(&nekro_genl_alert_work, msecs_to_jiffies(NEKRO_GENL_ALERT_INTERVAL_MS));
+}
+
+/*
+ * Control device
+ *
+ * /dev/nekro_sense takes an array of typed operations in one ioctl. The array
+ * runs in order under scenes_lock, so it is never interleaved with a scene or
+ * a netlink SET, and every operation gets its own result. A failed operation
+ * does not stop the ones after it.
+ */
+/* The layout userspace builds from nekro_sense.h */
+static_assert(sizeof(struct nekro_op) == 32);
+static_assert(sizeof(struct nekro_op_batch) == 16);
+
+static int nekro_op_set_zone(const struct nekro_op_zone *oz)
+{
+    struct per_zone_color zones;
+    struct kb_state kb;
+    acpi_status status;
+    u64 *zone;
+
+    if (!quirks->four_zone_kb)
+        return -EOPNOTSUPP;
+    if (oz->zone > 3 || oz->brightness > 100)
+        return -EINVAL;
+
+    mutex_lock(&lighting_lock);
+    if (kb_state_get(&kb)) {
+        mutex_unlock(&lighting_lock);
+        return -ENODEV;
+    }
+    /* Coming from an effect, start the other zones from black */
+    zones = kb.per_zone ? kb.zones : (struct per_zone_color){};
+    zone = &((u64 *)&zones)[oz->zone];
+    *zone = ((u64)oz->red << 16) | ((u64)oz->green << 8) | oz->blue;
+    zones.brightness = oz->brightness;
+    status = update_per_zone_color(&zones);
+    mutex_unlock(&lighting_lock);
+
+    return ACPI_FAILURE(status) ? -ENODEV : 0;
+}
+
+static int nekro_op_read_sensors(struct nekro_op_sensors *out)
+{
+    static const u8 ids[4] = {
+        ACER_WMID_SENSOR_CPU_TEMPERATURE,
+        ACER_WMID_SENSOR_GPU_TEMPERATURE,
+        ACER_WMID_SENSOR_CPU_FAN_SPEED,
+        ACER_WMID_SENSOR_GPU_FAN_SPEED,
+    };
+    u16 *values = (u16 *)out;
+    u64 reading;
+    int ret;
+
+    if (!has_cap(ACER_CAP_FAN_SPEED_READ))
+        return -EOPNOTSUPP;
+
+    for (int i = 0; i < ARRAY_SIZE(ids); i++) {
+        ret = WMID_gaming_get_sensor_reading(ids[i], &reading);
+        if (ret)
+            return ret;
+        values[i] = min_t(u64, reading, U16_MAX);
+    }
+    return 0;
+}
+
+/* Caller holds scenes_lock */
+static int nekro_op_run(struct nekro_op *op)
+{
+    struct scene sc = {};
+
+    switch (op->type) {
+    case NEKRO_OP_NOP:
+        return 0;
+    case NEKRO_OP_SET_PROFILE:
+        if (!has_cap(ACER_CAP_PLATFORM_PROFILE))
+            return -EOPNOTSUPP;
+        if (op->profile >= ARRAY_SIZE(scene_profiles))
+            return -EINVAL;
+        sc.profile = op->profile;
+        sc.flags = SCENE_PROFILE;
+        break;
+    case NEKRO_OP_SET_FAN:
+        if (!has_cap(ACER_CAP_PREDATOR_SENSE))
+            return -EOPNOTSUPP;
+        if (op->fan.cpu > 100 || op->fan.gpu > 100)
+            return -EINVAL;
+        sc.cpu_fan = op->fan.cpu;
+        sc.gpu_fan = op->fan.gpu;
+        sc.flags = SCENE_FAN;
+        break;
+    case NEKRO_OP_SET_ZONE:
+        return nekro_op_set_zone(&op->zone);
+    case NEKRO_OP_SET_LOGO:
+        if (!has_cap(ACER_CAP_BACK_LOGO))
+            return -EOPNOTSUPP;
+        if (op->logo.brightness > 100 || op->logo.enable > 1)
+            return -EINVAL;
+        sc.lighting.logo.red = op->logo.red;
+        sc.lighting.logo.green = op->logo.green;
+        sc.lighting.logo.blue = op->logo.blue;
+        sc.lighting.logo.brightness = op->logo.brightness;
+        sc.lighting.logo.enable = op->logo.enable;
+        sc.lighting.flags = LIGHTING_UPDATE_LOGO;
+        break;
+    case NEKRO_OP_SET_BATTERY_LIMITER:
+        if (!has_cap(ACER_CAP_PREDATOR_SENSE))
+            return -EOPNOTSUPP;
+        if (op->battery_limiter > 1)
+            return -EINVAL;
+        sc.battery_limiter = op->battery_limiter;
+        sc.flags = SCENE_BATTERY;
+        break;
+    case NEKRO_OP_READ_SENSORS:
+        memset(op->raw, 0, sizeof(op->raw));
+        return nekro_op_read_sensors(&op->sensors);
+    default:
+        return -EINVAL;
+    }
+
+    /* Anything set outside a scene means no scene is active anymore */
+    scene_active[0] = '\0';
+    return scene_apply(&sc);
+}
+
+static long nekro_ctl_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+    struct nekro_op_batch batch;
+    struct nekro_op *ops;
+    long ret = 0;
+
+    if (cmd != NEKRO_IOC_BATCH)
+        return -ENOTTY;
+    if (copy_from_user(&batch, (void __user *)arg, sizeof(batch)))
+        return -EFAULT;
+    if (!batch.count || batch.count > NEKRO_OP_BATCH_MAX || batch.flags)
+        return -EINVAL;
+
+    ops = memdup_user(u64_to_user_ptr(batch.ops), batch.count * sizeof(*ops));
+    if (IS_ERR(ops))
+        return PTR_ERR(ops);
+
+    mutex_lock(&scenes_lock);
+    for (u32 i = 0; i < batch.count; i++)
+        ops[i].result = nekro_op_run(&ops[i]);
+    mutex_unlock(&scenes_lock);
+
+    if (copy_to_user(u64_to_user_ptr(batch.ops), ops, batch.count * sizeof(*ops)))
+        ret = -EFAULT;
+
+    kfree(ops);
+    return ret;
+}
+
+static const struct file_operations nekro_ctl_fops = {
+    .owner = THIS_MODULE,
+    .open = nonseekable_open,
+    .unlocked_ioctl = nekro_ctl_ioctl,
+    .compat_ioctl = compat_ptr_ioctl,
+    .llseek = noop_llseek,
+};
+
+static struct miscdevice nekro_ctl_dev = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = "nekro_sense",
+    .fops = &nekro_ctl_fops,
+    .mode = 0660,
+};
+
+ /*
+  * Platform device
+  */
+ 
+static void acer_gaming_init_lighting(void)
+{
+    acpi_status status;
+    /* 
+     * Windows WMI verification confirms proper payload size is 16 bytes.
+     * 8-byte (u64) payloads are rejected with "Invalid Parameter".
+     * Structure is likely u128 or specific struct with padding.
+     * Value 1 starts the engine.
+     */
+    u8 enable_cmd[16] = {1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    struct acpi_buffer input = { sizeof(enable_cmd), enable_cmd };
+    struct acpi_buffer output = { ACPI_ALLOCATE_BUFFER, NULL };
+
+    /*
+     * The official Windows driver sends a SetGamingLED(1) command 
+     * during service startup (boot) and likely on resume.
+     * This appears to be required to "unbrick" or enable the RGB controller
+     * if the BIOS disabled it (e.g. on AC plug event during boot).
+     */
+    if (has_cap(ACER_CAP_PREDATOR_SENSE)) {
+        /* 
+         * Try standard Method 2 (Gaming LED) with 16-byte payload 
+         */
+        status = acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_SET_GAMING_LED_METHODID, &input, &output);
+        if (ACPI_FAILURE(status))
+            pr_warn("Failed to enable Gaming LED engine (Method 2): %s\n", acpi_format_exception(status));
+        else {
+            pr_debug("Gaming LED engine enabled (Method 2)\n");
+            kfree(output.pointer);
+        }
+
+        /* 
+         * Try Method 6 (Gaming RGB KB) with 8-byte payload of '1'
+         * Uncovered via WMI tracing of official driver service.
+         */
+        u64 magic = 1;
+        struct acpi_buffer input6 = { sizeof(u64), &magic };
+        struct acpi_buffer output6 = { ACPI_ALLOCATE_BUFFER, NULL };
+        
+        status = acer_wmi_evaluate(ACER_WMI_GUID4, ACER_WMID_SET_GAMING_RGB_KB_METHODID, &input6, &output6);
+        if (ACPI_FAILURE(status))
+             pr_warn("Failed to init Gaming RGB KB (Method 6): %s\n", acpi_format_exception(status));
+        else {
+             pr_info("Predator Sense: Gaming RGB KB initialized (Method 6, val=1)\n");
+             kfree(output6.pointer);
+        }
+    }
+}
+
+static int acer_platform_probe(struct platform_device *device)
+{
+    int err;
 
     /* Initialize lighting engine to fix potential bricked state from BIOS */
     acer_gaming_init_lighting();
@@ -2299,41 +6623,181 @@ static int acer_platform_probe(struct platform_device *device)
          if (err)
              return err;
          acer_predator_state_load();
+
+         acer_battery_dev = &device->dev;
+         err = devm_battery_hook_register(&device->dev, &acer_battery_hook);
+         if (err)
+             goto err_predator_sense;
+
+         err = sysfs_create_group(&device->dev.kobj, &battery_telemetry_attr_group);
+         if (err)
+             goto err_predator_sense;
+         schedule_delayed_work(&battery_telemetry_work, 0);
      }
 
      if (quirks->four_zone_kb) {
          err = sysfs_create_group(&device->dev.kobj, &four_zoned_kb_attr_group);
          if (err)
-             return err;
+             goto err_battery_telemetry;
          four_zone_kb_state_load();
      }
 
      if (has_cap(ACER_CAP_BACK_LOGO)) {
          err = sysfs_create_group(&device->dev.kobj, &back_logo_attr_group);
          if (err)
-             return err;
+             goto err_four_zone;
+     }
+
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+         err = sysfs_create_group(&device->dev.kobj, &lighting_attr_group);
+         if (err)
+             goto err_back_logo;
+         err = sysfs_create_group(&device->dev.kobj, &thermal_lighting_attr_group);
+         if (err)
+             goto err_lighting;
+     }
+
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+         err = misc_register(&lighting_frame_dev);
+         if (err)
+             goto err_thermal_lighting;
+     }
+
+     if (quirks->four_zone_kb) {
+         err = sysfs_create_group(&device->dev.kobj, &reactive_lighting_attr_group);
+         if (err)
+             goto err_frame_dev;
+     }
+
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+         err = sysfs_create_group(&device->dev.kobj, &lighting_idle_attr_group);
+         if (err)
+             goto err_reactive;
+         /* Registered on demand once a consumer is enabled */
+         lighting_input_set_available(true);
      }
 
+     /* LED class devices are optional, keep the sysfs API if they can't register */
+     err = acer_lighting_leds_init(&device->dev);
+     if (err)
+         dev_warn(&device->dev, "Could not register lighting LED devices: %d\n", err);
+
      if (has_cap(ACER_CAP_FAN_SPEED_READ)) {
          err = acer_wmi_hwmon_init();
          if (err)
-             return err;
+             goto err_lighting_idle;
+     }
+
+     err = sysfs_create_group(&device->dev.kobj, &acer_state_attr_group);
+     if (err)
+         goto err_lighting_idle;
+
+     err = sysfs_create_group(&device->dev.kobj, &scenes_attr_group);
+     if (err)
+         goto err_state;
+
+     err = genl_register_family(&nekro_genl_family);
+     if (err)
+         goto err_scenes;
+     WRITE_ONCE(nekro_genl_registered, true);
+
+     err = misc_register(&nekro_ctl_dev);
+     if (err)
+         goto err_genl;
+
+     /* So the first state read is served from the caches too */
+     acer_state_caches_fill();
+
+     return 0;
+
+     /* Undo the steps above in reverse; the devm resources go on their own */
+ err_genl:
+     WRITE_ONCE(nekro_genl_registered, false);
+     genl_unregister_family(&nekro_genl_family);
+     cancel_delayed_work_sync(&nekro_genl_alert_work);
+ err_scenes:
+     sysfs_remove_group(&device->dev.kobj, &scenes_attr_group);
+ err_state:
+     sysfs_remove_group(&device->dev.kobj, &acer_state_attr_group);
+ err_lighting_idle:
+     lighting_input_set_available(false);
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO))
+         sysfs_remove_group(&device->dev.kobj, &lighting_idle_attr_group);
+     cancel_delayed_work_sync(&lighting_idle_work);
+     cancel_work_sync(&lighting_idle_wake_work);
+ err_reactive:
+     if (quirks->four_zone_kb) {
+         sysfs_remove_group(&device->dev.kobj, &reactive_lighting_attr_group);
+         cancel_delayed_work_sync(&reactive_lighting_work);
+     }
+ err_frame_dev:
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+         misc_deregister(&lighting_frame_dev);
+         cancel_work_sync(&lighting_frame_work);
+     }
+ err_thermal_lighting:
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+         sysfs_remove_group(&device->dev.kobj, &thermal_lighting_attr_group);
+         cancel_delayed_work_sync(&thermal_lighting_work);
+     }
+ err_lighting:
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO))
+         sysfs_remove_group(&device->dev.kobj, &lighting_attr_group);
+ err_back_logo:
+     if (has_cap(ACER_CAP_BACK_LOGO))
+         sysfs_remove_group(&device->dev.kobj, &back_logo_attr_group);
+ err_four_zone:
+     if (quirks->four_zone_kb)
+         sysfs_remove_group(&device->dev.kobj, &four_zoned_kb_attr_group);
+ err_battery_telemetry:
+     if (has_cap(ACER_CAP_PREDATOR_SENSE)) {
+         sysfs_remove_group(&device->dev.kobj, &battery_telemetry_attr_group);
+         cancel_delayed_work_sync(&battery_telemetry_work);
      }
-
-     return 0;
+ err_predator_sense:
+     if (has_cap(ACER_CAP_PREDATOR_SENSE))
+         sysfs_remove_group(&device->dev.kobj, &preadtor_sense_attr_group);
+     return err;
  }
  
  
  static void acer_platform_remove(struct platform_device *device)
  {
+     sysfs_remove_group(&device->dev.kobj, &acer_state_attr_group);
+     sysfs_remove_group(&device->dev.kobj, &scenes_attr_group);
+     if (nekro_genl_registered) {
+         WRITE_ONCE(nekro_genl_registered, false);
+         genl_unregister_family(&nekro_genl_family);
+     }
+     misc_deregister(&nekro_ctl_dev);
+     cancel_delayed_work_sync(&nekro_genl_alert_work);
      if (has_cap(ACER_CAP_PREDATOR_SENSE)) {
+         sysfs_remove_group(&device->dev.kobj, &battery_telemetry_attr_group);
+         cancel_delayed_work_sync(&battery_telemetry_work);
          sysfs_remove_group(&device->dev.kobj, &preadtor_sense_attr_group);
          acer_predator_state_save();
      }
+     lighting_input_set_available(false);
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO))
+         sysfs_remove_group(&device->dev.kobj, &lighting_idle_attr_group);
+     /* AC events kick the idle work even without lighting */
+     cancel_delayed_work_sync(&lighting_idle_work);
+     cancel_work_sync(&lighting_idle_wake_work);
+     /* Do not persist the idle brightness below */
+     __lighting_idle_wake();
      if (quirks->four_zone_kb) {
+         cancel_delayed_work_sync(&reactive_lighting_work);
+         sysfs_remove_group(&device->dev.kobj, &reactive_lighting_attr_group);
          sysfs_remove_group(&device->dev.kobj, &four_zoned_kb_attr_group);
          four_zone_kb_state_save();
      }
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+         misc_deregister(&lighting_frame_dev);
+         cancel_work_sync(&lighting_frame_work);
+         sysfs_remove_group(&device->dev.kobj, &thermal_lighting_attr_group);
+         cancel_delayed_work_sync(&thermal_lighting_work);
+         sysfs_remove_group(&device->dev.kobj, &lighting_attr_group);
+     }
      if (has_cap(ACER_CAP_BACK_LOGO))
          sysfs_remove_group(&device->dev.kobj, &back_logo_attr_group);
  }
@@ -2341,6 +6805,11 @@ static int acer_platform_probe(struct platform_device *device)
  #ifdef CONFIG_PM_SLEEP
  static int acer_suspend(struct device *dev)
  {
+     cancel_delayed_work_sync(&thermal_lighting_work);
+     cancel_delayed_work_sync(&reactive_lighting_work);
+     cancel_delayed_work_sync(&lighting_idle_work);
+     cancel_delayed_work_sync(&battery_telemetry_work);
+     cancel_delayed_work_sync(&nekro_genl_alert_work);
      return 0;
  }
  
@@ -2348,6 +6817,28 @@ static int acer_platform_probe(struct platform_device *device)
  {
      /* Re-initialize lighting on resume to prevent bricked state */
      acer_gaming_init_lighting();
+
+     /* Re-read the state from the firmware now, the lighting on the next show */
+     acer_caches_reload();
+
+     /* The firmware may have reset the colors, rewrite on the next sample */
+     mutex_lock(&lighting_lock);
+     thermal_lighting_kick(&thermal_lighting);
+     mutex_unlock(&lighting_lock);
+
+     /* Finish any fade that suspend cut short */
+     mod_delayed_work(system_wq, &reactive_lighting_work, 0);
+
+     /* Sample right away, the time asleep is counted as untracked */
+     if (has_cap(ACER_CAP_PREDATOR_SENSE) && READ_ONCE(battery_telemetry.interval_s))
+         schedule_delayed_work(&battery_telemetry_work, 0);
+
+     if (READ_ONCE(nekro_genl_alert_threshold))
+         schedule_delayed_work(&nekro_genl_alert_work, 0);
+
+     /* Resuming counts as activity, so wake the lighting and restart the timer */
+     WRITE_ONCE(lighting_idle.last_activity, jiffies);
+     schedule_work(&lighting_idle_wake_work);
      return 0;
  }
  #else
@@ -2374,9 +6865,793 @@ static int acer_platform_probe(struct platform_device *device)
  
  static struct platform_device *acer_platform_device;
  
- static inline void remove_debugfs(void) {}
- 
- static inline void __init create_debugfs(void) {}
+/*
+ * debugfs
+ */
+
+/*
+ * Lighting benchmark
+ *
+ * Write "PATH [ITERATIONS]" to lighting_bench, where PATH is one of the
+ * entries in lighting_bench_paths or "all". Every path runs once without and
+ * once with a SetGamingLED wake call before each update. Reading returns one
+ * key=value line per run. Each update rewrites the current shadow state, and
+ * the previous lighting is restored when the run ends. lighting_lock is held
+ * per update only, so other lighting users interleave with a long run.
+ */
+#define LIGHTING_BENCH_MAX_ITERATIONS	10000
+#define LIGHTING_BENCH_BUF_SIZE		2048
+
+enum lighting_bench_path {
+    LIGHTING_BENCH_KB_STATUS,
+    LIGHTING_BENCH_ZONE,
+    LIGHTING_BENCH_ZONES4,
+    LIGHTING_BENCH_PER_ZONE,
+    LIGHTING_BENCH_LOGO,
+    LIGHTING_BENCH_ALL,
+};
+
+static const char * const lighting_bench_paths[] = {
+    [LIGHTING_BENCH_KB_STATUS] = "kb_status",
+    [LIGHTING_BENCH_ZONE] = "zone",
+    [LIGHTING_BENCH_ZONES4] = "zones4",
+    [LIGHTING_BENCH_PER_ZONE] = "per_zone",
+    [LIGHTING_BENCH_LOGO] = "logo",
+    [LIGHTING_BENCH_ALL] = "all",
+};
+
+/* Serializes runs and the result buffer */
+static DEFINE_MUTEX(lighting_bench_lock);
+static char lighting_bench_result[LIGHTING_BENCH_BUF_SIZE];
+static size_t lighting_bench_result_len;
+
+/* Caller holds lighting_lock */
+static acpi_status lighting_bench_update(enum lighting_bench_path path, bool wake)
+{
+    struct kb_state *kb = &current_kb_state;
+    struct logo_state *logo = &current_logo_state;
+    acpi_status status = AE_OK;
+
+    if (wake && path != LIGHTING_BENCH_PER_ZONE) {
+        status = gaming_led_wake();
+        if (ACPI_FAILURE(status))
+            return status;
+    }
+
+    switch (path) {
+    case LIGHTING_BENCH_KB_STATUS:
+        return set_kb_status(kb->mode, kb->speed, kb->brightness, kb->direction,
+                             kb->red, kb->green, kb->blue);
+    case LIGHTING_BENCH_ZONE:
+        return set_zone_color(kb_zone_ids[0], kb->zones.zone1);
+    case LIGHTING_BENCH_ZONES4:
+        for (int i = 0; i < 4 && ACPI_SUCCESS(status); i++)
+            status = set_zone_color(kb_zone_ids[i], ((u64 *)&kb->zones)[i]);
+        return status;
+    case LIGHTING_BENCH_PER_ZONE:
+        return __set_per_zone_color(&kb->zones, wake);
+    case LIGHTING_BENCH_LOGO:
+        /* Time the full color + gate sequence, not the no-op skip */
+        WRITE_ONCE(logo_state_valid, false);
+        return set_logo_status(logo->enable, logo->brightness, 0,
+                               logo->red, logo->green, logo->blue);
+    default:
+        return AE_BAD_PARAMETER;
+    }
+}
+
+static int lighting_bench_cmp(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void lighting_bench_run(enum lighting_bench_path path, bool wake,
+                               unsigned int iterations, u32 *samples)
+{
+    unsigned int errors = 0;
+    u64 total_us = 0;
+    ktime_t start;
+
+    for (unsigned int i = 0; i < iterations; i++) {
+        acpi_status status;
+
+        mutex_lock(&lighting_lock);
+        start = ktime_get();
+        status = lighting_bench_update(path, wake);
+        samples[i] = ktime_us_delta(ktime_get(), start);
+        mutex_unlock(&lighting_lock);
+        if (ACPI_FAILURE(status))
+            errors++;
+        total_us += samples[i];
+    }
+
+    sort(samples, iterations, sizeof(*samples), lighting_bench_cmp, NULL);
+
+    lighting_bench_result_len += scnprintf(lighting_bench_result + lighting_bench_result_len,
+        sizeof(lighting_bench_result) - lighting_bench_result_len,
+        "path=%s wake=%d n=%u errors=%u total_us=%llu ups=%llu mean_us=%llu "
+        "min_us=%u p50_us=%u p90_us=%u p99_us=%u max_us=%u\n",
+        lighting_bench_paths[path], wake, iterations, errors, total_us,
+        total_us ? div64_u64((u64)iterations * USEC_PER_SEC, total_us) : 0,
+        div_u64(total_us, iterations), samples[0],
+        samples[iterations * 50 / 100], samples[iterations * 90 / 100],
+        samples[iterations * 99 / 100], samples[iterations - 1]);
+}
+
+static ssize_t lighting_bench_write(struct file *file, const char __user *ubuf,
+                                    size_t count, loff_t *ppos)
+{
+    unsigned int iterations = 100;
+    char buf[32], name[16];
+    u32 *samples;
+    int path;
+
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (sscanf(buf, "%15s %u", name, &iterations) < 1 ||
+        !iterations || iterations > LIGHTING_BENCH_MAX_ITERATIONS)
+        return -EINVAL;
+
+    path = match_string(lighting_bench_paths, ARRAY_SIZE(lighting_bench_paths), name);
+    if (path < 0)
+        return -EINVAL;
+
+    samples = kcalloc(iterations, sizeof(*samples), GFP_KERNEL);
+    if (!samples)
+        return -ENOMEM;
+
+    mutex_lock(&lighting_bench_lock);
+    lighting_bench_result_len = 0;
+    for (int p = 0; p < LIGHTING_BENCH_ALL; p++) {
+        if (path != LIGHTING_BENCH_ALL && path != p)
+            continue;
+        if (p == LIGHTING_BENCH_LOGO ? !has_cap(ACER_CAP_BACK_LOGO) : !quirks->four_zone_kb)
+            continue;
+        lighting_bench_run(p, false, iterations, samples);
+        lighting_bench_run(p, true, iterations, samples);
+    }
+
+    /* Put back whatever the benchmark paths overwrote */
+    mutex_lock(&lighting_lock);
+    if (quirks->four_zone_kb) {
+        if (current_kb_state.per_zone)
+            set_per_zone_color(&current_kb_state.zones);
+        else
+            set_kb_status(current_kb_state.mode, current_kb_state.speed, current_kb_state.brightness,
+                          current_kb_state.direction, current_kb_state.red,
+                          current_kb_state.green, current_kb_state.blue);
+    }
+    mutex_unlock(&lighting_lock);
+    mutex_unlock(&lighting_bench_lock);
+
+    kfree(samples);
+
+    return count;
+}
+
+static ssize_t lighting_bench_read(struct file *file, char __user *ubuf,
+                                   size_t count, loff_t *ppos)
+{
+    ssize_t ret;
+
+    mutex_lock(&lighting_bench_lock);
+    ret = simple_read_from_buffer(ubuf, count, ppos, lighting_bench_result,
+                                  lighting_bench_result_len);
+    mutex_unlock(&lighting_bench_lock);
+
+    return ret;
+}
+
+static const struct file_operations lighting_bench_fops = {
+    .owner = THIS_MODULE,
+    .read = lighting_bench_read,
+    .write = lighting_bench_write,
+    .llseek = default_llseek,
+};
+
+/*
+ * Raw WMI passthrough
+ *
+ * Write "GUID METHOD PAYLOAD [N]" to wmi_raw, where GUID is 3, 4 or 5
+ * (WMID_GUID3-5), METHOD the method id and PAYLOAD one of:
+ *   0xVALUE	 a u64, passed as 8 little-endian bytes
+ *   u32:0xVALUE a u32, passed as 4 little-endian bytes
+ *   hex:AABB...	 raw bytes
+ * The call is made N times (default 1). Reading returns the decoded object
+ * of the last call and the call durations. This runs firmware methods
+ * unchecked, so it is root only and meant for reverse engineering.
+ */
+#define WMI_RAW_MAX_INPUT	128
+#define WMI_RAW_MAX_CALLS	1000
+#define WMI_RAW_BUF_SIZE	1024
+
+static DEFINE_MUTEX(wmi_raw_lock);
+static char wmi_raw_result[WMI_RAW_BUF_SIZE];
+static size_t wmi_raw_result_len;
+
+#define wmi_raw_emit(fmt, ...)							\
+    (wmi_raw_result_len += scnprintf(wmi_raw_result + wmi_raw_result_len,		\
+                                     sizeof(wmi_raw_result) - wmi_raw_result_len,	\
+                                     fmt, ##__VA_ARGS__))
+
+/* Caller holds wmi_raw_lock */
+static void wmi_raw_decode(const union acpi_object *obj)
+{
+    if (!obj) {
+        wmi_raw_emit("type=none\n");
+        return;
+    }
+
+    switch (obj->type) {
+    case ACPI_TYPE_INTEGER:
+        wmi_raw_emit("type=integer\nvalue=0x%llx\n", (u64)obj->integer.value);
+        break;
+    case ACPI_TYPE_BUFFER:
+        wmi_raw_emit("type=buffer\nlength=%u\nbytes=", obj->buffer.length);
+        for (u32 i = 0; i < obj->buffer.length; i++)
+            wmi_raw_emit("%02x", obj->buffer.pointer[i]);
+        wmi_raw_emit("\n");
+        if (obj->buffer.length >= sizeof(u64))
+            wmi_raw_emit("u64=0x%llx\n", get_unaligned_le64(obj->buffer.pointer));
+        else if (obj->buffer.length >= sizeof(u32))
+            wmi_raw_emit("u32=0x%x\n", get_unaligned_le32(obj->buffer.pointer));
+        break;
+    case ACPI_TYPE_STRING:
+        wmi_raw_emit("type=string\nvalue=%.*s\n", obj->string.length, obj->string.pointer);
+        break;
+    case ACPI_TYPE_PACKAGE:
+        wmi_raw_emit("type=package\ncount=%u\n", obj->package.count);
+        break;
+    default:
+        wmi_raw_emit("type=%u\n", obj->type);
+        break;
+    }
+}
+
+static int wmi_raw_parse_payload(const char *s, u8 *in, size_t *len)
+{
+    u64 value;
+
+    if (str_has_prefix(s, "hex:")) {
+        s += 4;
+        *len = strlen(s) / 2;
+        if (strlen(s) % 2 || !*len || *len > WMI_RAW_MAX_INPUT || hex2bin(in, s, *len))
+            return -EINVAL;
+    } else if (str_has_prefix(s, "u32:")) {
+        if (kstrtoull(s + 4, 0, &value) || value > U32_MAX)
+            return -EINVAL;
+        put_unaligned_le32(value, in);
+        *len = sizeof(u32);
+    } else {
+        if (kstrtoull(s, 0, &value))
+            return -EINVAL;
+        put_unaligned_le64(value, in);
+        *len = sizeof(u64);
+    }
+    return 0;
+}
+
+static ssize_t wmi_raw_write(struct file *file, const char __user *ubuf,
+                             size_t count, loff_t *ppos)
+{
+    char buf[WMI_RAW_MAX_INPUT * 2 + 64], payload[WMI_RAW_MAX_INPUT * 2 + 8];
+    unsigned int guid, calls = 1;
+    u64 total_us = 0, min_us = U64_MAX, max_us = 0, us = 0;
+    int method;
+    union acpi_object *obj = NULL;
+    u8 in[WMI_RAW_MAX_INPUT];
+    acpi_status status = AE_OK;
+    size_t in_len;
+    ktime_t start;
+
+    if (!capable(CAP_SYS_ADMIN))
+        return -EPERM;
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (sscanf(buf, "%u %i %263s %u", &guid, &method, payload, &calls) < 3 ||
+        guid < 3 || guid > 5 || method < 0 ||
+        !calls || calls > WMI_RAW_MAX_CALLS)
+        return -EINVAL;
+    if (wmi_raw_parse_payload(payload, in, &in_len))
+        return -EINVAL;
+
+    mutex_lock(&wmi_raw_lock);
+    /* Keep the calls out of the middle of a lighting or battery update */
+    mutex_lock(&lighting_lock);
+    mutex_lock(&battery_health_lock);
+    for (unsigned int i = 0; i < calls; i++) {
+        struct acpi_buffer input = { in_len, in };
+        struct acpi_buffer output = { ACPI_ALLOCATE_BUFFER, NULL };
+
+        start = ktime_get();
+        status = acer_wmi_evaluate(ACER_WMI_GUID3 + guid - 3, method, &input, &output);
+        us = ktime_us_delta(ktime_get(), start);
+        total_us += us;
+        min_us = min(min_us, us);
+        max_us = max(max_us, us);
+
+        /* Keep only the last object */
+        kfree(obj);
+        obj = output.pointer;
+        if (ACPI_FAILURE(status))
+            break;
+    }
+
+    /* The call may have changed anything the driver caches */
+    lighting_state_invalidate();
+    battery_health_invalidate();
+    mutex_unlock(&battery_health_lock);
+    mutex_unlock(&lighting_lock);
+    acer_settings_invalidate();
+    WRITE_ONCE(thermal_profile_cached, -1);
+    acer_state_caches_fill();
+
+    wmi_raw_result_len = 0;
+    wmi_raw_emit("guid=%u method=0x%x input_length=%zu\nstatus=%s\n", guid, method, in_len,
+                 acpi_format_exception(status));
+    if (ACPI_SUCCESS(status))
+        wmi_raw_decode(obj);
+    wmi_raw_emit("calls=%u last_us=%llu min_us=%llu avg_us=%llu max_us=%llu\n", calls, us,
+                 min_us, div_u64(total_us, calls), max_us);
+    mutex_unlock(&wmi_raw_lock);
+
+    kfree(obj);
+    pr_info("wmi_raw: GUID%u method 0x%x, %zu byte input, %s\n", guid, method, in_len,
+            acpi_format_exception(status));
+
+    return count;
+}
+
+static ssize_t wmi_raw_read(struct file *file, char __user *ubuf, size_t count, loff_t *ppos)
+{
+    ssize_t ret;
+
+    mutex_lock(&wmi_raw_lock);
+    ret = simple_read_from_buffer(ubuf, count, ppos, wmi_raw_result, wmi_raw_result_len);
+    mutex_unlock(&wmi_raw_lock);
+
+    return ret;
+}
+
+static const struct file_operations wmi_raw_fops = {
+    .owner = THIS_MODULE,
+    .read = wmi_raw_read,
+    .write = wmi_raw_write,
+    .llseek = default_llseek,
+};
+
+/*
+ * Firmware state dump
+ *
+ * Reading state_dump sweeps every misc setting index, the sys-info commands
+ * and sensor readings, and the keyboard and logo getters, one firmware read
+ * per line. The columns are "section index result value raw us". Only the
+ * last column, the read latency, changes between runs on an idle machine,
+ * so "cut -d' ' -f1-5" gives dumps that diff cleanly across profiles and
+ * BIOS versions. Nothing is written and no driver cache is touched.
+ */
+#define STATE_DUMP_SYS_INFO_COMMANDS	0x10
+#define STATE_DUMP_SENSORS		0x10
+/* Header, misc, sys-info, sensors, kb_status, 4 kb_zone, logo, totals */
+#define STATE_DUMP_LINES		(1 + ACER_GAMING_MISC_SETTING_INDEX_MASK + 1 + \
+                                 STATE_DUMP_SYS_INFO_COMMANDS + STATE_DUMP_SENSORS + 6 + 1)
+/* The longest line is kb_status, at under 100 characters */
+#define STATE_DUMP_LINE_MAX		128
+
+struct state_dump_totals {
+    unsigned int reads;
+    unsigned int errors;
+    u64 total_us;
+    u64 max_us;
+};
+
+static void state_dump_line(struct seq_file *m, struct state_dump_totals *t, const char *section,
+                            unsigned int index, int ret, u64 status, const char *value,
+                            u64 raw, u64 us)
+{
+    t->reads++;
+    t->total_us += us;
+    t->max_us = max(t->max_us, us);
+    if (ret) {
+        t->errors++;
+        seq_printf(m, "%s 0x%02x err%d - - %llu\n", section, index, ret, us);
+    } else if (status) {
+        seq_printf(m, "%s 0x%02x st=0x%02llx - 0x%016llx %llu\n", section, index, status,
+                   raw, us);
+    } else {
+        seq_printf(m, "%s 0x%02x ok %s 0x%016llx %llu\n", section, index, value, raw, us);
+    }
+}
+
+static void state_dump_u64(struct seq_file *m, struct state_dump_totals *t, const char *section,
+                           unsigned int index, int ret, u64 status, u64 value, u64 raw, u64 us)
+{
+    char buf[20];
+
+    snprintf(buf, sizeof(buf), "0x%llx", value);
+    state_dump_line(m, t, section, index, ret, status, buf, raw, us);
+}
+
+/* Caller holds lighting_lock */
+static void state_dump_lighting(struct seq_file *m, struct state_dump_totals *t)
+{
+    struct get_four_zoned_kb_output out;
+    acpi_status status;
+    char buf[2 * sizeof(out.gmOutput) + 1];
+    ktime_t start;
+    u64 zone = 0;
+
+    memset(&out, 0, sizeof(out));
+    if (quirks->four_zone_kb) {
+        start = ktime_get();
+        status = get_kb_status(&out);
+        *bin2hex(buf, out.gmOutput, sizeof(out.gmOutput)) = '\0';
+        state_dump_line(m, t, "kb_status", 0, ACPI_FAILURE(status) ? -EIO : 0, 0, buf,
+                        out.gmReturn, ktime_us_delta(ktime_get(), start));
+
+        for (int i = 0; i < 4; i++) {
+            start = ktime_get();
+            status = WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_RGB_KB_METHODID,
+                                            kb_zone_ids[i], &zone);
+            state_dump_u64(m, t, "kb_zone", kb_zone_ids[i], ACPI_FAILURE(status) ? -EIO : 0, 0,
+                           cpu_to_be64(zone) >> 32, zone, ktime_us_delta(ktime_get(), start));
+        }
+    }
+
+    if (has_cap(ACER_CAP_BACK_LOGO)) {
+        start = ktime_get();
+        status = get_logo_status(&out);
+        *bin2hex(buf, out.gmOutput, sizeof(out.gmOutput)) = '\0';
+        state_dump_line(m, t, "logo", 0, ACPI_FAILURE(status) ? -EIO : 0, 0, buf,
+                        out.gmReturn, ktime_us_delta(ktime_get(), start));
+    }
+}
+
+static int state_dump_show(struct seq_file *m, void *v)
+{
+    struct state_dump_totals t = {};
+    ktime_t start;
+    u64 raw;
+    int ret;
+
+    seq_puts(m, "# section index result value raw us\n");
+
+    for (unsigned int i = 0; i <= ACER_GAMING_MISC_SETTING_INDEX_MASK; i++) {
+        start = ktime_get();
+        ret = WMID_gaming_get_misc_setting_raw(i, &raw);
+        state_dump_u64(m, &t, "misc", i, ret, FIELD_GET(ACER_GAMING_MISC_SETTING_STATUS_MASK, raw),
+                       FIELD_GET(ACER_GAMING_MISC_SETTING_VALUE_MASK, raw), raw,
+                       ktime_us_delta(ktime_get(), start));
+    }
+
+    for (unsigned int i = 0; i < STATE_DUMP_SYS_INFO_COMMANDS; i++) {
+        acpi_status status;
+
+        start = ktime_get();
+        status = WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_SYS_INFO_METHODID, i, &raw);
+        state_dump_u64(m, &t, "sys_info", i, ACPI_FAILURE(status) ? -EIO : 0,
+                       FIELD_GET(ACER_PREDATOR_V4_RETURN_STATUS_BIT_MASK, raw), raw >> 8, raw,
+                       ktime_us_delta(ktime_get(), start));
+    }
+
+    for (unsigned int i = 0; i < STATE_DUMP_SENSORS; i++) {
+        u64 command = ACER_WMID_CMD_GET_PREDATOR_V4_SENSOR_READING;
+        acpi_status status;
+
+        command |= FIELD_PREP(ACER_PREDATOR_V4_SENSOR_INDEX_BIT_MASK, i);
+        start = ktime_get();
+        status = WMI_gaming_execute_u64(ACER_WMID_GET_GAMING_SYS_INFO_METHODID, command, &raw);
+        state_dump_u64(m, &t, "sensor", i, ACPI_FAILURE(status) ? -EIO : 0,
+                       FIELD_GET(ACER_PREDATOR_V4_RETURN_STATUS_BIT_MASK, raw),
+                       FIELD_GET(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, raw), raw,
+                       ktime_us_delta(ktime_get(), start));
+    }
+
+    if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO)) {
+        mutex_lock(&lighting_lock);
+        state_dump_lighting(m, &t);
+        mutex_unlock(&lighting_lock);
+    }
+
+    seq_printf(m, "# reads=%u errors=%u total_us=%llu avg_us=%llu max_us=%llu\n", t.reads,
+               t.errors, t.total_us, t.reads ? div_u64(t.total_us, t.reads) : 0, t.max_us);
+    return 0;
+}
+
+/*
+ * Size the buffer for the whole dump up front. With the default page
+ * seq_read would overflow, then rerun every firmware read with a larger buffer.
+ */
+static int state_dump_open(struct inode *inode, struct file *file)
+{
+    return single_open_size(file, state_dump_show, NULL,
+                            STATE_DUMP_LINES * STATE_DUMP_LINE_MAX);
+}
+
+static const struct file_operations state_dump_fops = {
+    .owner = THIS_MODULE,
+    .open = state_dump_open,
+    .read = seq_read,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+/*
+ * WMI call statistics
+ *
+ * One line per GUID and method id that was called since the last reset:
+ * "guid method calls failures total_us avg_us max_us". Method ids from
+ * ACER_WMI_STATS_METHODS up are summed under "other". Any write resets.
+ */
+static int wmi_stats_show(struct seq_file *m, void *v)
+{
+    struct acer_wmi_call_stats st;
+
+    seq_puts(m, "# guid method calls failures total_us avg_us max_us\n");
+    for (int g = 0; g < ACER_WMI_GUID_MAX; g++) {
+        for (int i = 0; i <= ACER_WMI_STATS_METHODS; i++) {
+            spin_lock(&acer_wmi_stats_lock);
+            st = acer_wmi_stats[g][i];
+            spin_unlock(&acer_wmi_stats_lock);
+            if (!st.calls)
+                continue;
+
+            seq_printf(m, "%d ", g + 3);
+            if (i < ACER_WMI_STATS_METHODS)
+                seq_printf(m, "0x%02x ", i);
+            else
+                seq_puts(m, "other ");
+            seq_printf(m, "%llu %llu %llu %llu %llu\n", st.calls, st.failures, st.total_us,
+                       div64_u64(st.total_us, st.calls), st.max_us);
+        }
+    }
+    return 0;
+}
+
+static int wmi_stats_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, wmi_stats_show, NULL);
+}
+
+static ssize_t wmi_stats_write(struct file *file, const char __user *ubuf,
+                               size_t count, loff_t *ppos)
+{
+    spin_lock(&acer_wmi_stats_lock);
+    memset(acer_wmi_stats, 0, sizeof(acer_wmi_stats));
+    spin_unlock(&acer_wmi_stats_lock);
+
+    return count;
+}
+
+static const struct file_operations wmi_stats_fops = {
+    .owner = THIS_MODULE,
+    .open = wmi_stats_open,
+    .read = seq_read,
+    .write = wmi_stats_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+/*
+ * WMI latency and failure injection
+ *
+ * Write "GUID METHOD DELAY_US FAIL_EVERY" to sleep DELAY_US before every
+ * call of that method and fail every FAIL_EVERYth one with AE_ERROR;
+ * "GUID METHOD 0 0" drops the rule and "clear" drops all of them. Method
+ * ids from ACER_WMI_STATS_METHODS up share one rule. Reading lists the
+ * active rules with the number of failures injected so far.
+ */
+#define WMI_INJECT_MAX_DELAY_US	1000000
+
+static int wmi_inject_show(struct seq_file *m, void *v)
+{
+    struct acer_wmi_inject inj;
+
+    seq_puts(m, "# guid method delay_us fail_every injected\n");
+    for (int g = 0; g < ACER_WMI_GUID_MAX; g++) {
+        for (int i = 0; i <= ACER_WMI_STATS_METHODS; i++) {
+            spin_lock(&acer_wmi_stats_lock);
+            inj = acer_wmi_inject[g][i];
+            spin_unlock(&acer_wmi_stats_lock);
+            if (!inj.delay_us && !inj.fail_every)
+                continue;
+
+            seq_printf(m, "%d ", g + 3);
+            if (i < ACER_WMI_STATS_METHODS)
+                seq_printf(m, "0x%02x ", i);
+            else
+                seq_puts(m, "other ");
+            seq_printf(m, "%u %u %llu\n", inj.delay_us, inj.fail_every, inj.injected);
+        }
+    }
+    return 0;
+}
+
+static int wmi_inject_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, wmi_inject_show, NULL);
+}
+
+static ssize_t wmi_inject_write(struct file *file, const char __user *ubuf,
+                                size_t count, loff_t *ppos)
+{
+    unsigned int guid, delay_us, fail_every;
+    struct acer_wmi_inject *inj;
+    char buf[64];
+    int method;
+
+    if (!capable(CAP_SYS_ADMIN))
+        return -EPERM;
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (sysfs_streq(buf, "clear")) {
+        spin_lock(&acer_wmi_stats_lock);
+        memset(acer_wmi_inject, 0, sizeof(acer_wmi_inject));
+        spin_unlock(&acer_wmi_stats_lock);
+        return count;
+    }
+
+    if (sscanf(buf, "%u %i %u %u", &guid, &method, &delay_us, &fail_every) != 4 ||
+        guid < 3 || guid > 5 || method < 0 || delay_us > WMI_INJECT_MAX_DELAY_US)
+        return -EINVAL;
+
+    inj = &acer_wmi_inject[guid - 3][min_t(u32, method, ACER_WMI_STATS_METHODS)];
+    spin_lock(&acer_wmi_stats_lock);
+    *inj = (struct acer_wmi_inject) { .delay_us = delay_us, .fail_every = fail_every };
+    spin_unlock(&acer_wmi_stats_lock);
+
+    pr_info("wmi_inject: guid=%u method=0x%x delay_us=%u fail_every=%u\n", guid, method,
+            delay_us, fail_every);
+    return count;
+}
+
+static const struct file_operations wmi_inject_fops = {
+    .owner = THIS_MODULE,
+    .open = wmi_inject_open,
+    .read = seq_read,
+    .write = wmi_inject_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+/*
+ * Firmware model switch
+ *
+ * "on" resets the model to the captured state and routes every WMI call to
+ * it, "off" goes back to the firmware. Both drop the driver caches, which
+ * describe the other side. "reset" reseeds the model; "ac 0|1",
+ * "load CPU GPU" (percent), "ambient C" and "tau TEMP_MS FAN_MS" program
+ * the thermal model. Reading shows the model state.
+ */
+#define WMI_EMULATE_MAX_TAU_MS	600000
+
+static int wmi_emulate_show(struct seq_file *m, void *v)
+{
+    struct acer_wmi_emu *emu = &acer_wmi_emu;
+
+    seq_printf(m, "enabled=%d\n", READ_ONCE(acer_wmi_emulate));
+    mutex_lock(&acer_wmi_emu_lock);
+    acer_wmi_emu_advance(emu);
+    seq_printf(m, "ac=%d load=%u,%u ambient_c=%d tau_ms=%u,%u\n", emu->on_ac, emu->load[0],
+               emu->load[1], emu->ambient_mc / 1000, emu->tau_ms[0], emu->tau_ms[1]);
+    seq_printf(m, "profile=0x%02x fan_mode=%u,%u fan_level=%u,%u\n",
+               emu->misc[ACER_WMID_MISC_SETTING_PLATFORM_PROFILE], emu->fan_mode[0],
+               emu->fan_mode[1], emu->fan_level[0], emu->fan_level[1]);
+    seq_printf(m, "temp_mc=%d,%d rpm=%d,%d\n", emu->temp_mc[0], emu->temp_mc[1], emu->rpm[0],
+               emu->rpm[1]);
+    seq_printf(m, "zones=%06x,%06x,%06x,%06x logo=%*phN battery=%u,%u led_wakes=%llu\n",
+               emu->zone[0], emu->zone[1], emu->zone[2], emu->zone[3],
+               (int)sizeof(emu->logo), emu->logo, emu->battery[0], emu->battery[1],
+               emu->led_wakes);
+    mutex_unlock(&acer_wmi_emu_lock);
+    return 0;
+}
+
+static int wmi_emulate_open(struct inode *inode, struct file *file)
+{
+    return single_open(file, wmi_emulate_show, NULL);
+}
+
+static void wmi_emulate_set(bool on)
+{
+    if (on)
+        acer_wmi_emu_reset();
+    WRITE_ONCE(acer_wmi_emulate, on);
+
+    acer_caches_reload();
+}
+
+static ssize_t wmi_emulate_write(struct file *file, const char __user *ubuf,
+                                 size_t count, loff_t *ppos)
+{
+    struct acer_wmi_emu *emu = &acer_wmi_emu;
+    ssize_t ret = count;
+    unsigned int a, b;
+    char buf[64];
+    int c;
+
+    if (!capable(CAP_SYS_ADMIN))
+        return -EPERM;
+    if (count >= sizeof(buf))
+        return -EINVAL;
+    if (copy_from_user(buf, ubuf, count))
+        return -EFAULT;
+    buf[count] = '\0';
+
+    if (sysfs_streq(buf, "on") || sysfs_streq(buf, "off")) {
+        wmi_emulate_set(sysfs_streq(buf, "on"));
+        pr_info("wmi_emulate: %s\n", READ_ONCE(acer_wmi_emulate) ? "on" : "off");
+        return count;
+    }
+    if (sysfs_streq(buf, "reset")) {
+        acer_wmi_emu_reset();
+        return count;
+    }
+
+    mutex_lock(&acer_wmi_emu_lock);
+    /* Settle the model up to now, so the new parameters apply from here on */
+    acer_wmi_emu_advance(emu);
+    if (sscanf(buf, "ac %u", &a) == 1 && a <= 1) {
+        emu->on_ac = a;
+    } else if (sscanf(buf, "load %u %u", &a, &b) == 2 && a <= 100 && b <= 100) {
+        emu->load[0] = a;
+        emu->load[1] = b;
+    } else if (sscanf(buf, "ambient %d", &c) == 1 && c >= -20 && c <= 60) {
+        emu->ambient_mc = c * 1000;
+    } else if (sscanf(buf, "tau %u %u", &a, &b) == 2 &&
+               a <= WMI_EMULATE_MAX_TAU_MS && b <= WMI_EMULATE_MAX_TAU_MS) {
+        emu->tau_ms[0] = a;
+        emu->tau_ms[1] = b;
+    } else {
+        ret = -EINVAL;
+    }
+    mutex_unlock(&acer_wmi_emu_lock);
+
+    return ret;
+}
+
+static const struct file_operations wmi_emulate_fops = {
+    .owner = THIS_MODULE,
+    .open = wmi_emulate_open,
+    .read = seq_read,
+    .write = wmi_emulate_write,
+    .llseek = seq_lseek,
+    .release = single_release,
+};
+
+ static void remove_debugfs(void)
+ {
+     debugfs_remove_recursive(interface->debug.root);
+ }
+
+ static void __init create_debugfs(void)
+ {
+     interface->debug.root = debugfs_create_dir("nekro_sense", NULL);
+
+     if (quirks->four_zone_kb || has_cap(ACER_CAP_BACK_LOGO))
+         debugfs_create_file("lighting_bench", 0600, interface->debug.root, NULL,
+                             &lighting_bench_fops);
+     debugfs_create_file("wmi_raw", 0600, interface->debug.root, NULL, &wmi_raw_fops);
+     debugfs_create_file("wmi_stats", 0600, interface->debug.root, NULL, &wmi_stats_fops);
+     debugfs_create_file("wmi_inject", 0600, interface->debug.root, NULL, &wmi_inject_fops);
+     debugfs_create_file("wmi_emulate", 0600, interface->debug.root, NULL, &wmi_emulate_fops);
+     if (quirks->predator_v4)
+         debugfs_create_file("state_dump", 0400, interface->debug.root, NULL, &state_dump_fops);
+ }
 
  static const enum acer_wmi_predator_v4_sensor_id acer_wmi_temp_channel_to_sensor_id[] = {
     [0] = ACER_WMID_SENSOR_CPU_TEMPERATURE,
@@ -2416,31 +7691,25 @@ static const enum acer_wmi_predator_v4_sensor_id acer_wmi_fan_channel_to_sensor_
  static int acer_wmi_hwmon_read(struct device *dev, enum hwmon_sensor_types type,
                     u32 attr, int channel, long *val)
  {
-     u64 command = ACER_WMID_CMD_GET_PREDATOR_V4_SENSOR_READING;
      u64 result;
      int ret;
  
      switch (type) {
      case hwmon_temp:
-         command |= FIELD_PREP(ACER_PREDATOR_V4_SENSOR_INDEX_BIT_MASK,
-                       acer_wmi_temp_channel_to_sensor_id[channel]);
- 
-         ret = WMID_gaming_get_sys_info(command, &result);
+         ret = WMID_gaming_get_sensor_reading(acer_wmi_temp_channel_to_sensor_id[channel],
+                                              &result);
          if (ret < 0)
              return ret;
  
-         result = FIELD_GET(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, result);
          *val = result * MILLIDEGREE_PER_DEGREE;
          return 0;
      case hwmon_fan:
-         command |= FIELD_PREP(ACER_PREDATOR_V4_SENSOR_INDEX_BIT_MASK,
-                       acer_wmi_fan_channel_to_sensor_id[channel]);
- 
-         ret = WMID_gaming_get_sys_info(command, &result);
+         ret = WMID_gaming_get_sensor_reading(acer_wmi_fan_channel_to_sensor_id[channel],
+                                              &result);
          if (ret < 0)
              return ret;
  
-         *val = FIELD_GET(ACER_PREDATOR_V4_SENSOR_READING_BIT_MASK, result);
+         *val = result;
          return 0;
      default:
          return -EOPNOTSUPP;
@@ -2536,6 +7805,8 @@ static const enum acer_wmi_predator_v4_sensor_id acer_wmi_fan_channel_to_sensor_
      if (err)
          goto error_put;
 
+     create_debugfs();
+
      return 0;
 
  error_put:
@@ -2553,6 +7824,7 @@ static const enum acer_wmi_predator_v4_sensor_id acer_wmi_fan_channel_to_sensor_
      if (wmi_has_guid(ACERWMID_EVENT_GUID))
          wmi_remove_notify_handler(ACERWMID_EVENT_GUID);
 
+     remove_debugfs();
      platform_device_unregister(acer_platform_device);
      platform_driver_unregister(&acer_platform_driver);
 
@@ -2561,3 +7833,7 @@ static const enum acer_wmi_predator_v4_sensor_id acer_wmi_fan_channel_to_sensor_
  
  module_init(acer_wmi_init);
  module_exit(acer_wmi_exit);
+
+ #ifdef NEKRO_SENSE_KUNIT_TEST
+ #include "nekro_sense_test.c"
+ #endif
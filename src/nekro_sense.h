@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later WITH Linux-syscall-note */
+/*
+ * nekro_sense userspace ABI
+ *
+ * The generic netlink family and the /dev/nekro_sense control device. The
+ * driver includes this header too, so daemons can build their messages
+ * from these definitions instead of copying the layouts.
+ */
+
+#ifndef _NEKRO_SENSE_H
+#define _NEKRO_SENSE_H
+
+#include <linux/types.h>
+#include <linux/ioctl.h>
+
+/* Generic netlink */
+
+#define NEKRO_GENL_NAME		"nekro_sense"
+#define NEKRO_GENL_VERSION	1
+
+enum nekro_genl_cmd {
+    NEKRO_CMD_UNSPEC,
+    NEKRO_CMD_GET,
+    NEKRO_CMD_SET,
+    NEKRO_CMD_EVENT,		/* multicast only */
+    NEKRO_CMD_ALERT,		/* multicast only */
+    __NEKRO_CMD_MAX,
+};
+
+enum nekro_genl_attr {
+    NEKRO_ATTR_UNSPEC,
+    NEKRO_ATTR_PROFILE,		/* u8, 0 low-power … 4 performance */
+    NEKRO_ATTR_FAN_CPU,		/* u8, percent, 0 = auto */
+    NEKRO_ATTR_FAN_GPU,		/* u8, percent, 0 = auto */
+    NEKRO_ATTR_KB_ZONES,	/* struct nekro_genl_kb_zones */
+    NEKRO_ATTR_KB_EFFECT,	/* struct nekro_genl_kb_effect */
+    NEKRO_ATTR_LOGO,		/* struct nekro_genl_logo */
+    NEKRO_ATTR_BATTERY_LIMITER,	/* u8, 0/1 */
+    NEKRO_ATTR_BATTERY_CALIBRATION,	/* u8, 0/1, read-only */
+    NEKRO_ATTR_USB_CHARGING,	/* u8, 0/10/20/30 */
+    NEKRO_ATTR_TEMP_ALERT,	/* u8, threshold in °C, 0 = off */
+    NEKRO_ATTR_EVENT_FUNCTION,	/* u8, event_return_value.function */
+    NEKRO_ATTR_EVENT_KEY,	/* u8, event_return_value.key_num */
+    NEKRO_ATTR_ALERT_SENSOR,	/* u8, 0 CPU, 1 GPU */
+    NEKRO_ATTR_ALERT_TEMP,	/* u8, °C */
+    NEKRO_ATTR_ALERT_ACTIVE,	/* u8, 1 above threshold, 0 back below */
+    NEKRO_ATTR_LCD_OVERRIDE,	/* u8, 0/1 */
+    NEKRO_ATTR_BACKLIGHT_TIMEOUT,	/* u8, 0/1 */
+    NEKRO_ATTR_BOOT_ANIMATION_SOUND,	/* u8, 0/1 */
+    __NEKRO_ATTR_MAX,
+};
+#define NEKRO_ATTR_MAX		(__NEKRO_ATTR_MAX - 1)
+
+enum {
+    NEKRO_GENL_MCGRP_EVENTS,	/* "events" */
+};
+
+struct nekro_genl_kb_zones {
+    __u8 zone[4][3];		/* R, G, B for zones 1-4 */
+    __u8 brightness;		/* 0-100 */
+} __attribute__((packed));
+
+struct nekro_genl_kb_effect {
+    __u8 mode, speed, brightness, direction;
+    __u8 red, green, blue;
+} __attribute__((packed));
+
+struct nekro_genl_logo {
+    __u8 red, green, blue;
+    __u8 brightness;		/* 0-100 */
+    __u8 enable;		/* 0/1 */
+} __attribute__((packed));
+
+/* Control device, /dev/nekro_sense */
+
+enum nekro_op_type {
+    NEKRO_OP_NOP,
+    NEKRO_OP_SET_PROFILE,
+    NEKRO_OP_SET_FAN,
+    NEKRO_OP_SET_ZONE,
+    NEKRO_OP_SET_LOGO,
+    NEKRO_OP_SET_BATTERY_LIMITER,
+    NEKRO_OP_READ_SENSORS,
+};
+
+struct nekro_op_zone {
+    __u8 zone;			/* 0-3 */
+    __u8 red, green, blue;
+    __u8 brightness;		/* 0-100, for all zones */
+} __attribute__((packed));
+
+struct nekro_op_sensors {
+    __u16 cpu_temp;		/* °C */
+    __u16 gpu_temp;		/* °C */
+    __u16 cpu_fan_rpm;
+    __u16 gpu_fan_rpm;
+} __attribute__((packed));
+
+/* 32 bytes */
+struct nekro_op {
+    __u32 type;			/* NEKRO_OP_* */
+    __s32 result;		/* out: 0 or -errno */
+    union {
+        __u8 profile;		/* as NEKRO_ATTR_PROFILE */
+        struct {
+            __u8 cpu, gpu;	/* 0-100, 0 = auto */
+        } fan;
+        struct nekro_op_zone zone;
+        struct nekro_genl_logo logo;
+        __u8 battery_limiter;	/* 0/1 */
+        struct nekro_op_sensors sensors;	/* out */
+        __u8 raw[24];
+    };
+} __attribute__((packed));
+
+/* 16 bytes */
+struct nekro_op_batch {
+    __u64 ops;			/* user pointer to struct nekro_op[count] */
+    __u32 count;		/* 1-NEKRO_OP_BATCH_MAX */
+    __u32 flags;		/* must be 0 */
+} __attribute__((packed));
+
+#define NEKRO_OP_BATCH_MAX	64
+#define NEKRO_IOC_BATCH		_IOWR('N', 0x01, struct nekro_op_batch)
+
+#endif /* _NEKRO_SENSE_H */
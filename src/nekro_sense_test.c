@@ -0,0 +1,634 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * KUnit tests for nekro_sense
+ *
+ * Included at the end of nekro_sense.c when the module is built with
+ * NEKRO_KUNIT=1 against a kernel with CONFIG_KUNIT, so the static parsers
+ * and setters can be called directly. The suites run when the module loads.
+ * "make host-test" builds them into the host program as well.
+ *
+ * The firmware tests route their own task's calls to the firmware model and
+ * count only those, so they never touch the EC, and the workers and sysfs
+ * users running meanwhile neither reach the model nor skew the counts. They
+ * take the same locks as the sysfs paths, stop the workers for the duration
+ * and reload every cache from the firmware afterwards.
+ */
+
+#include <kunit/test.h>
+
+/* fan_speed_parse */
+
+static void nekro_fan_speed_parse_test(struct kunit *test)
+{
+    static const char * const bad[] = {
+        "", ",", "50", "50,", ",50", "101,0", "0,101", "-1,0", "50,50,50",
+        "50;50", "50,50x", "4294967297,0", "0,4294967346", "256,0",
+    };
+    u8 cpu = 0xAA, gpu = 0xAA;
+
+    KUNIT_EXPECT_EQ(test, fan_speed_parse("0,0", &cpu, &gpu), 0);
+    KUNIT_EXPECT_EQ(test, cpu, 0);
+    KUNIT_EXPECT_EQ(test, gpu, 0);
+    KUNIT_EXPECT_EQ(test, fan_speed_parse("100,35", &cpu, &gpu), 0);
+    KUNIT_EXPECT_EQ(test, cpu, 100);
+    KUNIT_EXPECT_EQ(test, gpu, 35);
+    KUNIT_EXPECT_EQ(test, fan_speed_parse("7,80\n", &cpu, &gpu), 0);
+    KUNIT_EXPECT_EQ(test, cpu, 7);
+    KUNIT_EXPECT_EQ(test, gpu, 80);
+
+    for (int i = 0; i < ARRAY_SIZE(bad); i++) {
+        cpu = gpu = 0xAA;
+        KUNIT_EXPECT_EQ_MSG(test, fan_speed_parse(bad[i], &cpu, &gpu), -EINVAL,
+                            "input \"%s\"", bad[i]);
+        /* Nothing is written on failure */
+        KUNIT_EXPECT_EQ(test, cpu, 0xAA);
+        KUNIT_EXPECT_EQ(test, gpu, 0xAA);
+    }
+}
+
+/* sysfs_input_copy */
+
+static void nekro_sysfs_input_copy_test(struct kunit *test)
+{
+    char tmp[8];
+
+    KUNIT_EXPECT_EQ(test, sysfs_input_copy(tmp, sizeof(tmp), "50,50\n", 6), 0);
+    KUNIT_EXPECT_STREQ(test, tmp, "50,50");
+    KUNIT_EXPECT_EQ(test, sysfs_input_copy(tmp, sizeof(tmp), "1234567", 7), 0);
+    KUNIT_EXPECT_STREQ(test, tmp, "1234567");
+    /* count is honoured even when buf is not terminated there */
+    KUNIT_EXPECT_EQ(test, sysfs_input_copy(tmp, sizeof(tmp), "ab\ncd", 3), 0);
+    KUNIT_EXPECT_STREQ(test, tmp, "ab");
+
+    KUNIT_EXPECT_EQ(test, sysfs_input_copy(tmp, sizeof(tmp), "", 0), -EINVAL);
+    KUNIT_EXPECT_EQ(test, sysfs_input_copy(tmp, sizeof(tmp), "12345678", 8), -EINVAL);
+}
+
+/* lighting_parse_* */
+
+static void nekro_lighting_parse_rgb_test(struct kunit *test)
+{
+    u64 rgb;
+
+    KUNIT_EXPECT_EQ(test, lighting_parse_rgb("00ff80", &rgb), 0);
+    KUNIT_EXPECT_EQ(test, rgb, 0x00FF80ULL);
+    KUNIT_EXPECT_EQ(test, lighting_parse_rgb("FFFFFF", &rgb), 0);
+    KUNIT_EXPECT_EQ(test, rgb, 0xFFFFFFULL);
+
+    KUNIT_EXPECT_EQ(test, lighting_parse_rgb("fff", &rgb), -EINVAL);
+    KUNIT_EXPECT_EQ(test, lighting_parse_rgb("1000000", &rgb), -EINVAL);
+    KUNIT_EXPECT_EQ(test, lighting_parse_rgb("gg0000", &rgb), -EINVAL);
+    KUNIT_EXPECT_EQ(test, lighting_parse_rgb("", &rgb), -EINVAL);
+}
+
+static void nekro_lighting_parse_zones_test(struct kunit *test)
+{
+    static const char * const bad[] = {
+        "ff0000,00ff00,0000ff,ffffff",
+        "ff0000,00ff00,0000ff,ffffff,101",
+        "ff0000,00ff00,0000ff,ffffff,",
+        "ff0000,00ff00,0000ff,fffff,50",
+        "ff0000,00ff00,0000ff,ffffff,50,1",
+        "ff0000,00ff00,0000ff",
+    };
+    struct kb_state kb = {};
+    char s[64];
+
+    strscpy(s, "ff0000,00ff00,0000ff,123456,40", sizeof(s));
+    KUNIT_ASSERT_EQ(test, lighting_parse_zones(s, &kb), 0);
+    KUNIT_EXPECT_EQ(test, kb.zones.zone1, 0xFF0000ULL);
+    KUNIT_EXPECT_EQ(test, kb.zones.zone2, 0x00FF00ULL);
+    KUNIT_EXPECT_EQ(test, kb.zones.zone3, 0x0000FFULL);
+    KUNIT_EXPECT_EQ(test, kb.zones.zone4, 0x123456ULL);
+    KUNIT_EXPECT_EQ(test, kb.zones.brightness, 40);
+    KUNIT_EXPECT_EQ(test, kb.per_zone, 1);
+
+    for (int i = 0; i < ARRAY_SIZE(bad); i++) {
+        strscpy(s, bad[i], sizeof(s));
+        KUNIT_EXPECT_EQ_MSG(test, lighting_parse_zones(s, &kb), -EINVAL,
+                            "input \"%s\"", bad[i]);
+    }
+}
+
+static void nekro_lighting_parse_effect_test(struct kunit *test)
+{
+    static const char * const bad[] = {
+        "8,0,50,0,0,0,0",		/* mode */
+        "0,10,50,0,0,0,0",		/* speed */
+        "0,0,101,0,0,0,0",		/* brightness */
+        "0,0,50,3,0,0,0",		/* direction */
+        "3,5,50,0,0,0,0",		/* wave needs a direction */
+        "4,5,50,0,0,0,0",		/* so does shifting */
+        "0,0,50,0,256,0,0",
+        "0,0,50,0,4294967296,0,0",
+        "0,0,50,0,0,0",
+        "0,0,50,0,0,0,0,0",
+        "0,0,50,0,0,0,0x",
+    };
+    struct kb_state kb = {};
+
+    /* Static ignores speed and direction */
+    KUNIT_ASSERT_EQ(test, lighting_parse_effect("0,5,60,1,10,20,30", &kb), 0);
+    KUNIT_EXPECT_EQ(test, kb.mode, 0);
+    KUNIT_EXPECT_EQ(test, kb.speed, 0);
+    KUNIT_EXPECT_EQ(test, kb.brightness, 60);
+    KUNIT_EXPECT_EQ(test, kb.direction, 0);
+    KUNIT_EXPECT_EQ(test, kb.red, 10);
+    KUNIT_EXPECT_EQ(test, kb.green, 20);
+    KUNIT_EXPECT_EQ(test, kb.blue, 30);
+    KUNIT_EXPECT_EQ(test, kb.per_zone, 0);
+
+    /* Wave ignores the color */
+    KUNIT_ASSERT_EQ(test, lighting_parse_effect("3,4,100,2,10,20,30", &kb), 0);
+    KUNIT_EXPECT_EQ(test, kb.speed, 4);
+    KUNIT_EXPECT_EQ(test, kb.direction, 2);
+    KUNIT_EXPECT_EQ(test, kb.red, 0);
+    KUNIT_EXPECT_EQ(test, kb.green, 0);
+    KUNIT_EXPECT_EQ(test, kb.blue, 0);
+
+    for (int i = 0; i < ARRAY_SIZE(bad); i++)
+        KUNIT_EXPECT_EQ_MSG(test, lighting_parse_effect(bad[i], &kb), -EINVAL,
+                            "input \"%s\"", bad[i]);
+}
+
+static void nekro_lighting_parse_logo_test(struct kunit *test)
+{
+    static const char * const bad[] = {
+        "ff8000", "ff8000,101", "ff8000,50,2", "ff800,50", "ff8000,50,1,1", "ff8000,",
+    };
+    struct logo_state logo = {};
+    char s[32];
+
+    strscpy(s, "ff8001,70", sizeof(s));
+    KUNIT_ASSERT_EQ(test, lighting_parse_logo(s, &logo), 0);
+    KUNIT_EXPECT_EQ(test, logo.red, 0xFF);
+    KUNIT_EXPECT_EQ(test, logo.green, 0x80);
+    KUNIT_EXPECT_EQ(test, logo.blue, 0x01);
+    KUNIT_EXPECT_EQ(test, logo.brightness, 70);
+    KUNIT_EXPECT_EQ(test, logo.enable, 1);
+
+    /* Enable follows the brightness unless given */
+    strscpy(s, "ffffff,0", sizeof(s));
+    KUNIT_ASSERT_EQ(test, lighting_parse_logo(s, &logo), 0);
+    KUNIT_EXPECT_EQ(test, logo.enable, 0);
+    strscpy(s, "ffffff,30,0", sizeof(s));
+    KUNIT_ASSERT_EQ(test, lighting_parse_logo(s, &logo), 0);
+    KUNIT_EXPECT_EQ(test, logo.brightness, 30);
+    KUNIT_EXPECT_EQ(test, logo.enable, 0);
+
+    for (int i = 0; i < ARRAY_SIZE(bad); i++) {
+        strscpy(s, bad[i], sizeof(s));
+        KUNIT_EXPECT_EQ_MSG(test, lighting_parse_logo(s, &logo), -EINVAL,
+                            "input \"%s\"", bad[i]);
+    }
+}
+
+/* acer_thermal_profile_next */
+
+struct nekro_profile_case {
+    bool cycle;
+    int max_perf;
+    int last_non_turbo;
+    u8 current_tp;
+    bool on_ac;
+    int next;
+};
+
+static void nekro_thermal_profile_next_test(struct kunit *test)
+{
+    enum {
+        Q = ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET,
+        B = ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED,
+        P = ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE,
+        T = ACER_PREDATOR_V4_THERMAL_PROFILE_TURBO,
+        E = ACER_PREDATOR_V4_THERMAL_PROFILE_ECO,
+    };
+    static const struct nekro_profile_case cases[] = {
+        /* Cycling: eco, quiet, balanced, performance, turbo, quiet */
+        { true, T, B, E, true, Q },
+        { true, T, B, Q, true, B },
+        { true, T, B, B, true, P },
+        { true, T, B, P, true, T },
+        { true, T, B, T, true, Q },
+        /* Without turbo, performance falls back to the last profile */
+        { true, P, Q, P, true, Q },
+        /* Toggling: any profile to the maximum and back */
+        { false, T, B, B, true, T },
+        { false, T, Q, T, true, Q },
+        { false, T, E, E, true, T },
+        { false, T, INT_MIN, T, true, INT_MIN },
+        /* On battery only eco and balanced alternate */
+        { true, T, B, E, false, B },
+        { true, T, B, B, false, E },
+        { true, T, B, T, false, E },
+        { false, T, B, Q, false, E },
+    };
+    bool cycle;
+    int max_perf, last;
+
+    mutex_lock(&acer_profile_lock);
+    cycle = cycle_gaming_thermal_profile;
+    max_perf = acer_predator_v4_max_perf;
+    last = last_non_turbo_profile;
+
+    for (int i = 0; i < ARRAY_SIZE(cases); i++) {
+        const struct nekro_profile_case *c = &cases[i];
+
+        cycle_gaming_thermal_profile = c->cycle;
+        acer_predator_v4_max_perf = c->max_perf;
+        last_non_turbo_profile = c->last_non_turbo;
+        KUNIT_EXPECT_EQ_MSG(test, acer_thermal_profile_next(c->current_tp, c->on_ac), c->next,
+                            "case %d", i);
+    }
+
+    cycle_gaming_thermal_profile = cycle;
+    acer_predator_v4_max_perf = max_perf;
+    last_non_turbo_profile = last;
+    mutex_unlock(&acer_profile_lock);
+}
+
+/* Firmware call counts, against the firmware model */
+
+struct nekro_wmi_ctx {
+    int cpu_fan, gpu_fan;
+    u64 calls[ACER_WMI_GUID_MAX][ACER_WMI_STATS_METHODS + 1];
+};
+
+static u64 nekro_wmi_calls(enum acer_wmi_guid guid, u32 method_id)
+{
+    u64 calls;
+
+    spin_lock(&acer_wmi_stats_lock);
+    calls = acer_wmi_stats[guid][min_t(u32, method_id, ACER_WMI_STATS_METHODS)].task_calls;
+    spin_unlock(&acer_wmi_stats_lock);
+    return calls;
+}
+
+static void nekro_wmi_mark(struct nekro_wmi_ctx *ctx)
+{
+    spin_lock(&acer_wmi_stats_lock);
+    for (int g = 0; g < ACER_WMI_GUID_MAX; g++)
+        for (int i = 0; i <= ACER_WMI_STATS_METHODS; i++)
+            ctx->calls[g][i] = acer_wmi_stats[g][i].task_calls;
+    spin_unlock(&acer_wmi_stats_lock);
+}
+
+/* Calls to guid/method_id by the test since the last nekro_wmi_mark() */
+static u64 nekro_wmi_delta(struct nekro_wmi_ctx *ctx, enum acer_wmi_guid guid, u32 method_id)
+{
+    return nekro_wmi_calls(guid, method_id) - ctx->calls[guid][method_id];
+}
+
+/* All calls by the test since the last nekro_wmi_mark() */
+static u64 nekro_wmi_delta_all(struct nekro_wmi_ctx *ctx)
+{
+    u64 total = 0;
+
+    for (int g = 0; g < ACER_WMI_GUID_MAX; g++)
+        for (int i = 0; i <= ACER_WMI_STATS_METHODS; i++)
+            total += nekro_wmi_delta(ctx, g, i);
+    return total;
+}
+
+/* The workers call the firmware on their own, stopped as for suspend */
+static void nekro_wmi_workers_stop(void)
+{
+    cancel_delayed_work_sync(&thermal_lighting_work);
+    cancel_delayed_work_sync(&reactive_lighting_work);
+    cancel_delayed_work_sync(&lighting_idle_work);
+    cancel_delayed_work_sync(&battery_telemetry_work);
+    cancel_delayed_work_sync(&nekro_genl_alert_work);
+}
+
+/* And restarted as on resume, for the ones that were enabled */
+static void nekro_wmi_workers_start(void)
+{
+    mutex_lock(&lighting_lock);
+    thermal_lighting_kick(&thermal_lighting);
+    mutex_unlock(&lighting_lock);
+    mod_delayed_work(system_wq, &reactive_lighting_work, 0);
+    lighting_idle_kick();
+    if (has_cap(ACER_CAP_PREDATOR_SENSE) && READ_ONCE(battery_telemetry.interval_s))
+        schedule_delayed_work(&battery_telemetry_work, 0);
+    if (READ_ONCE(nekro_genl_alert_threshold))
+        schedule_delayed_work(&nekro_genl_alert_work, 0);
+}
+
+static int nekro_wmi_init(struct kunit *test)
+{
+    struct nekro_wmi_ctx *ctx;
+
+    ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+    if (!ctx)
+        return -ENOMEM;
+
+    nekro_wmi_workers_stop();
+
+    /*
+     * KUnit runs init/test and exit in different threads, so the lock is
+     * only held for each step, never across them. Init and the test share
+     * a thread, which is the one routed to the model.
+     */
+    mutex_lock(&lighting_lock);
+    ctx->cpu_fan = cpu_fan_speed;
+    ctx->gpu_fan = gpu_fan_speed;
+
+    acer_wmi_emu_reset();
+    WRITE_ONCE(acer_wmi_emulate_task, current);
+    lighting_state_invalidate();
+    mutex_unlock(&lighting_lock);
+    battery_health_invalidate();
+    acer_settings_invalidate();
+
+    test->priv = ctx;
+    return 0;
+}
+
+/*
+ * The model kept whatever the tests wrote and the caches may hold it; the
+ * real firmware still has the old state, so read all of it back.
+ */
+static void nekro_wmi_exit(struct kunit *test)
+{
+    struct nekro_wmi_ctx *ctx = test->priv;
+
+    WRITE_ONCE(acer_wmi_emulate_task, NULL);
+    mutex_lock(&lighting_lock);
+    cpu_fan_speed = ctx->cpu_fan;
+    gpu_fan_speed = ctx->gpu_fan;
+    mutex_unlock(&lighting_lock);
+    acer_caches_reload();
+
+    nekro_wmi_workers_start();
+}
+
+struct nekro_fan_case {
+    int cpu, gpu;
+    unsigned int behavior_calls, speed_calls;
+    u8 cpu_mode, gpu_mode;
+};
+
+static void nekro_set_fan_speed_test(struct kunit *test)
+{
+    static const struct nekro_fan_case cases[] = {
+        { 100, 100, 1, 0, ACER_WMI_EMU_FAN_MAX, ACER_WMI_EMU_FAN_MAX },
+        { 0, 0, 1, 0, ACER_WMI_EMU_FAN_AUTO, ACER_WMI_EMU_FAN_AUTO },
+        { 0, 60, 2, 1, ACER_WMI_EMU_FAN_AUTO, ACER_WMI_EMU_FAN_CUSTOM },
+        { 45, 0, 2, 1, ACER_WMI_EMU_FAN_CUSTOM, ACER_WMI_EMU_FAN_AUTO },
+        { 30, 70, 1, 2, ACER_WMI_EMU_FAN_CUSTOM, ACER_WMI_EMU_FAN_CUSTOM },
+    };
+    struct nekro_wmi_ctx *ctx = test->priv;
+
+    for (int i = 0; i < ARRAY_SIZE(cases); i++) {
+        const struct nekro_fan_case *c = &cases[i];
+
+        nekro_wmi_mark(ctx);
+        KUNIT_ASSERT_EQ(test, acer_set_fan_speed(c->cpu, c->gpu), AE_OK);
+        KUNIT_EXPECT_EQ_MSG(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                            ACER_WMID_SET_GAMING_FAN_BEHAVIOR_METHODID), c->behavior_calls,
+                            "%d,%d", c->cpu, c->gpu);
+        KUNIT_EXPECT_EQ_MSG(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                            ACER_WMID_SET_GAMING_FAN_SPEED_METHODID), c->speed_calls,
+                            "%d,%d", c->cpu, c->gpu);
+        KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), c->behavior_calls + c->speed_calls);
+        KUNIT_EXPECT_EQ(test, acer_wmi_emu.fan_mode[0], c->cpu_mode);
+        KUNIT_EXPECT_EQ(test, acer_wmi_emu.fan_mode[1], c->gpu_mode);
+        if (c->cpu_mode == ACER_WMI_EMU_FAN_CUSTOM)
+            KUNIT_EXPECT_EQ(test, acer_wmi_emu.fan_level[0], c->cpu);
+        if (c->gpu_mode == ACER_WMI_EMU_FAN_CUSTOM)
+            KUNIT_EXPECT_EQ(test, acer_wmi_emu.fan_level[1], c->gpu);
+        KUNIT_EXPECT_EQ(test, cpu_fan_speed, c->cpu);
+        KUNIT_EXPECT_EQ(test, gpu_fan_speed, c->gpu);
+    }
+
+    /* Out of range is refused before any call */
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_NE(test, acer_set_fan_speed(101, 50), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 0);
+}
+
+static void nekro_set_kb_status_test(struct kunit *test)
+{
+    struct nekro_wmi_ctx *ctx = test->priv;
+
+    mutex_lock(&lighting_lock);
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, set_kb_status(3, 4, 80, 2, 0, 0, 0), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                                          ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID), 1);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 1);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.kb[0], 3);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.kb[1], 4);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.kb[2], 80);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.kb[4], 2);
+    mutex_unlock(&lighting_lock);
+}
+
+static void nekro_set_per_zone_color_test(struct kunit *test)
+{
+    struct nekro_wmi_ctx *ctx = test->priv;
+    struct per_zone_color zones = {
+        .zone1 = 0x112233, .zone2 = 0x445566, .zone3 = 0x778899, .zone4 = 0xAABBCC,
+        .brightness = 55,
+    };
+
+    mutex_lock(&lighting_lock);
+    /* Effect, wake, then one method 6 call per zone */
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, __set_per_zone_color(&zones, true), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                                          ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID), 1);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                                          ACER_WMID_SET_GAMING_LED_METHODID), 1);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                                          ACER_WMID_SET_GAMING_RGB_KB_METHODID), 4);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 6);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.led_wakes, 1);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.zone[0], 0x112233);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.zone[1], 0x445566);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.zone[2], 0x778899);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.zone[3], 0xAABBCC);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.kb[0], 0);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.kb[2], 55);
+    KUNIT_EXPECT_TRUE(test, kb_state_valid);
+    KUNIT_EXPECT_EQ(test, current_kb_state.per_zone, 1);
+
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, __set_per_zone_color(&zones, false), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                                          ACER_WMID_SET_GAMING_LED_METHODID), 0);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 5);
+    mutex_unlock(&lighting_lock);
+}
+
+static void nekro_set_logo_status_test(struct kunit *test)
+{
+    struct nekro_wmi_ctx *ctx = test->priv;
+
+    mutex_lock(&lighting_lock);
+    /* Unknown state: color and the LBLE gate */
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, set_logo_status(1, 60, 0, 0x10, 0x20, 0x30), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4, 12), 1);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4,
+                                          ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID), 1);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 2);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.logo[0], 0x10);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.logo[1], 0x20);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.logo[2], 0x30);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.logo[3], 60);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.logo[4], 1);
+
+    /* Same state: nothing to send */
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, set_logo_status(1, 60, 0, 0x10, 0x20, 0x30), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 0);
+
+    /* Color only: one call */
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, set_logo_status(1, 60, 0, 0x40, 0x20, 0x30), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID4, 12), 1);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 1);
+
+    /* Enable change: both */
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, set_logo_status(0, 60, 0, 0x40, 0x20, 0x30), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 2);
+    KUNIT_EXPECT_EQ(test, acer_wmi_emu.logo[4], 0);
+
+    /* A failed call drops the shadow state, so the next write is complete */
+    spin_lock(&acer_wmi_stats_lock);
+    acer_wmi_inject[ACER_WMI_GUID4][12].fail_every = 1;
+    spin_unlock(&acer_wmi_stats_lock);
+    KUNIT_EXPECT_TRUE(test, ACPI_FAILURE(set_logo_status(0, 20, 0, 0x40, 0x20, 0x30)));
+    spin_lock(&acer_wmi_stats_lock);
+    acer_wmi_inject[ACER_WMI_GUID4][12] = (struct acer_wmi_inject){};
+    spin_unlock(&acer_wmi_stats_lock);
+    KUNIT_EXPECT_FALSE(test, logo_state_valid);
+
+    nekro_wmi_mark(ctx);
+    KUNIT_EXPECT_EQ(test, set_logo_status(0, 20, 0, 0x40, 0x20, 0x30), AE_OK);
+    KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 2);
+    mutex_unlock(&lighting_lock);
+}
+
+/* battery_limiter, battery_calibration, usb_charging: parsing, then the firmware calls */
+
+struct nekro_battery_case {
+    ssize_t (*store)(struct device *dev, struct device_attribute *attr,
+                     const char *buf, size_t count);
+    struct device_attribute *attr;
+    int index;
+};
+
+static void nekro_battery_store_test(struct kunit *test)
+{
+    static const char * const good[] = { "1", "0\n", "1\n", "0" };
+    static const char * const bad[] = { "", "2", "-1", "257", "1x", "0 1", "0x1", "on" };
+    const struct nekro_battery_case cases[] = {
+        { predator_battery_limit_store, &battery_limiter, 0 },
+        { preadtor_battery_calibration_store, &battery_calibration, 1 },
+    };
+    struct nekro_wmi_ctx *ctx = test->priv;
+
+    for (int i = 0; i < ARRAY_SIZE(cases); i++) {
+        const struct nekro_battery_case *c = &cases[i];
+
+        for (int j = 0; j < ARRAY_SIZE(good); j++) {
+            u8 val = good[j][0] - '0';
+
+            /* One set, then one status read to refill the cache */
+            nekro_wmi_mark(ctx);
+            KUNIT_EXPECT_EQ_MSG(test, c->store(NULL, c->attr, good[j], strlen(good[j])),
+                                (ssize_t)strlen(good[j]), "%s \"%s\"", c->attr->attr.name, good[j]);
+            KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID5,
+                                                  ACER_WMID_SET_BATTERY_HEALTH_CONTROL_METHODID), 1);
+            KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID5,
+                                                  ACER_WMID_GET_BATTERY_HEALTH_CONTROL_STATUS_METHODID), 1);
+            KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 2);
+            KUNIT_EXPECT_EQ(test, acer_wmi_emu.battery[c->index], val);
+            KUNIT_EXPECT_TRUE(test, battery_health_cache.valid);
+            KUNIT_EXPECT_EQ(test, battery_health_cache.status[c->index], val);
+        }
+
+        for (int j = 0; j < ARRAY_SIZE(bad); j++) {
+            nekro_wmi_mark(ctx);
+            KUNIT_EXPECT_EQ_MSG(test, c->store(NULL, c->attr, bad[j], strlen(bad[j])),
+                                (ssize_t)-EINVAL, "%s \"%s\"", c->attr->attr.name, bad[j]);
+            KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 0);
+        }
+    }
+}
+
+static void nekro_usb_charging_store_test(struct kunit *test)
+{
+    static const struct {
+        const char *buf;
+        int value;
+    } good[] = { { "10", 10 }, { "30\n", 30 }, { "20", 20 }, { "0\n", 0 } };
+    static const char * const bad[] = { "", "5", "40", "-10", "1o", "10 ", "99999999999" };
+    struct device_attribute *attr = &usb_charging.attr;
+    struct acer_setting *setting = &acer_settings[ACER_SETTING_USB_CHARGING];
+    struct nekro_wmi_ctx *ctx = test->priv;
+
+    for (int i = 0; i < ARRAY_SIZE(good); i++) {
+        const char *buf = good[i].buf;
+        int val = good[i].value;
+
+        /* One set, then one read back */
+        nekro_wmi_mark(ctx);
+        KUNIT_EXPECT_EQ_MSG(test, acer_setting_store(NULL, attr, buf, strlen(buf)),
+                            (ssize_t)strlen(buf), "input \"%s\"", buf);
+        KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID3, ACER_WMID_SET_FUNCTION), 1);
+        KUNIT_EXPECT_EQ(test, nekro_wmi_delta(ctx, ACER_WMI_GUID3, ACER_WMID_GET_FUNCTION), 1);
+        KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 2);
+        KUNIT_EXPECT_TRUE(test, setting->valid);
+        KUNIT_EXPECT_EQ(test, setting->cached, val);
+        for (unsigned int j = 0; j < setting->num_values; j++) {
+            if (setting->values[j].value == val)
+                KUNIT_EXPECT_EQ(test, acer_wmi_emu.usb_charging, setting->values[j].get_out);
+        }
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(bad); i++) {
+        nekro_wmi_mark(ctx);
+        KUNIT_EXPECT_EQ_MSG(test, acer_setting_store(NULL, attr, bad[i], strlen(bad[i])),
+                            (ssize_t)-EINVAL, "input \"%s\"", bad[i]);
+        KUNIT_EXPECT_EQ(test, nekro_wmi_delta_all(ctx), 0);
+    }
+}
+
+static struct kunit_case nekro_parse_cases[] = {
+    KUNIT_CASE(nekro_fan_speed_parse_test),
+    KUNIT_CASE(nekro_sysfs_input_copy_test),
+    KUNIT_CASE(nekro_lighting_parse_rgb_test),
+    KUNIT_CASE(nekro_lighting_parse_zones_test),
+    KUNIT_CASE(nekro_lighting_parse_effect_test),
+    KUNIT_CASE(nekro_lighting_parse_logo_test),
+    KUNIT_CASE(nekro_thermal_profile_next_test),
+    {}
+};
+
+static struct kunit_suite nekro_parse_suite = {
+    .name = "nekro_sense_parse",
+    .test_cases = nekro_parse_cases,
+};
+
+static struct kunit_case nekro_wmi_cases[] = {
+    KUNIT_CASE(nekro_set_fan_speed_test),
+    KUNIT_CASE(nekro_set_kb_status_test),
+    KUNIT_CASE(nekro_set_per_zone_color_test),
+    KUNIT_CASE(nekro_set_logo_status_test),
+    KUNIT_CASE(nekro_battery_store_test),
+    KUNIT_CASE(nekro_usb_charging_store_test),
+    {}
+};
+
+static struct kunit_suite nekro_wmi_suite = {
+    .name = "nekro_sense_wmi",
+    .init = nekro_wmi_init,
+    .exit = nekro_wmi_exit,
+    .test_cases = nekro_wmi_cases,
+};
+
+kunit_test_suites(&nekro_parse_suite, &nekro_wmi_suite);
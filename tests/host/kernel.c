@@ -0,0 +1,199 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Host implementations of the kernel functions the host tests reach
+ *
+ * The host build is single threaded, so locks are no-ops. Everything is
+ * built against kernel.h rather than the C library headers, whose types
+ * differ from the kernel's in places; the few libc calls used here are
+ * declared by hand.
+ */
+
+#include "kernel.h"
+
+int vprintf(const char *fmt, va_list ap);
+void *calloc(size_t n, size_t size);
+void free(void *p);
+
+struct timespec {
+    long tv_sec;
+    long tv_nsec;
+};
+
+#define CLOCK_MONOTONIC	1
+int clock_gettime(int clk, struct timespec *ts);
+int nanosleep(const struct timespec *req, struct timespec *rem);
+
+/* Driver log lines, printed with -v */
+bool nekro_host_verbose;
+
+int printk(const char *fmt, ...)
+{
+    va_list ap;
+    int ret;
+
+    if (!nekro_host_verbose)
+        return 0;
+    va_start(ap, fmt);
+    ret = vprintf(fmt, ap);
+    va_end(ap);
+    return ret;
+}
+
+const char *acpi_format_exception(acpi_status status)
+{
+    return status == AE_OK ? "AE_OK" : "AE_ERROR";
+}
+
+void *kzalloc(size_t size, gfp_t gfp)
+{
+    return calloc(1, size);
+}
+
+void kfree(const void *p)
+{
+    free((void *)p);
+}
+
+/* lib/kstrtox.c: optional '+', "0x" for base 16, one trailing newline */
+int kstrtoull(const char *s, unsigned int base, unsigned long long *res)
+{
+    unsigned long long v = 0;
+    int digits = 0;
+
+    if (*s == '+')
+        s++;
+    if ((base == 16 || base == 0) && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+        s += 2;
+        base = 16;
+    } else if (base == 0) {
+        base = s[0] == '0' ? 8 : 10;
+    }
+
+    for (;; s++, digits++) {
+        unsigned int d;
+
+        if (*s >= '0' && *s <= '9')
+            d = *s - '0';
+        else if (*s >= 'a' && *s <= 'f')
+            d = *s - 'a' + 10;
+        else if (*s >= 'A' && *s <= 'F')
+            d = *s - 'A' + 10;
+        else
+            break;
+        if (d >= base)
+            break;
+        if (v > (U64_MAX - d) / base)
+            return -ERANGE;
+        v = v * base + d;
+    }
+
+    if (!digits)
+        return -EINVAL;
+    if (*s == '\n')
+        s++;
+    if (*s)
+        return -EINVAL;
+
+    *res = v;
+    return 0;
+}
+
+int kstrtoint(const char *s, unsigned int base, int *res)
+{
+    unsigned long long v;
+    bool neg = *s == '-';
+    int ret;
+
+    ret = kstrtoull(s + neg, base, &v);
+    if (ret)
+        return ret;
+    if (v > (unsigned long long)INT_MAX + neg)
+        return -ERANGE;
+    *res = neg ? -(long long)v : (long long)v;
+    return 0;
+}
+
+int kstrtou8(const char *s, unsigned int base, u8 *res)
+{
+    unsigned long long v;
+    int ret;
+
+    ret = kstrtoull(s, base, &v);
+    if (ret)
+        return ret;
+    if (v > U8_MAX)
+        return -ERANGE;
+    *res = v;
+    return 0;
+}
+
+ssize_t strscpy(char *dst, const char *src, size_t size)
+{
+    if (!size)
+        return -E2BIG;
+    for (size_t i = 0; i < size; i++) {
+        dst[i] = src[i];
+        if (!src[i])
+            return i;
+    }
+    dst[size - 1] = '\0';
+    return -E2BIG;
+}
+
+s64 div_s64(s64 dividend, s32 divisor)
+{
+    return dividend / divisor;
+}
+
+ktime_t ktime_get(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (s64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+s64 ktime_us_delta(ktime_t later, ktime_t earlier)
+{
+    return (later - earlier) / NSEC_PER_USEC;
+}
+
+s64 ktime_ms_delta(ktime_t later, ktime_t earlier)
+{
+    return (later - earlier) / NSEC_PER_MSEC;
+}
+
+void usleep_range(unsigned long min, unsigned long max)
+{
+    struct timespec ts = { min / USEC_PER_SEC, (min % USEC_PER_SEC) * NSEC_PER_USEC };
+
+    nanosleep(&ts, NULL);
+}
+
+void mutex_lock(struct mutex *lock) { }
+void mutex_unlock(struct mutex *lock) { }
+void spin_lock(spinlock_t *lock) { }
+void spin_unlock(spinlock_t *lock) { }
+
+/* One task, and no deferred work: scheduled work never runs */
+struct task_struct *get_current(void)
+{
+    static struct task_struct task;
+
+    return &task;
+}
+
+struct workqueue_struct *system_wq;
+unsigned long jiffies;
+
+unsigned long msecs_to_jiffies(unsigned int m)
+{
+    return DIV_ROUND_UP(m * HZ, 1000);
+}
+
+bool schedule_delayed_work(struct delayed_work *dwork, unsigned long delay) { return true; }
+bool mod_delayed_work(struct workqueue_struct *wq, struct delayed_work *dwork,
+                      unsigned long delay) { return true; }
+bool cancel_delayed_work_sync(struct delayed_work *dwork) { return false; }
+
+void platform_profile_notify(struct device *dev) { }
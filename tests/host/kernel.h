@@ -0,0 +1,621 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Kernel API for the host build
+ *
+ * Force-included ahead of src/nekro_sense.c by "make host-test", in place of
+ * the kernel headers (the Makefile generates an empty file for each
+ * <linux/...> the driver includes). Types, constants and macros are defined
+ * here; functions are only declared. tests/host/kernel.c implements the ones
+ * the host tests reach, and nekro_host.c provides wmi_evaluate_method(). The
+ * compiler drops the rest of the driver with the code nothing calls, so
+ * anything missing shows up as a link error when a test starts using it.
+ */
+#ifndef _NEKRO_HOST_KERNEL_H
+#define _NEKRO_HOST_KERNEL_H
+
+#include <stddef.h>
+#include <stdarg.h>
+
+/* types and compiler */
+#define bool _Bool
+#define true 1
+#define false 0
+typedef unsigned long uintptr_t;
+typedef unsigned char u8; typedef unsigned short u16; typedef unsigned int u32; typedef unsigned long long u64;
+typedef signed char s8; typedef short s16; typedef int s32; typedef long long s64;
+typedef u16 __le16; typedef u32 __le32; typedef u64 __le64; typedef u16 __be16; typedef u32 __be32;
+typedef u8 __u8; typedef u16 __u16; typedef u32 __u32; typedef u64 __u64; typedef s32 __s32; typedef s64 __s64;
+typedef long ssize_t; typedef unsigned int umode_t; typedef long long loff_t; typedef unsigned int gfp_t;
+typedef u32 acpi_status; typedef u64 acpi_size; typedef s64 ktime_t; typedef unsigned int fmode_t;
+typedef u32 acpi_handle_t; typedef void *acpi_handle;
+#define __packed __attribute__((packed))
+#define __init
+#define __exit
+#define __user
+#define __maybe_unused __attribute__((unused))
+#define __must_check
+#define fallthrough __attribute__((fallthrough))
+#define KBUILD_MODNAME "nekro_sense"
+#define MODULE_AUTHOR(x)
+#define MODULE_DESCRIPTION(x)
+#define MODULE_LICENSE(x)
+#define MODULE_ALIAS(x)
+#define MODULE_PARM_DESC(a,b)
+#define module_param(a,b,c)
+#define module_param_named(a,b,c,d)
+#define module_init(x)
+#define module_exit(x)
+#define THIS_MODULE ((void*)0)
+#define EXPORT_SYMBOL(x)
+#define INT_MIN (-2147483647-1)
+#define INT_MAX 2147483647
+#define U8_MAX 255
+#define U16_MAX 65535
+#define U32_MAX 0xffffffffu
+#define U64_MAX 0xffffffffffffffffull
+#define S64_MAX 0x7fffffffffffffffll
+#define BIT(n) (1UL << (n))
+#define BIT_ULL(n) (1ULL << (n))
+#define GENMASK(h,l) (((~0UL) << (l)) & (~0UL >> (63 - (h))))
+#define GENMASK_ULL(h,l) (((~0ULL) << (l)) & (~0ULL >> (63 - (h))))
+#define FIELD_PREP(m,v) (((u64)(v) << __builtin_ctzll(m)) & (m))
+#define FIELD_GET(m,v) ((((u64)(v)) & (m)) >> __builtin_ctzll(m))
+#define ARRAY_SIZE(a) (sizeof(a)/sizeof((a)[0]))
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define min_t(t,a,b) ((t)(a)<(t)(b)?(t)(a):(t)(b))
+#define max_t(t,a,b) ((t)(a)>(t)(b)?(t)(a):(t)(b))
+#define clamp(v,lo,hi) min(max(v,lo),hi)
+#define clamp_val(v,lo,hi) clamp(v,lo,hi)
+#define clamp_t(t,v,lo,hi) ((t)clamp(v,lo,hi))
+#define DIV_ROUND_CLOSEST(a,b) (((a)+((b)/2))/(b))
+#define DIV_ROUND_UP(a,b) (((a)+(b)-1)/(b))
+#define container_of(p,t,m) ((t*)((char*)(p)-offsetof(t,m)))
+#define READ_ONCE(x) (x)
+#define WRITE_ONCE(x,v) ((x)=(v))
+#define likely(x) (x)
+#define unlikely(x) (x)
+#define IS_ERR(p) ((unsigned long)(p) > (unsigned long)-4096)
+#define PTR_ERR(p) ((long)(p))
+#define ERR_PTR(e) ((void*)(long)(e))
+#define IS_ERR_OR_NULL(p) (!(p) || IS_ERR(p))
+#define IS_ENABLED(x) 0
+#define BUILD_BUG_ON(c) _Static_assert(!(c), "bug")
+#define static_assert(c, ...) _Static_assert(c, "sa")
+#define sizeof_field(t,m) sizeof(((t*)0)->m)
+#define offsetofend(t,m) (offsetof(t,m)+sizeof_field(t,m))
+#define swap(a,b) do { __typeof__(a) __t=(a); (a)=(b); (b)=__t; } while(0)
+#define unreachable() __builtin_unreachable()
+#define EPERM 1
+#define ENOENT 2
+#define EIO 5
+#define ENXIO 6
+#define E2BIG 7
+#define EAGAIN 11
+#define ENOMEM 12
+#define EFAULT 14
+#define EBUSY 16
+#define EEXIST 17
+#define ENODEV 19
+#define EINVAL 22
+#define ENOSPC 28
+#define ERANGE 34
+#define ENOTTY 25
+#define ENOMSG 42
+#define ENODATA 61
+#define ETIME 62
+#define EMSGSIZE 90
+#define EOPNOTSUPP 95
+#define ETIMEDOUT 110
+#define EALREADY 114
+#define ENOTSUPP 524
+#define GFP_KERNEL 0
+#define GFP_ATOMIC 1
+#define PAGE_SIZE 4096
+#define HZ 250
+#define NSEC_PER_USEC 1000L
+#define NSEC_PER_MSEC 1000000L
+#define NSEC_PER_SEC 1000000000L
+#define USEC_PER_SEC 1000000L
+#define MSEC_PER_SEC 1000L
+#define MILLIDEGREE_PER_DEGREE 1000
+#define O_RDONLY 0
+#define O_WRONLY 1
+#define O_CREAT 0100
+#define O_TRUNC 01000
+#define S_IRUSR 0400
+#define S_IWUSR 0200
+int printk(const char *fmt, ...) __attribute__((format(printf,1,2)));
+#define pr_info(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_warn(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_debug(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_notice(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_info_ratelimited(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_warn_ratelimited(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_err_ratelimited(fmt, ...) printk(fmt, ##__VA_ARGS__)
+#define pr_warn_once(fmt, ...) printk(fmt, ##__VA_ARGS__)
+struct device; 
+int _dev_printk(const struct device *d, const char *fmt, ...) __attribute__((format(printf,2,3)));
+#define dev_err(d, fmt, ...) _dev_printk(d, fmt, ##__VA_ARGS__)
+#define dev_warn(d, fmt, ...) _dev_printk(d, fmt, ##__VA_ARGS__)
+#define dev_info(d, fmt, ...) _dev_printk(d, fmt, ##__VA_ARGS__)
+#define dev_dbg(d, fmt, ...) _dev_printk(d, fmt, ##__VA_ARGS__)
+#define WARN_ON(c) (c)
+#define WARN_ON_ONCE(c) (c)
+int sprintf(char *b, const char *f, ...) __attribute__((format(printf,2,3)));
+int snprintf(char *b, size_t n, const char *f, ...) __attribute__((format(printf,3,4)));
+int scnprintf(char *b, size_t n, const char *f, ...) __attribute__((format(printf,3,4)));
+int sysfs_emit(char *b, const char *f, ...) __attribute__((format(printf,2,3)));
+int sysfs_emit_at(char *b, int at, const char *f, ...) __attribute__((format(printf,3,4)));
+int sscanf(const char *b, const char *f, ...) __attribute__((format(scanf,2,3)));
+char *strncpy(char *, const char *, size_t); char *strsep(char **, const char *);
+size_t strlen(const char *); ssize_t strscpy(char *, const char *, size_t); int strcmp(const char*, const char*);
+int strncmp(const char*, const char*, size_t);
+char *strim(char *); char *skip_spaces(const char *); int sysfs_streq(const char *, const char *);
+int match_string(const char * const *a, size_t n, const char *s);
+#define sysfs_match_string(a, s) match_string(a, ARRAY_SIZE(a), s)
+void *memcpy(void *, const void *, size_t); void *memset(void *, int, size_t); int memcmp(const void*, const void*, size_t);
+void *memmove(void*, const void*, size_t);
+char *strchr(const char*, int); char *strnchr(const char*, size_t, int);
+int kstrtoint(const char *, unsigned int, int *); int kstrtouint(const char *, unsigned int, unsigned int *);
+int kstrtoull(const char *, unsigned int, unsigned long long *); int kstrtou8(const char *, unsigned int, u8 *);
+int kstrtobool(const char *, bool *); int kstrtoul(const char *, unsigned int, unsigned long *);
+int kstrtou16(const char*, unsigned int, u16*); int kstrtou32(const char*, unsigned int, u32*);
+int kstrtos32(const char*, unsigned int, s32*); int kstrtol(const char*, unsigned int, long*);
+int hex2bin(u8 *dst, const char *src, size_t count); int hex_to_bin(unsigned char ch);
+char *kasprintf(gfp_t, const char *, ...);
+void *kmalloc(size_t, gfp_t); void *kzalloc(size_t, gfp_t); void kfree(const void *); void *kcalloc(size_t, size_t, gfp_t);
+void *kmalloc_array(size_t, size_t, gfp_t); void *kvzalloc(size_t, gfp_t); void kvfree(const void*);
+void *kmemdup(const void *, size_t, gfp_t); void *memdup_user(const void __user *, size_t);
+void *vzalloc(size_t); void vfree(const void*);
+char *kstrdup(const char*, gfp_t);
+void msleep(unsigned int); void usleep_range(unsigned long, unsigned long); void udelay(unsigned long);
+unsigned long msleep_interruptible(unsigned int);
+#define set_bit(n, p) ((void)(*(p) |= BIT(n)))
+#define clear_bit(n, p) ((void)(*(p) &= ~BIT(n)))
+#define test_bit(n, p) (!!(*(p) & BIT(n)))
+#define test_and_set_bit(n,p) ({ bool __o = test_bit(n,p); set_bit(n,p); __o; })
+#define test_and_clear_bit(n,p) ({ bool __o = test_bit(n,p); clear_bit(n,p); __o; })
+#define hweight8(x) __builtin_popcount(x)
+#define hweight32(x) __builtin_popcount(x)
+#define hweight64(x) __builtin_popcountll(x)
+#define for_each_set_bit(b, addr, size) for ((b)=0;(b)<(size);(b)++) if (test_bit(b, addr))
+static inline u64 get_unaligned_le64(const void *p) { u64 v; memcpy(&v,p,8); return v; }
+static inline u32 get_unaligned_le32(const void *p) { u32 v; memcpy(&v,p,4); return v; }
+static inline u16 get_unaligned_le16(const void *p) { u16 v; memcpy(&v,p,2); return v; }
+static inline void put_unaligned_le64(u64 v, void *p) { memcpy(p,&v,8); }
+static inline void put_unaligned_le32(u32 v, void *p) { memcpy(p,&v,4); }
+static inline void put_unaligned_le16(u16 v, void *p) { memcpy(p,&v,2); }
+#define cpu_to_be64(x) __builtin_bswap64(x)
+#define cpu_to_le16(x) ((u16)(x))
+#define cpu_to_le32(x) ((u32)(x))
+#define cpu_to_le64(x) ((u64)(x))
+#define le16_to_cpu(x) ((u16)(x))
+#define le32_to_cpu(x) ((u32)(x))
+#define le64_to_cpu(x) ((u64)(x))
+/* time */
+ktime_t ktime_get(void); s64 ktime_to_ns(ktime_t); s64 ktime_to_us(ktime_t); s64 ktime_us_delta(ktime_t, ktime_t);
+ktime_t ktime_sub(ktime_t, ktime_t); ktime_t ktime_add_ms(ktime_t, u64); u64 ktime_get_ns(void); u64 ktime_get_boottime_ns(void);
+ktime_t ktime_get_boottime(void); s64 ktime_ms_delta(ktime_t, ktime_t); u64 ktime_get_real_seconds(void); s64 ktime_to_ms(ktime_t);
+ktime_t ms_to_ktime(u64); ktime_t ns_to_ktime(u64); ktime_t ktime_add(ktime_t, ktime_t);
+#define ktime_after(a,b) ((a)>(b))
+#define ktime_before(a,b) ((a)<(b))
+#define ktime_compare(a,b) ((a)<(b)?-1:(a)>(b))
+u64 get_jiffies_64(void); extern unsigned long jiffies;
+unsigned long msecs_to_jiffies(unsigned int); unsigned int jiffies_to_msecs(unsigned long);
+unsigned long round_jiffies_relative(unsigned long);
+#define time_after(a,b) ((long)((b)-(a))<0)
+#define time_before(a,b) time_after(b,a)
+#define time_after_eq(a,b) ((long)((a)-(b))>=0)
+u64 div_u64(u64, u32); u64 div64_u64(u64, u64); s64 div_s64(s64, s32);
+void sort(void *base, size_t num, size_t size, int (*cmp)(const void *, const void *), void (*swap)(void *, void *, int));
+/* locking */
+struct mutex { int x; }; struct spinlock { int x; }; typedef struct spinlock spinlock_t;
+#define DEFINE_MUTEX(n) struct mutex n
+#define DEFINE_SPINLOCK(n) spinlock_t n
+void mutex_init(struct mutex*); void mutex_lock(struct mutex *); void mutex_unlock(struct mutex *); int mutex_lock_interruptible(struct mutex*);
+int mutex_trylock(struct mutex*); void mutex_destroy(struct mutex*);
+#define lockdep_assert_held(l) ((void)(l))
+void spin_lock_init(spinlock_t*); void spin_lock(spinlock_t *); void spin_unlock(spinlock_t *);
+void spin_lock_irq(spinlock_t *); void spin_unlock_irq(spinlock_t *);
+#define spin_lock_irqsave(l,f) ((f)=0, spin_lock(l))
+#define spin_unlock_irqrestore(l,f) ((void)(f), spin_unlock(l))
+void spin_lock_bh(spinlock_t*); void spin_unlock_bh(spinlock_t*);
+#define guard(t) struct mutex *__g __attribute__((unused)) =
+#define scoped_guard(t, l) for (int __i = 0; __i < 1; __i++)
+typedef struct { int counter; } atomic_t; typedef struct { s64 counter; } atomic64_t;
+void atomic_set(atomic_t*, int); int atomic_read(const atomic_t*); void atomic_inc(atomic_t*); int atomic_inc_return(atomic_t*);
+void atomic64_set(atomic64_t*, s64); s64 atomic64_read(const atomic64_t*); void atomic64_inc(atomic64_t*); void atomic64_add(s64, atomic64_t*);
+s64 atomic64_inc_return(atomic64_t*); int atomic_xchg(atomic_t*, int); int atomic_cmpxchg(atomic_t*, int, int);
+#define ATOMIC_INIT(x) { (x) }
+#define ATOMIC64_INIT(x) { (x) }
+void smp_wmb(void); void smp_rmb(void); void smp_mb(void);
+/* wait */
+struct wait_queue_head { int x; }; typedef struct wait_queue_head wait_queue_head_t;
+#define DECLARE_WAIT_QUEUE_HEAD(n) wait_queue_head_t n
+void init_waitqueue_head(wait_queue_head_t*); void wake_up_interruptible(wait_queue_head_t*); void wake_up(wait_queue_head_t*);
+#define wait_event_interruptible(wq, c) ((void)(wq), (c) ? 0 : 0)
+#define wait_event_interruptible_timeout(wq, c, t) ((void)(wq), (c) ? (long)(t) : 0L)
+/* sched */
+struct task_struct { int pid; };
+struct task_struct *get_current(void);
+#define current get_current()
+/* workqueue / timer */
+struct work_struct { int x; }; struct delayed_work { struct work_struct work; };
+struct workqueue_struct; extern struct workqueue_struct *system_wq; extern struct workqueue_struct *system_long_wq;
+typedef void (*work_func_t)(struct work_struct *);
+#define INIT_WORK(w,f) ((void)(w),(void)(f))
+#define INIT_DELAYED_WORK(w,f) ((void)(w),(void)(f))
+#define DECLARE_WORK(n,f) struct work_struct n
+#define DECLARE_DELAYED_WORK(n,f) struct delayed_work n
+bool schedule_work(struct work_struct*); bool schedule_delayed_work(struct delayed_work*, unsigned long);
+bool mod_delayed_work(struct workqueue_struct*, struct delayed_work*, unsigned long);
+bool queue_work(struct workqueue_struct*, struct work_struct*); bool queue_delayed_work(struct workqueue_struct*, struct delayed_work*, unsigned long);
+bool cancel_work_sync(struct work_struct*); bool cancel_delayed_work_sync(struct delayed_work*); bool cancel_delayed_work(struct delayed_work*);
+void flush_work(struct work_struct*); bool flush_delayed_work(struct delayed_work*);
+struct delayed_work *to_delayed_work(struct work_struct*);
+struct workqueue_struct *alloc_ordered_workqueue(const char*, unsigned int, ...); void destroy_workqueue(struct workqueue_struct*);
+#define WQ_FREEZABLE 4
+#define WQ_HIGHPRI 16
+#define WQ_MEM_RECLAIM 8
+struct timer_list { int x; };
+#define timer_setup(t,f,fl) ((void)(t),(void)(f))
+int mod_timer(struct timer_list*, unsigned long); int del_timer_sync(struct timer_list*); int timer_delete_sync(struct timer_list*);
+#define from_timer(var, cb, field) container_of(cb, __typeof__(*var), field)
+#define timer_container_of(var, cb, field) container_of(cb, __typeof__(*var), field)
+/* device / sysfs */
+struct kobject { int x; };
+struct device { struct kobject kobj; struct device *parent; };
+struct attribute { const char *name; umode_t mode; };
+struct device_attribute { struct attribute attr; ssize_t (*show)(struct device *, struct device_attribute *, char *); ssize_t (*store)(struct device *, struct device_attribute *, const char *, size_t); };
+struct file; struct bin_attribute;
+struct bin_attribute { struct attribute attr; size_t size; void *private; ssize_t (*read)(struct file *, struct kobject *, const struct bin_attribute *, char *, loff_t, size_t); ssize_t (*write)(struct file *, struct kobject *, const struct bin_attribute *, char *, loff_t, size_t); };
+struct attribute_group { const char *name; umode_t (*is_visible)(struct kobject *, struct attribute *, int); struct attribute **attrs; const struct bin_attribute *const *bin_attrs_new; const struct bin_attribute *const *bin_attrs; };
+#define __ATTR(_name,_mode,_show,_store) { .attr = {.name = #_name, .mode = _mode}, .show = _show, .store = _store }
+#define __ATTR_RO(_name) { .attr = {.name = #_name, .mode = 0444}, .show = _name##_show }
+#define __ATTR_WO(_name) { .attr = {.name = #_name, .mode = 0200}, .store = _name##_store }
+#define __ATTR_RW(_name) __ATTR(_name, 0644, _name##_show, _name##_store)
+#define DEVICE_ATTR_RW(_name) struct device_attribute dev_attr_##_name = __ATTR_RW(_name)
+#define DEVICE_ATTR_RO(_name) struct device_attribute dev_attr_##_name = __ATTR_RO(_name)
+#define DEVICE_ATTR_WO(_name) struct device_attribute dev_attr_##_name = __ATTR_WO(_name)
+#define __BIN_ATTR(_name,_mode,_read,_write,_size) { .attr = {.name = #_name, .mode = _mode}, .size = _size, .read = _read, .write = _write }
+#define BIN_ATTR(_name,_mode,_read,_write,_size) struct bin_attribute bin_attr_##_name = __BIN_ATTR(_name,_mode,_read,_write,_size)
+int sysfs_create_group(struct kobject *, const struct attribute_group *); void sysfs_remove_group(struct kobject *, const struct attribute_group *);
+int sysfs_create_bin_file(struct kobject*, const struct bin_attribute*); void sysfs_remove_bin_file(struct kobject*, const struct bin_attribute*);
+struct kobject *kobject_create_and_add(const char*, struct kobject*); void kobject_put(struct kobject*);
+void sysfs_notify(struct kobject*, const char*, const char*);
+struct device *get_device(struct device*); void put_device(struct device*);
+void *dev_get_drvdata(const struct device*); void dev_set_drvdata(struct device*, void*);
+void *devm_kzalloc(struct device*, size_t, gfp_t);
+typedef void (*dr_action_t)(void*); int devm_add_action_or_reset(struct device*, dr_action_t, void*);
+/* platform */
+struct platform_device { struct device dev; }; 
+struct dev_pm_ops { int (*suspend)(struct device *); int (*resume)(struct device *); };
+struct device_driver { const char *name; const struct dev_pm_ops *pm; };
+struct platform_driver { struct device_driver driver; int (*probe)(struct platform_device*); void (*remove)(struct platform_device*); void (*shutdown)(struct platform_device*); };
+#define SIMPLE_DEV_PM_OPS(n, s, r) const struct dev_pm_ops n = { .suspend = s, .resume = r }
+#define PLATFORM_DEVID_NONE (-1)
+int platform_driver_register(struct platform_driver*); void platform_driver_unregister(struct platform_driver*);
+struct platform_device *platform_device_alloc(const char*, int); int platform_device_add(struct platform_device*);
+void platform_device_put(struct platform_device*); void platform_device_unregister(struct platform_device*);
+/* platform_profile */
+enum platform_profile_option { PLATFORM_PROFILE_LOW_POWER, PLATFORM_PROFILE_COOL, PLATFORM_PROFILE_QUIET, PLATFORM_PROFILE_BALANCED, PLATFORM_PROFILE_BALANCED_PERFORMANCE, PLATFORM_PROFILE_PERFORMANCE, PLATFORM_PROFILE_CUSTOM, PLATFORM_PROFILE_LAST };
+struct platform_profile_ops { int (*probe)(void *, unsigned long *); int (*profile_get)(struct device *, enum platform_profile_option *); int (*profile_set)(struct device *, enum platform_profile_option); };
+struct device *devm_platform_profile_register(struct device*, const char*, void*, const struct platform_profile_ops*);
+void platform_profile_notify(struct device*); int platform_profile_cycle(void);
+/* acpi / wmi */
+#define AE_OK 0
+#define AE_ERROR 1
+#define AE_BAD_PARAMETER 2
+#define AE_NOT_FOUND 3
+#define AE_NO_MEMORY 4
+#define AE_NOT_EXIST 5
+#define AE_BAD_DATA 6
+#define AE_TIME 7
+#define ACPI_FAILURE(s) ((s) != AE_OK)
+#define ACPI_SUCCESS(s) ((s) == AE_OK)
+#define ACPI_ALLOCATE_BUFFER ((acpi_size)-1)
+#define ACPI_TYPE_INTEGER 1
+#define ACPI_TYPE_STRING 2
+#define ACPI_TYPE_BUFFER 3
+#define ACPI_TYPE_PACKAGE 4
+struct acpi_buffer { acpi_size length; void *pointer; };
+union acpi_object { u32 type; struct { u32 type; u64 value; } integer; struct { u32 type; u32 length; u8 *pointer; } buffer; struct { u32 type; u32 length; char *pointer; } string; struct { u32 type; u32 count; union acpi_object *elements; } package; };
+acpi_status wmi_evaluate_method(const char*, u8, u32, const struct acpi_buffer*, struct acpi_buffer*);
+typedef void (*wmi_notify_handler)(union acpi_object *data, void *context);
+acpi_status wmi_install_notify_handler(const char*, wmi_notify_handler, void*); acpi_status wmi_remove_notify_handler(const char*);
+bool wmi_has_guid(const char*); const char *acpi_format_exception(acpi_status);
+int power_supply_is_system_supplied(void);
+/* fs */
+struct inode; struct file { loff_t f_pos; void *private_data; unsigned int f_flags; fmode_t f_mode; };
+struct poll_table_struct; typedef struct poll_table_struct poll_table; typedef unsigned int __poll_t;
+void poll_wait(struct file*, wait_queue_head_t*, poll_table*);
+#define EPOLLIN 1
+#define EPOLLOUT 4
+#define EPOLLRDNORM 0x40
+#define EPOLLWRNORM 0x100
+#define O_NONBLOCK 04000
+struct file_operations { void *owner; ssize_t (*read)(struct file*, char __user*, size_t, loff_t*); ssize_t (*write)(struct file*, const char __user*, size_t, loff_t*); int (*open)(struct inode*, struct file*); int (*release)(struct inode*, struct file*); long (*unlocked_ioctl)(struct file*, unsigned int, unsigned long); long (*compat_ioctl)(struct file*, unsigned int, unsigned long); __poll_t (*poll)(struct file*, poll_table*); loff_t (*llseek)(struct file*, loff_t, int); };
+loff_t noop_llseek(struct file*, loff_t, int); loff_t no_llseek(struct file*, loff_t, int); loff_t default_llseek(struct file*, loff_t, int);
+long compat_ptr_ioctl(struct file*, unsigned int, unsigned long);
+int nonseekable_open(struct inode*, struct file*); int simple_open(struct inode*, struct file*);
+ssize_t simple_read_from_buffer(void __user*, size_t, loff_t*, const void*, size_t);
+ssize_t simple_write_to_buffer(void*, size_t, loff_t*, const void __user*, size_t);
+struct file *filp_open(const char*, int, umode_t); int filp_close(struct file*, void*);
+ssize_t kernel_read(struct file*, void*, size_t, loff_t*); ssize_t kernel_write(struct file*, const void*, size_t, loff_t*);
+unsigned long copy_from_user(void*, const void __user*, unsigned long); unsigned long copy_to_user(void __user*, const void*, unsigned long);
+#define get_user(x, p) ((x) = *(p), 0)
+#define put_user(x, p) (*(p) = (x), 0)
+/* ioctl */
+#define _IOC(d,t,n,s) (((d)<<30)|((t)<<8)|(n)|((s)<<16))
+#define _IO(t,n) _IOC(0,t,n,0)
+#define _IOR(t,n,s) _IOC(2,t,n,sizeof(s))
+#define _IOW(t,n,s) _IOC(1,t,n,sizeof(s))
+#define _IOWR(t,n,s) _IOC(3,t,n,sizeof(s))
+#define _IOC_SIZE(n) (((n)>>16)&0x3fff)
+#define u64_to_user_ptr(x) ((void __user *)(uintptr_t)(x))
+/* misc */
+#define MISC_DYNAMIC_MINOR 255
+struct miscdevice { int minor; const char *name; const struct file_operations *fops; umode_t mode; const struct attribute_group **groups; struct device *this_device; };
+int misc_register(struct miscdevice*); void misc_deregister(struct miscdevice*);
+/* debugfs */
+struct dentry; struct dentry *debugfs_create_dir(const char*, struct dentry*);
+struct dentry *debugfs_create_file(const char*, umode_t, struct dentry*, void*, const struct file_operations*);
+void debugfs_remove_recursive(struct dentry*); void debugfs_remove(struct dentry*);
+void debugfs_create_u32(const char*, umode_t, struct dentry*, u32*); void debugfs_create_bool(const char*, umode_t, struct dentry*, bool*);
+void debugfs_create_x32(const char*, umode_t, struct dentry*, u32*); void debugfs_create_u64(const char*, umode_t, struct dentry*, u64*);
+/* seq_file */
+struct seq_file { void *private; };
+int seq_printf(struct seq_file*, const char*, ...) __attribute__((format(printf,2,3))); int seq_puts(struct seq_file*, const char*); int seq_putc(struct seq_file*, char);
+int single_open(struct file*, int (*)(struct seq_file*, void*), void*); int single_release(struct inode*, struct file*);
+int single_open_size(struct file*, int (*)(struct seq_file*, void*), void*, size_t);
+ssize_t seq_read(struct file*, char __user*, size_t, loff_t*); loff_t seq_lseek(struct file*, loff_t, int);
+void seq_hex_dump(struct seq_file*, const char*, int, int, int, const void*, size_t, bool);
+#define DUMP_PREFIX_NONE 0
+#define DUMP_PREFIX_OFFSET 1
+#define DEFINE_SHOW_ATTRIBUTE(__name) \
+static int __name ## _open(struct inode *inode, struct file *file) { return single_open(file, __name ## _show, (void*)inode); } \
+static const struct file_operations __name ## _fops = { .owner = THIS_MODULE, .open = __name ## _open, .read = seq_read, .llseek = seq_lseek, .release = single_release, }
+/* leds */
+enum led_brightness { LED_OFF = 0, LED_ON = 1, LED_HALF = 127, LED_FULL = 255 };
+struct led_trigger; struct led_classdev { const char *name; unsigned int brightness; unsigned int max_brightness; int flags; void (*brightness_set)(struct led_classdev*, enum led_brightness); int (*brightness_set_blocking)(struct led_classdev*, enum led_brightness); enum led_brightness (*brightness_get)(struct led_classdev*); const char *default_trigger; struct device *dev; };
+#define LED_CORE_SUSPENDRESUME BIT(16)
+#define LED_RETAIN_AT_SHUTDOWN BIT(17)
+#define LED_BRIGHT_HW_CHANGED BIT(21)
+#define LED_HW_PLUGGABLE BIT(19)
+int devm_led_classdev_register(struct device*, struct led_classdev*); int led_classdev_register(struct device*, struct led_classdev*); void led_classdev_unregister(struct led_classdev*);
+void led_classdev_notify_brightness_hw_changed(struct led_classdev*, unsigned int);
+struct mc_subled { unsigned int color_index; unsigned int brightness; unsigned int intensity; unsigned int channel; };
+struct led_classdev_mc { struct led_classdev led_cdev; unsigned int num_colors; struct mc_subled *subled_info; };
+#define LED_COLOR_ID_RED 1
+#define LED_COLOR_ID_GREEN 2
+#define LED_COLOR_ID_BLUE 3
+#define LED_COLOR_ID_RGB 9
+#define LED_COLOR_ID_MULTI 8
+static inline struct led_classdev_mc *lcdev_to_mccdev(struct led_classdev *l) { return container_of(l, struct led_classdev_mc, led_cdev); }
+int devm_led_classdev_multicolor_register(struct device*, struct led_classdev_mc*);
+int led_classdev_multicolor_register(struct device*, struct led_classdev_mc*); void led_classdev_multicolor_unregister(struct led_classdev_mc*);
+int led_mc_calc_color_components(struct led_classdev_mc*, enum led_brightness);
+/* input */
+#define EV_KEY 1
+#define EV_SYN 0
+#define EV_MSC 4
+#define MSC_SCAN 4
+#define KEY_CNT 0x300
+#define KEY_MAX 0x2ff
+#define BITS_TO_LONGS(n) (((n)+63)/64)
+#define BIT_WORD(n) ((n)/64)
+#define DECLARE_BITMAP(n,b) unsigned long n[BITS_TO_LONGS(b)]
+struct input_id { u16 bustype, vendor, product, version; };
+struct input_dev { const char *name; const char *phys; struct input_id id; unsigned long evbit[1]; unsigned long keybit[BITS_TO_LONGS(KEY_CNT)]; struct device dev; };
+struct input_handle; struct input_handler;
+struct input_device_id { unsigned long flags; unsigned long evbit[1]; unsigned long keybit[BITS_TO_LONGS(KEY_CNT)]; unsigned long relbit[1]; unsigned long absbit[1]; u16 bustype; u16 vendor; u16 product; unsigned long driver_info; };
+#define INPUT_DEVICE_ID_MATCH_EVBIT 0x10
+#define INPUT_DEVICE_ID_MATCH_BUS 1
+#define INPUT_DEVICE_ID_MATCH_KEYBIT 0x20
+#define INPUT_DEVICE_ID_MATCH_RELBIT 0x40
+#define INPUT_DEVICE_ID_MATCH_ABSBIT 0x80
+#define EV_REL 2
+#define EV_ABS 3
+#define REL_X 0
+#define ABS_X 0
+#define BTN_TOUCH 0x14a
+#define BUS_I8042 0x11
+struct input_handle { void *private; const char *name; struct input_dev *dev; struct input_handler *handler; };
+struct input_handler { void (*event)(struct input_handle*, unsigned int, unsigned int, int); bool (*filter)(struct input_handle*, unsigned int, unsigned int, int); bool (*match)(struct input_handler*, struct input_dev*); int (*connect)(struct input_handler*, struct input_dev*, const struct input_device_id*); void (*disconnect)(struct input_handle*); const char *name; const struct input_device_id *id_table; };
+int input_register_handler(struct input_handler*); void input_unregister_handler(struct input_handler*);
+int input_register_handle(struct input_handle*); void input_unregister_handle(struct input_handle*);
+int input_open_device(struct input_handle*); void input_close_device(struct input_handle*);
+#define KEY_ESC 1
+#define KEY_1 2
+#define KEY_BACKSPACE 14
+#define KEY_TAB 15
+#define KEY_Q 16
+#define KEY_A 30
+#define KEY_Z 44
+#define KEY_SPACE 57
+#define KEY_F1 59
+#define KEY_F10 68
+#define KEY_NUMLOCK 69
+#define KEY_KP7 71
+#define KEY_KPDOT 83
+#define KEY_F11 87
+#define KEY_F12 88
+#define KEY_KPENTER 96
+#define KEY_RIGHTCTRL 97
+#define KEY_KPSLASH 98
+#define KEY_SYSRQ 99
+#define KEY_RIGHTALT 100
+#define KEY_HOME 102
+#define KEY_UP 103
+#define KEY_PAGEUP 104
+#define KEY_LEFT 105
+#define KEY_RIGHT 106
+#define KEY_END 107
+#define KEY_DOWN 108
+#define KEY_PAGEDOWN 109
+#define KEY_INSERT 110
+#define KEY_DELETE 111
+#define KEY_LEFTMETA 125
+#define KEY_RIGHTMETA 126
+#define KEY_COMPOSE 127
+/* hwmon */
+enum hwmon_sensor_types { hwmon_chip, hwmon_temp, hwmon_in, hwmon_curr, hwmon_power, hwmon_energy, hwmon_humidity, hwmon_fan, hwmon_pwm };
+struct hwmon_channel_info { enum hwmon_sensor_types type; const u32 *config; };
+#define HWMON_T_INPUT BIT(1)
+#define HWMON_F_INPUT BIT(1)
+#define HWMON_CHANNEL_INFO(t, ...) (&(const struct hwmon_channel_info){ .type = hwmon_##t, .config = (const u32[]){ __VA_ARGS__, 0 } })
+struct hwmon_ops { umode_t (*is_visible)(const void*, enum hwmon_sensor_types, u32, int); int (*read)(struct device*, enum hwmon_sensor_types, u32, int, long*); };
+struct hwmon_chip_info { const struct hwmon_ops *ops; const struct hwmon_channel_info * const *info; };
+struct device *devm_hwmon_device_register_with_info(struct device*, const char*, void*, const struct hwmon_chip_info*, const void*);
+/* power supply / battery hook */
+struct power_supply; struct acpi_battery_hook { const char *name; int (*add_battery)(struct power_supply*, struct acpi_battery_hook*); int (*remove_battery)(struct power_supply*, struct acpi_battery_hook*); };
+void battery_hook_register(struct acpi_battery_hook*); void battery_hook_unregister(struct acpi_battery_hook*);
+int devm_battery_hook_register(struct device*, struct acpi_battery_hook*);
+enum power_supply_property { POWER_SUPPLY_PROP_STATUS, POWER_SUPPLY_PROP_CHARGE_CONTROL_END_THRESHOLD, POWER_SUPPLY_PROP_CHARGE_BEHAVIOUR };
+union power_supply_propval { int intval; const char *strval; };
+struct power_supply_ext { const char *name; const enum power_supply_property *properties; size_t num_properties; unsigned long charge_behaviours; int (*get_property)(struct power_supply*, const struct power_supply_ext*, void*, enum power_supply_property, union power_supply_propval*); int (*set_property)(struct power_supply*, const struct power_supply_ext*, void*, enum power_supply_property, const union power_supply_propval*); int (*property_is_writeable)(struct power_supply*, const struct power_supply_ext*, void*, enum power_supply_property); };
+int power_supply_register_extension(struct power_supply*, const struct power_supply_ext*, struct device*, void*);
+void power_supply_unregister_extension(struct power_supply*, const struct power_supply_ext*);
+enum power_supply_charge_behaviour { POWER_SUPPLY_CHARGE_BEHAVIOUR_AUTO = 0, POWER_SUPPLY_CHARGE_BEHAVIOUR_INHIBIT_CHARGE, POWER_SUPPLY_CHARGE_BEHAVIOUR_FORCE_DISCHARGE };
+ssize_t power_supply_charge_behaviour_show(struct device*, unsigned int, enum power_supply_charge_behaviour, char*);
+int power_supply_charge_behaviour_parse(unsigned int, const char*);
+/* power supply notifier */
+struct notifier_block { int (*notifier_call)(struct notifier_block*, unsigned long, void*); };
+#define NOTIFY_OK 1
+#define NOTIFY_DONE 0
+int register_acpi_notifier(struct notifier_block*); int unregister_acpi_notifier(struct notifier_block*);
+int power_supply_reg_notifier(struct notifier_block*); void power_supply_unreg_notifier(struct notifier_block*);
+/* pm notifier */
+int register_pm_notifier(struct notifier_block*); int unregister_pm_notifier(struct notifier_block*);
+/* misc helpers */
+struct dmi_system_id; 
+#define KSYM_NAME_LEN 128
+static inline unsigned long array_index_nospec(unsigned long i, unsigned long n) { return i; }
+int fls(unsigned int); int fls64(u64); int ilog2(u64);
+bool capable(int); 
+#define CAP_SYS_ADMIN 21
+void *memchr_inv(const void *, int, size_t);
+ssize_t memory_read_from_buffer(void *to, size_t count, loff_t *ppos, const void *from, size_t available);
+size_t str_has_prefix(const char *, const char *);
+#define KEY_MINUS 12
+#define KEY_EQUAL 13
+#define KEY_LEFTBRACE 26
+#define KEY_RIGHTBRACE 27
+#define KEY_ENTER 28
+#define KEY_LEFTCTRL 29
+#define KEY_SEMICOLON 39
+#define KEY_APOSTROPHE 40
+#define KEY_GRAVE 41
+#define KEY_LEFTSHIFT 42
+#define KEY_BACKSLASH 43
+#define KEY_COMMA 51
+#define KEY_DOT 52
+#define KEY_SLASH 53
+#define KEY_RIGHTSHIFT 54
+#define KEY_KPASTERISK 55
+#define KEY_LEFTALT 56
+#define KEY_CAPSLOCK 58
+#define KEY_SCROLLLOCK 70
+#define KEY_KP8 72
+#define KEY_KP9 73
+#define KEY_KPMINUS 74
+#define KEY_KP4 75
+#define KEY_KP5 76
+#define KEY_KP6 77
+#define KEY_KPPLUS 78
+#define KEY_KP1 79
+#define KEY_KP2 80
+#define KEY_KP3 81
+#define KEY_KP0 82
+#define KEY_102ND 86
+#define KEY_PAUSE 119
+#define KEY_2 3
+#define KEY_3 4
+#define KEY_4 5
+#define KEY_5 6
+#define KEY_6 7
+#define KEY_7 8
+#define KEY_8 9
+#define KEY_9 10
+#define KEY_0 11
+#define KEY_W 17
+#define KEY_E 18
+#define KEY_R 19
+#define KEY_T 20
+#define KEY_Y 21
+#define KEY_U 22
+#define KEY_I 23
+#define KEY_O 24
+#define KEY_P 25
+#define KEY_S 31
+#define KEY_D 32
+#define KEY_F 33
+#define KEY_G 34
+#define KEY_H 35
+#define KEY_J 36
+#define KEY_K 37
+#define KEY_L 38
+#define KEY_X 45
+#define KEY_C 46
+#define KEY_V 47
+#define KEY_B 48
+#define KEY_N 49
+#define KEY_M 50
+#define KEY_F2 60
+#define KEY_F3 61
+#define KEY_F4 62
+#define KEY_F5 63
+#define KEY_F6 64
+#define KEY_F7 65
+#define KEY_F8 66
+#define KEY_F9 67
+#define BIT_MASK(n) (1UL << ((n) % 64))
+struct dev_ext_attribute { struct device_attribute attr; void *var; };
+long compat_ptr_ioctl(struct file *, unsigned int, unsigned long);
+char *bin2hex(char *dst, const void *src, size_t count);
+
+/* net/genetlink.h */
+struct sk_buff;
+struct nlattr;
+struct netlink_ext_ack;
+struct net;
+extern struct net init_net;
+enum { NLA_UNSPEC, NLA_U8, NLA_U16, NLA_U32, NLA_U64, NLA_STRING, NLA_FLAG, NLA_MSECS, NLA_NESTED, NLA_BINARY };
+struct nla_policy { u8 type; u8 validation_type; u16 len; int min, max; };
+#define NLA_POLICY_MAX(t, m) { .type = t, .max = m }
+#define NLA_POLICY_RANGE(t, a, b) { .type = t, .min = a, .max = b }
+#define NLA_POLICY_EXACT_LEN(l) { .type = NLA_BINARY, .len = l }
+struct genl_info { u32 snd_seq; u32 snd_portid; struct nlattr **attrs; struct netlink_ext_ack *extack; };
+struct genl_small_ops { int (*doit)(struct sk_buff *, struct genl_info *); u8 cmd; u8 validate; u8 flags; };
+struct genl_multicast_group { char name[16]; u8 flags; };
+struct module;
+struct genl_family { const char *name; unsigned int hdrsize; u8 version; unsigned int maxattr; const struct nla_policy *policy;
+  struct module *module; const struct genl_small_ops *small_ops; u8 n_small_ops; u8 resv_start_op;
+  const struct genl_multicast_group *mcgrps; u8 n_mcgrps; char name_buf[16]; bool netnsok; bool parallel_ops; };
+#define GENL_ADMIN_PERM 1
+#define GENL_UNS_ADMIN_PERM 0x10
+#define NLMSG_DEFAULT_SIZE 3000
+#define GENL_SET_ERR_MSG(info, msg) do { (void)(info); } while (0)
+#define NL_SET_ERR_MSG_ATTR(e, a, m) do { (void)(e); (void)(a); } while (0)
+int genl_register_family(struct genl_family *);
+int genl_unregister_family(const struct genl_family *);
+struct sk_buff *genlmsg_new(size_t, gfp_t);
+void *genlmsg_put(struct sk_buff *, u32, u32, const struct genl_family *, int, u8);
+void *genlmsg_put_reply(struct sk_buff *, struct genl_info *, const struct genl_family *, int, u8);
+void genlmsg_end(struct sk_buff *, void *);
+int genlmsg_reply(struct sk_buff *, struct genl_info *);
+int genlmsg_multicast(const struct genl_family *, struct sk_buff *, u32, unsigned int, gfp_t);
+int genl_has_listeners(const struct genl_family *, struct net *, unsigned int);
+void nlmsg_free(struct sk_buff *);
+int nla_put_u8(struct sk_buff *, int, u8);
+int nla_put(struct sk_buff *, int, int, const void *);
+u8 nla_get_u8(const struct nlattr *);
+void *nla_data(const struct nlattr *);
+int nla_len(const struct nlattr *);
+
+/* linux/ctype.h */
+int isalnum(int);
+
+#endif /* _NEKRO_HOST_KERNEL_H */
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Runner for the host KUnit stand-in, see kunit/test.h
+ */
+
+#include "kernel.h"
+#include "kunit/test.h"
+
+int printf(const char *fmt, ...);
+int vprintf(const char *fmt, va_list ap);
+void *calloc(size_t n, size_t size);
+void free(void *p);
+
+static struct kunit_suite **kunit_host_suites[KUNIT_HOST_MAX_SUITES];
+static int kunit_host_n;
+
+void kunit_host_register(struct kunit_suite **suites)
+{
+    if (kunit_host_n < KUNIT_HOST_MAX_SUITES)
+        kunit_host_suites[kunit_host_n++] = suites;
+}
+
+void *kunit_kzalloc(struct kunit *test, size_t size, gfp_t gfp)
+{
+    void *p;
+
+    if (test->n_allocs == ARRAY_SIZE(test->allocs))
+        return NULL;
+    p = calloc(1, size);
+    if (p)
+        test->allocs[test->n_allocs++] = p;
+    return p;
+}
+
+void kunit_fail(struct kunit *test, const char *file, int line, const char *fmt, ...)
+{
+    va_list ap;
+
+    test->failures++;
+    printf("    # %s: %s:%d: ", test->name, file, line);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+}
+
+static bool kunit_host_run_case(struct kunit_suite *suite, struct kunit_case *c)
+{
+    struct kunit test = { .name = c->name };
+
+    if (suite->init && suite->init(&test)) {
+        printf("    # %s: init failed\n", c->name);
+        return false;
+    }
+    c->run_case(&test);
+    if (suite->exit)
+        suite->exit(&test);
+    for (int i = 0; i < test.n_allocs; i++)
+        free(test.allocs[i]);
+    return !test.failures;
+}
+
+/* Runs every registered suite, returns the number of failed cases */
+int kunit_host_run(void)
+{
+    int failed = 0;
+
+    for (int i = 0; i < kunit_host_n; i++) {
+        for (struct kunit_suite **s = kunit_host_suites[i]; *s; s++) {
+            int n = 0, suite_failed = 0;
+
+            printf("# Subtest: %s\n", (*s)->name);
+            for (struct kunit_case *c = (*s)->test_cases; c->run_case; c++) {
+                bool ok = kunit_host_run_case(*s, c);
+
+                printf("    %s %d %s\n", ok ? "ok" : "not ok", ++n, c->name);
+                suite_failed += !ok;
+            }
+            printf("%s %s\n", suite_failed ? "not ok" : "ok", (*s)->name);
+            failed += suite_failed;
+        }
+    }
+    return failed;
+}
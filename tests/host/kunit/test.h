@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Host stand-in for <kunit/test.h>
+ *
+ * Just enough of the KUnit API for src/nekro_sense_test.c and the host-only
+ * suites in nekro_host.c: suites with init/exit, EXPECT/ASSERT on integers
+ * and strings, and test-managed allocations. An ASSERT failure returns from
+ * the function it is in, so only use it in the case body itself.
+ * tests/host/kunit.c runs the suites and prints KTAP-like results.
+ */
+#ifndef _NEKRO_HOST_KUNIT_H
+#define _NEKRO_HOST_KUNIT_H
+
+struct kunit {
+    const char *name;
+    void *priv;
+    int failures;
+    void *allocs[16];
+    int n_allocs;
+};
+
+#define KUNIT_HOST_MAX_SUITES	8
+
+struct kunit_case {
+    void (*run_case)(struct kunit *test);
+    const char *name;
+};
+
+struct kunit_suite {
+    const char *name;
+    int (*init)(struct kunit *test);
+    void (*exit)(struct kunit *test);
+    struct kunit_case *test_cases;
+};
+
+#define KUNIT_CASE(f) { .run_case = f, .name = #f }
+
+void *kunit_kzalloc(struct kunit *test, size_t size, gfp_t gfp);
+void kunit_fail(struct kunit *test, const char *file, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+#define __KUNIT_CHECK(test, ok, expr, fmt, ...)					\
+    ({									\
+        bool __ok = (ok);						\
+        if (!__ok)							\
+            kunit_fail(test, __FILE__, __LINE__, "%s" fmt, expr, ##__VA_ARGS__);	\
+        __ok;								\
+    })
+
+#define __KUNIT_BINARY(test, l, op, r, fmt, ...)				\
+    ({									\
+        long long __l = (long long)(l), __r = (long long)(r);		\
+        __KUNIT_CHECK(test, __l op __r, #l " " #op " " #r,		\
+                      " (%lld vs %lld) " fmt, __l, __r, ##__VA_ARGS__);	\
+    })
+
+#define KUNIT_EXPECT_EQ(test, l, r) __KUNIT_BINARY(test, l, ==, r, "")
+#define KUNIT_EXPECT_NE(test, l, r) __KUNIT_BINARY(test, l, !=, r, "")
+#define KUNIT_EXPECT_EQ_MSG(test, l, r, fmt, ...) __KUNIT_BINARY(test, l, ==, r, fmt, ##__VA_ARGS__)
+#define KUNIT_EXPECT_TRUE(test, c) __KUNIT_CHECK(test, !!(c), #c, "")
+#define KUNIT_EXPECT_FALSE(test, c) __KUNIT_CHECK(test, !(c), "!" #c, "")
+#define KUNIT_EXPECT_STREQ(test, l, r)						\
+    __KUNIT_CHECK(test, !strcmp(l, r), #l " == " #r, " (\"%s\" vs \"%s\")", l, r)
+
+#define KUNIT_ASSERT_EQ(test, l, r)						\
+    do {								\
+        if (!KUNIT_EXPECT_EQ(test, l, r))				\
+            return;							\
+    } while (0)
+
+void kunit_host_register(struct kunit_suite **suites);
+int kunit_host_run(void);
+
+#define __kunit_host_id(a, b) a##b
+#define __kunit_host_suites(id, ...)						\
+    static struct kunit_suite *__kunit_host_id(__kunit_suites_, id)[] = { __VA_ARGS__, NULL }; \
+    __attribute__((constructor)) static void __kunit_host_id(__kunit_register_, id)(void) \
+    {									\
+        kunit_host_register(__kunit_host_id(__kunit_suites_, id));	\
+    }
+#define kunit_test_suites(...) __kunit_host_suites(__COUNTER__, __VA_ARGS__)
+
+#endif /* _NEKRO_HOST_KUNIT_H */
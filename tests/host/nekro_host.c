@@ -0,0 +1,607 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Host build of nekro_sense
+ *
+ * Compiles the driver as an ordinary program so its parsers, encoders and
+ * firmware call sequences can be tested and timed without a PHN16-72.
+ * "make host-test" runs the tests, "make host-bench" the microbenchmarks too.
+ * "--parity" prints the firmware calls of one change per user action, for
+ * analysis/wmi_parity.py.
+ *
+ * The driver is included whole, with the KUnit suites from
+ * src/nekro_sense_test.c, and runs on top of kernel.h/kernel.c. Only the code
+ * the tests reach is kept by the compiler. wmi_evaluate_method() is a
+ * scripted fake, below; acer_wmi_evaluate() is unchanged in front of it, so
+ * wmi_stats, wmi_inject and the firmware model (wmi_emulate) work as they do
+ * in the module.
+ */
+
+#define NEKRO_SENSE_KUNIT_TEST
+#include "../../src/nekro_sense.c"
+
+int printf(const char *fmt, ...);
+
+extern bool nekro_host_verbose;
+
+/*
+ * Scripted firmware
+ *
+ * Every call is logged with its GUID, method id and input bytes. The answer
+ * is the next reply queued with fake_script(), or AE_OK with a zero result
+ * word once the script has run out: zero is success for every setter the
+ * driver uses.
+ */
+#define FAKE_MAX_CALLS	64
+#define FAKE_MAX_INPUT	32
+
+struct fake_call {
+    enum acer_wmi_guid guid;
+    u32 method_id;
+    u8 in[FAKE_MAX_INPUT];
+    u32 in_len;
+};
+
+struct fake_reply {
+    acpi_status status;
+    u64 result;
+};
+
+static struct {
+    struct fake_call calls[FAKE_MAX_CALLS];
+    unsigned int n_calls;		/* keeps counting past FAKE_MAX_CALLS */
+    struct fake_reply script[FAKE_MAX_CALLS];
+    unsigned int n_script, pos;
+} fake;
+
+static void fake_reset(void)
+{
+    memset(&fake, 0, sizeof(fake));
+}
+
+static void fake_script(acpi_status status, u64 result)
+{
+    if (fake.n_script < FAKE_MAX_CALLS)
+        fake.script[fake.n_script++] = (struct fake_reply){ status, result };
+}
+
+/* The first eight input bytes of call i, little endian */
+static u64 fake_word(unsigned int i)
+{
+    u64 word = 0;
+
+    memcpy(&word, fake.calls[i].in, min_t(u32, fake.calls[i].in_len, sizeof(word)));
+    return le64_to_cpu(word);
+}
+
+acpi_status wmi_evaluate_method(const char *guid_string, u8 instance, u32 method_id,
+                                const struct acpi_buffer *in, struct acpi_buffer *out)
+{
+    struct fake_reply reply = { AE_OK, 0 };
+    enum acer_wmi_guid guid = ACER_WMI_GUID_MAX;
+    union acpi_object *obj;
+
+    for (int i = 0; i < ACER_WMI_GUID_MAX; i++) {
+        if (!strcmp(guid_string, acer_wmi_guids[i]))
+            guid = i;
+    }
+
+    if (fake.n_calls < FAKE_MAX_CALLS) {
+        struct fake_call *c = &fake.calls[fake.n_calls];
+
+        c->guid = guid;
+        c->method_id = method_id;
+        c->in_len = in ? min_t(u32, in->length, FAKE_MAX_INPUT) : 0;
+        if (c->in_len)
+            memcpy(c->in, in->pointer, c->in_len);
+    }
+    fake.n_calls++;
+
+    if (fake.pos < fake.n_script)
+        reply = fake.script[fake.pos++];
+    if (ACPI_FAILURE(reply.status) || !out)
+        return reply.status;
+
+    obj = kzalloc(sizeof(*obj) + sizeof(u64), GFP_KERNEL);
+    if (!obj)
+        return AE_NO_MEMORY;
+    obj->buffer.type = ACPI_TYPE_BUFFER;
+    obj->buffer.length = sizeof(u64);
+    obj->buffer.pointer = (u8 *)(obj + 1);
+    put_unaligned_le64(reply.result, obj->buffer.pointer);
+    out->length = sizeof(*obj) + sizeof(u64);
+    out->pointer = obj;
+    return AE_OK;
+}
+
+/* Host tests, against the scripted firmware */
+
+static int nekro_host_init(struct kunit *test)
+{
+    fake_reset();
+    WRITE_ONCE(acer_wmi_emulate, false);
+    WRITE_ONCE(kb_state_valid, false);
+    WRITE_ONCE(logo_state_valid, false);
+    cycle_gaming_thermal_profile = true;
+    acer_predator_v4_max_perf = ACER_PREDATOR_V4_THERMAL_PROFILE_TURBO;
+    last_non_turbo_profile = ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED;
+    return 0;
+}
+
+#define EXPECT_CALL(test, i, g, m, word)					\
+    do {									\
+        KUNIT_EXPECT_EQ_MSG(test, fake.calls[i].guid, g, "call %d", i);	\
+        KUNIT_EXPECT_EQ_MSG(test, fake.calls[i].method_id, m, "call %d", i);	\
+        KUNIT_EXPECT_EQ_MSG(test, fake_word(i), word, "call %d", i);	\
+    } while (0)
+
+static void nekro_fan_val_calc_test(struct kunit *test)
+{
+    /* The level byte is the percentage itself, the low byte the fan index */
+    for (int p = 0; p <= 100; p++) {
+        KUNIT_EXPECT_EQ_MSG(test, fan_val_calc(p, 1), (u64)p << 8 | 1, "%d%%", p);
+        KUNIT_EXPECT_EQ_MSG(test, fan_val_calc(p, 4), (u64)p << 8 | 4, "%d%%", p);
+    }
+}
+
+struct nekro_fan_sequence {
+    int cpu, gpu;
+    unsigned int n;
+    struct {
+        u32 method_id;
+        u64 word;
+    } calls[3];
+};
+
+static void nekro_fan_sequence_test(struct kunit *test)
+{
+    static const struct nekro_fan_sequence cases[] = {
+        { 100, 100, 1, { { 14, 0x820009 } } },
+        { 0, 0, 1, { { 14, 0x410009 } } },
+        { 0, 60, 3, { { 14, 0x10001 }, { 14, 0xC00008 }, { 16, 0x3C04 } } },
+        { 45, 0, 3, { { 14, 0x400008 }, { 14, 0x30001 }, { 16, 0x2D01 } } },
+        { 30, 70, 3, { { 14, 0xC30009 }, { 16, 0x1E01 }, { 16, 0x4604 } } },
+    };
+
+    for (int i = 0; i < ARRAY_SIZE(cases); i++) {
+        const struct nekro_fan_sequence *c = &cases[i];
+
+        fake_reset();
+        KUNIT_EXPECT_EQ(test, acer_set_fan_speed(c->cpu, c->gpu), AE_OK);
+        KUNIT_EXPECT_EQ_MSG(test, fake.n_calls, c->n, "%d,%d", c->cpu, c->gpu);
+        for (int j = 0; j < c->n && j < fake.n_calls; j++)
+            EXPECT_CALL(test, j, ACER_WMI_GUID4, c->calls[j].method_id, c->calls[j].word);
+    }
+
+    /* A failure stops the sequence and keeps the old speeds */
+    fake_reset();
+    fake_script(AE_OK, 0);
+    fake_script(AE_ERROR, 0);
+    KUNIT_EXPECT_EQ(test, acer_set_fan_speed(55, 65), AE_ERROR);
+    KUNIT_EXPECT_EQ(test, fake.n_calls, 2);
+    KUNIT_EXPECT_EQ(test, cpu_fan_speed, 30);
+    KUNIT_EXPECT_EQ(test, gpu_fan_speed, 70);
+}
+
+static void nekro_per_zone_packing_test(struct kunit *test)
+{
+    static const u8 zone_ids[4] = { 0x1, 0x2, 0x4, 0x8 };
+    struct per_zone_color zones = {
+        .zone1 = 0x112233, .zone2 = 0x445566, .zone3 = 0x778899, .zone4 = 0xAABBCC,
+        .brightness = 55,
+    };
+
+    KUNIT_EXPECT_EQ(test, __set_per_zone_color(&zones, true), AE_OK);
+    KUNIT_ASSERT_EQ(test, fake.n_calls, 6);
+
+    /* Static effect at the zone brightness, keyboard selected */
+    EXPECT_CALL(test, 0, ACER_WMI_GUID4, ACER_WMID_SET_GAMING_KB_BACKLIGHT_METHODID,
+                55ULL << 16);
+    KUNIT_EXPECT_EQ(test, fake.calls[0].in_len, 16);
+    KUNIT_EXPECT_EQ(test, fake.calls[0].in[8], 3);
+    KUNIT_EXPECT_EQ(test, fake.calls[0].in[9], 1);
+
+    /* The 16-byte SetGamingLED(1) wake */
+    EXPECT_CALL(test, 1, ACER_WMI_GUID4, ACER_WMID_SET_GAMING_LED_METHODID, 1);
+    KUNIT_EXPECT_EQ(test, fake.calls[1].in_len, 16);
+
+    /* Zone id, R, G, B, padded to a u64 */
+    for (int i = 0; i < 4; i++) {
+        u64 rgb = ((u64 *)&zones)[i];
+
+        EXPECT_CALL(test, 2 + i, ACER_WMI_GUID4, ACER_WMID_SET_GAMING_RGB_KB_METHODID,
+                    zone_ids[i] | (rgb >> 16 & 0xFF) << 8 | (rgb >> 8 & 0xFF) << 16 |
+                    (rgb & 0xFF) << 24);
+        KUNIT_EXPECT_EQ(test, fake.calls[2 + i].in_len, 8);
+    }
+
+    /* Same brightness, one zone changed: a single zone write */
+    fake_reset();
+    zones.zone3 = 0x010203;
+    KUNIT_EXPECT_EQ(test, update_per_zone_color(&zones), AE_OK);
+    KUNIT_EXPECT_EQ(test, fake.n_calls, 1);
+    EXPECT_CALL(test, 0, ACER_WMI_GUID4, ACER_WMID_SET_GAMING_RGB_KB_METHODID,
+                0x03020104ULL);
+
+    /* A failed zone write leaves the shadow state invalid */
+    fake_reset();
+    for (int i = 0; i < 4; i++)
+        fake_script(AE_OK, 0);
+    fake_script(AE_ERROR, 0);
+    KUNIT_EXPECT_EQ(test, __set_per_zone_color(&zones, true), AE_ERROR);
+    KUNIT_EXPECT_EQ(test, fake.n_calls, 5);
+    KUNIT_EXPECT_FALSE(test, kb_state_valid);
+}
+
+struct nekro_cycle_case {
+    u8 current_tp;
+    bool on_ac;
+    u8 next;
+};
+
+static void nekro_profile_cycle_test(struct kunit *test)
+{
+    enum {
+        Q = ACER_PREDATOR_V4_THERMAL_PROFILE_QUIET,
+        B = ACER_PREDATOR_V4_THERMAL_PROFILE_BALANCED,
+        P = ACER_PREDATOR_V4_THERMAL_PROFILE_PERFORMANCE,
+        T = ACER_PREDATOR_V4_THERMAL_PROFILE_TURBO,
+        E = ACER_PREDATOR_V4_THERMAL_PROFILE_ECO,
+    };
+    static const struct nekro_cycle_case cases[] = {
+        { E, true, Q }, { Q, true, B }, { B, true, P }, { P, true, T }, { T, true, Q },
+        { B, false, E }, { E, false, B },
+    };
+
+    for (int i = 0; i < ARRAY_SIZE(cases); i++) {
+        const struct nekro_cycle_case *c = &cases[i];
+        /* Quiet and eco also put the fans back on auto */
+        bool fan = c->next == Q || c->next == E;
+
+        fake_reset();
+        fake_script(AE_OK, (u64)c->current_tp << 8);
+        fake_script(AE_OK, c->on_ac);
+        KUNIT_EXPECT_EQ(test, acer_thermal_profile_change(), 0);
+        KUNIT_EXPECT_EQ_MSG(test, fake.n_calls, 3 + fan, "case %d", i);
+        EXPECT_CALL(test, 0, ACER_WMI_GUID4, ACER_WMID_GET_GAMING_MISC_SETTING_METHODID,
+                    ACER_WMID_MISC_SETTING_PLATFORM_PROFILE);
+        EXPECT_CALL(test, 1, ACER_WMI_GUID4, ACER_WMID_GET_GAMING_SYS_INFO_METHODID,
+                    ACER_WMID_CMD_GET_PREDATOR_V4_BAT_STATUS);
+        EXPECT_CALL(test, 2, ACER_WMI_GUID4, ACER_WMID_SET_GAMING_MISC_SETTING_METHODID,
+                    ACER_WMID_MISC_SETTING_PLATFORM_PROFILE | c->next << 8);
+        if (fan)
+            EXPECT_CALL(test, 3, ACER_WMI_GUID4,
+                        ACER_WMID_SET_GAMING_FAN_BEHAVIOR_METHODID, 0x410009);
+        KUNIT_EXPECT_EQ(test, thermal_profile_cached, c->next);
+    }
+
+    /* A refused profile is reported and nothing is remembered */
+    fake_reset();
+    fake_script(AE_OK, (u64)B << 8);
+    fake_script(AE_OK, 1);
+    fake_script(AE_OK, 1);
+    KUNIT_EXPECT_EQ(test, acer_thermal_profile_change(), -EIO);
+    KUNIT_EXPECT_EQ(test, fake.n_calls, 3);
+    KUNIT_EXPECT_EQ(test, thermal_profile_cached, -1);
+}
+
+static struct kunit_case nekro_host_cases[] = {
+    KUNIT_CASE(nekro_fan_val_calc_test),
+    KUNIT_CASE(nekro_fan_sequence_test),
+    KUNIT_CASE(nekro_per_zone_packing_test),
+    KUNIT_CASE(nekro_profile_cycle_test),
+    {}
+};
+
+static struct kunit_suite nekro_host_suite = {
+    .name = "nekro_sense_host",
+    .init = nekro_host_init,
+    .test_cases = nekro_host_cases,
+};
+
+kunit_test_suites(&nekro_host_suite);
+
+/*
+ * Microbenchmarks
+ *
+ * Each operation runs n times against the scripted firmware and then against
+ * the firmware model. calls/op is what the firmware would see; ns/op is the
+ * driver side only, since neither stand-in sleeps.
+ */
+struct nekro_bench {
+    const char *name;
+    void (*op)(unsigned int i);
+    unsigned int weight;	/* divides n, for the slower operations */
+};
+
+static volatile u64 nekro_bench_sink;
+
+static void bench_fan_speed_parse(unsigned int i)
+{
+    u8 cpu, gpu;
+
+    nekro_bench_sink += fan_speed_parse(i & 1 ? "37,82" : "100,0", &cpu, &gpu) + cpu + gpu;
+}
+
+static void bench_lighting_parse_zones(unsigned int i)
+{
+    struct kb_state kb;
+    char s[40];
+
+    strscpy(s, "ff0000,00ff00,0000ff,123456,40", sizeof(s));
+    nekro_bench_sink += lighting_parse_zones(s, &kb) + kb.zones.zone4;
+}
+
+static void bench_lighting_parse_effect(unsigned int i)
+{
+    struct kb_state kb;
+
+    nekro_bench_sink += lighting_parse_effect("3,4,100,2,10,20,30", &kb) + kb.speed;
+}
+
+static void bench_fan_val_calc(unsigned int i)
+{
+    nekro_bench_sink += fan_val_calc(i % 101, i & 1 ? 1 : 4);
+}
+
+static void bench_profile_next(unsigned int i)
+{
+    nekro_bench_sink += acer_thermal_profile_next(i % 7, i & 8);
+}
+
+static void bench_set_fan_speed(unsigned int i)
+{
+    nekro_bench_sink += acer_set_fan_speed(30 + (i & 1), 70);
+}
+
+static void bench_set_kb_status(unsigned int i)
+{
+    nekro_bench_sink += set_kb_status(3, 4, 80, 2, 0, 0, 0);
+}
+
+static void bench_set_per_zone_color(unsigned int i)
+{
+    struct per_zone_color zones = { 0x112233, 0x445566, 0x778899, 0xAABBCC, 55 };
+
+    nekro_bench_sink += __set_per_zone_color(&zones, true);
+}
+
+static void bench_update_one_zone(unsigned int i)
+{
+    struct per_zone_color zones = { 0x112233, 0x445566, i & 1 ? 0x010203 : 0x778899,
+                                    0xAABBCC, 55 };
+
+    nekro_bench_sink += update_per_zone_color(&zones);
+}
+
+static void bench_set_logo_color(unsigned int i)
+{
+    nekro_bench_sink += set_logo_status(1, 60, 0, i & 1 ? 0x40 : 0x10, 0x20, 0x30);
+}
+
+static void bench_set_logo_same(unsigned int i)
+{
+    nekro_bench_sink += set_logo_status(1, 60, 0, 0x10, 0x20, 0x30);
+}
+
+static void bench_profile_change(unsigned int i)
+{
+    nekro_bench_sink += acer_thermal_profile_change();
+}
+
+static const struct nekro_bench nekro_benches[] = {
+    { "fan_speed_parse", bench_fan_speed_parse, 1 },
+    { "lighting_parse_zones", bench_lighting_parse_zones, 1 },
+    { "lighting_parse_effect", bench_lighting_parse_effect, 1 },
+    { "fan_val_calc", bench_fan_val_calc, 1 },
+    { "acer_thermal_profile_next", bench_profile_next, 1 },
+    { "acer_set_fan_speed mixed", bench_set_fan_speed, 10 },
+    { "set_kb_status", bench_set_kb_status, 10 },
+    { "__set_per_zone_color wake", bench_set_per_zone_color, 10 },
+    { "update_per_zone_color 1 zone", bench_update_one_zone, 10 },
+    { "set_logo_status color", bench_set_logo_color, 10 },
+    { "set_logo_status unchanged", bench_set_logo_same, 10 },
+    { "acer_thermal_profile_change", bench_profile_change, 10 },
+};
+
+/* ns per operation and firmware calls per operation */
+static void nekro_bench_run(const struct nekro_bench *b, unsigned int n, bool model,
+                            u64 *ns, u64 *calls)
+{
+    ktime_t start;
+
+    fake_reset();
+    acer_wmi_emu_reset();
+    WRITE_ONCE(acer_wmi_emulate, model);
+    WRITE_ONCE(kb_state_valid, false);
+    WRITE_ONCE(logo_state_valid, false);
+
+    /* Warm the shadow state up, so every iteration is the steady state */
+    b->op(0);
+    b->op(1);
+
+    memset(acer_wmi_stats, 0, sizeof(acer_wmi_stats));
+    start = ktime_get();
+    for (unsigned int i = 0; i < n; i++)
+        b->op(i);
+    *ns = ktime_get() - start;
+
+    *calls = 0;
+    for (int g = 0; g < ACER_WMI_GUID_MAX; g++)
+        for (int m = 0; m <= ACER_WMI_STATS_METHODS; m++)
+            *calls += acer_wmi_stats[g][m].calls;
+
+    WRITE_ONCE(acer_wmi_emulate, false);
+}
+
+static void nekro_bench_all(unsigned int n)
+{
+    printf("\n%-30s %9s %10s %9s %10s\n", "", "scripted", "", "model", "");
+    printf("%-30s %9s %10s %9s %10s\n", "operation", "calls/op", "ns/op", "calls/op", "ns/op");
+    for (int i = 0; i < ARRAY_SIZE(nekro_benches); i++) {
+        const struct nekro_bench *b = &nekro_benches[i];
+        unsigned int iters = n / b->weight ?: 1;
+        u64 ns, model_ns, calls, model_calls;
+
+        nekro_bench_run(b, iters, false, &ns, &calls);
+        nekro_bench_run(b, iters, true, &model_ns, &model_calls);
+        printf("%-30s %9.2f %10.1f %9.2f %10.1f\n", b->name, (double)calls / iters,
+               (double)ns / iters, (double)model_calls / iters, (double)model_ns / iters);
+    }
+}
+
+/*
+ * One change per user action against the model, made the way
+ * "wmi_parity.py --capture" makes it on the laptop: read the attribute, reset
+ * the counters, write the value read with one field changed, then print the
+ * counters in the wmi_stats format under a "# action NAME" line.
+ */
+static void parity_flip_hex(char *c)
+{
+    int v = *c <= '9' ? *c - '0' : (*c | 0x20) - 'a' + 10;
+
+    v ^= 1;
+    *c = v < 10 ? '0' + v : 'a' + v - 10;
+}
+
+/* Colors are RRGGBB first, the change flips the lowest bit of blue */
+static void parity_color_change(char *buf)
+{
+    parity_flip_hex(&buf[5]);
+}
+
+static void parity_fan_change(char *buf)
+{
+    int cpu = 0;
+
+    for (char *p = buf; *p >= '0' && *p <= '9'; p++)
+        cpu = cpu * 10 + *p - '0';
+    memmove(buf + 2, strchr(buf, ','), strlen(strchr(buf, ',')) + 1);
+    memcpy(buf, cpu == 50 ? "60" : "50", 2);
+}
+
+struct nekro_parity {
+    const char *action;
+    struct device_attribute *attr;	/* NULL for platform_profile */
+    void (*change)(char *buf);
+};
+
+static const struct nekro_parity nekro_parity_actions[] = {
+    { "profile", NULL, NULL },
+    { "fan", &fan_speed, parity_fan_change },
+    { "keyboard", &per_zoned_rgb_mode, parity_color_change },
+    { "logo", &back_logo_attr, parity_color_change },
+};
+
+static void nekro_parity_print(const char *action)
+{
+    printf("# action %s\n", action);
+    printf("# guid method calls failures total_us avg_us max_us\n");
+    for (int g = 0; g < ACER_WMI_GUID_MAX; g++) {
+        for (int i = 0; i <= ACER_WMI_STATS_METHODS; i++) {
+            struct acer_wmi_call_stats *st = &acer_wmi_stats[g][i];
+
+            if (!st->calls)
+                continue;
+            printf("%d ", g + 3);
+            if (i < ACER_WMI_STATS_METHODS)
+                printf("0x%02x ", i);
+            else
+                printf("other ");
+            printf("%llu %llu %llu %llu %llu\n", st->calls, st->failures, st->total_us,
+                   st->total_us / st->calls, st->max_us);
+        }
+    }
+}
+
+/* Returns the number of actions that could not be made */
+static int nekro_parity_all(unsigned long choices)
+{
+    enum platform_profile_option cur = PLATFORM_PROFILE_CUSTOM, next;
+    char buf[PAGE_SIZE];
+    int failed = 0;
+
+    acer_wmi_emu_reset();
+    WRITE_ONCE(acer_wmi_emulate, true);
+    acer_caches_reload();
+
+    for (int i = 0; i < ARRAY_SIZE(nekro_parity_actions); i++) {
+        const struct nekro_parity *a = &nekro_parity_actions[i];
+        int ret;
+
+        if (a->attr) {
+            ret = a->attr->show(NULL, a->attr, buf);
+            if (ret > 0) {
+                a->change(buf);
+                memset(acer_wmi_stats, 0, sizeof(acer_wmi_stats));
+                ret = a->attr->store(NULL, a->attr, buf, strlen(buf));
+            }
+            ret = ret < 0 ? ret : 0;
+        } else {
+            /* The first other choice, as the capture picks it */
+            ret = acer_predator_v4_platform_profile_get(NULL, &cur);
+            for (next = 0; next < PLATFORM_PROFILE_CUSTOM; next++) {
+                if ((choices & BIT(next)) && next != cur)
+                    break;
+            }
+            if (!ret && next == PLATFORM_PROFILE_CUSTOM)
+                ret = -EOPNOTSUPP;
+            if (!ret) {
+                memset(acer_wmi_stats, 0, sizeof(acer_wmi_stats));
+                ret = acer_predator_v4_platform_profile_set(NULL, next);
+            }
+        }
+        if (ret) {
+            printf("# action %s failed: %d\n", a->action, ret);
+            failed++;
+            continue;
+        }
+        nekro_parity_print(a->action);
+    }
+
+    WRITE_ONCE(acer_wmi_emulate, false);
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long long n = 1000000;
+    unsigned long choices = 0;
+    bool bench = false, parity = false;
+    int failed;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-v")) {
+            nekro_host_verbose = true;
+        } else if (!strcmp(argv[i], "--bench")) {
+            bench = true;
+        } else if (!strcmp(argv[i], "--parity")) {
+            parity = true;
+        } else if (!strcmp(argv[i], "-n") && i + 1 < argc && !kstrtoull(argv[i + 1], 10, &n) && n) {
+            i++;
+        } else {
+            printf("usage: %s [-v] [--bench | --parity] [-n iterations]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    /* What probe does on a PHN16-72, with the profile list from the model */
+    interface = &wmid_v2_interface;
+    find_quirks();
+    set_quirks();
+    acer_wmi_emu_reset();
+    WRITE_ONCE(acer_wmi_emulate, true);
+    if (acer_predator_v4_platform_profile_probe(NULL, &choices)) {
+        printf("profile probe failed\n");
+        return 1;
+    }
+    WRITE_ONCE(acer_wmi_emulate, false);
+
+    /* Only the counters, for wmi_parity.py to parse */
+    if (parity)
+        return !!nekro_parity_all(choices);
+
+    failed = kunit_host_run();
+    if (bench)
+        nekro_bench_all(n);
+    return !!failed;
+}
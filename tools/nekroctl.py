@@ -6,6 +6,9 @@ Features:
 - Keyboard RGB (four-zone): per-zone static colors, or effect modes
 - Power mode: get/list/set ACPI platform_profile
 - Fan speed: set auto or CPU/GPU percentages
+- Scenes: define and apply named profile/fan/lighting/battery bundles
+- State: print every driver-managed value from one read
+- Selftest: TAP report of sysfs read/write round trips against latency budgets
 
 Requirements:
 - Nekro-Sense kernel module loaded
@@ -20,8 +23,11 @@ Paths referenced (if present):
 from __future__ import annotations
 
 import argparse
+import errno
+import math
 import os
 import sys
+import time
 from typing import Optional, Tuple, List
 
 
@@ -32,6 +38,12 @@ KB_FOUR_MODE = os.path.join(SYSFS_BASE, "four_zoned_kb/four_zone_mode")
 # Back logo/lightbar
 LOGO_COLOR = os.path.join(SYSFS_BASE, "back_logo/color")
 
+# Named scenes (profile + fans + lighting + battery limiter)
+SCENES = os.path.join(SYSFS_BASE, "scenes")
+
+# Snapshot of all driver state in one read
+STATE = os.path.join(SYSFS_BASE, "state")
+
 SENSE_PRED = os.path.join(SYSFS_BASE, "predator_sense")
 SENSE_NITRO = os.path.join(SYSFS_BASE, "nitro_sense")
 
@@ -360,6 +372,395 @@ def cmd_battery_off(_: argparse.Namespace) -> None:
     print("OK: battery limit OFF (100%)")
 
 
+def read_state() -> dict:
+    """Read the driver state snapshot into a {key: value} dict."""
+    _require_path(STATE, "driver state snapshot")
+    state = {}
+    for line in _read_text(STATE).splitlines():
+        key, sep, value = line.partition("=")
+        if sep:
+            state[key] = value
+    return state
+
+
+def cmd_state(_: argparse.Namespace) -> None:
+    for key, value in read_state().items():
+        print(f"{key}={value}")
+
+
+def cmd_scene_list(_: argparse.Namespace) -> None:
+    p = os.path.join(SCENES, "list")
+    _require_path(p, "scenes")
+    out = _read_text(p)
+    if out:
+        print(out)
+
+
+def cmd_scene_define(args: argparse.Namespace) -> None:
+    p = os.path.join(SCENES, "define")
+    _require_path(p, "scenes")
+    _write_text(p, " ".join([args.name] + args.items) + "\n")
+    print(f"OK: scene {args.name} defined")
+
+
+def cmd_scene_apply(args: argparse.Namespace) -> None:
+    p = os.path.join(SCENES, "apply")
+    _require_path(p, "scenes")
+    _write_text(p, f"{args.name}\n")
+    print(f"OK: scene {args.name} applied")
+
+
+def cmd_scene_remove(args: argparse.Namespace) -> None:
+    p = os.path.join(SCENES, "remove")
+    _require_path(p, "scenes")
+    _write_text(p, f"{args.name}\n")
+    print(f"OK: scene {args.name} removed")
+
+
+# Attributes whose read value is accepted back as a write, with inputs the
+# driver must reject. Writing back the value just read changes nothing.
+# Keys are "group/name" where the basename alone is ambiguous.
+SELFTEST_WRITES = {
+    "fan_speed": ["101,0", "0,101", "50", "a,b"],
+    "battery_limiter": ["2", "x"],
+    "battery_calibration": ["2", "x"],
+    "battery_cache_ms": ["3600001", "x"],
+    "usb_charging": ["5", "x"],
+    "lcd_override": ["5", "x"],
+    "backlight_timeout": ["5", "x"],
+    "boot_animation_sound": ["5", "x"],
+    "four_zone_mode": ["8,0,50,0,0,0,0", "0,0,101,0,0,0,0", "3,1,50,0,0,0,0", "0,0,50"],
+    "per_zone_mode": [
+        "ff0000,00ff00,0000ff",
+        "gg0000,00ff00,0000ff,ffffff,50",
+        "ff0000,00ff00,0000ff,ffffff,101",
+    ],
+    "back_logo/color": ["ff000,50", "ff0000,101", "ff0000,50,2"],
+    "platform_profile": ["bogus"],
+    "battery_telemetry/interval_s": ["4", "86401", "x"],
+    "lighting/batch": ["kb=ff0000", "logo=ff0000,101", "bogus=1"],
+    "thermal_lighting/mode": ["bogus"],
+    "thermal_lighting/sensor": ["bogus"],
+    "thermal_lighting/gradient": ["95:ff0000,40:0000ff", "0:000000,121:ffffff", "40:0000ff"],
+    "thermal_lighting/interval_ms": ["249", "x"],
+    "reactive_lighting/enable": ["2", "x"],
+    "reactive_lighting/color": ["gg0000", "x"],
+    "reactive_lighting/fade_ms": ["99", "5001", "x"],
+    "reactive_lighting/source": ["bogus"],
+    "lighting_idle/timeout_ac": ["86401", "x"],
+    "lighting_idle/timeout_battery": ["86401", "x"],
+}
+
+# Binary attributes: every one takes back what it reads, must reject a short
+# write and a set reserved byte (always the last), plus {offset: value} out
+# of range for a field.
+SELFTEST_RAW_WRITES = {
+    "fan_speed_raw": {0: 101, 1: 101},
+    "per_zone_raw": {12: 101},
+    "four_zone_raw": {0: 8, 2: 101, 3: 3},
+    "color_raw": {3: 101, 4: 2},
+}
+
+# Attribute groups walked by selftest; hwmon and platform_profile are added separately
+SELFTEST_GROUPS = (
+    "predator_sense", "nitro_sense", "battery_telemetry", "four_zoned_kb", "back_logo",
+    "lighting", "thermal_lighting", "reactive_lighting", "lighting_idle", "scenes",
+)
+
+# Temporary scene defined, applied and removed by selftest
+SELFTEST_SCENE = "nekroctl-test"
+
+
+def _selftest_rejects(label: str) -> Optional[List[str]]:
+    name = label.rpartition("/")[2]
+    return SELFTEST_WRITES.get(label, SELFTEST_WRITES.get(name))
+
+
+def _is_binary(label: str) -> bool:
+    return label.endswith("_raw") or label == "battery_telemetry/history"
+
+
+def _read_bytes(path: str) -> bytes:
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def _hwmon_dir() -> Optional[str]:
+    base = "/sys/class/hwmon"
+    if not _path_exists(base):
+        return None
+    for d in sorted(os.listdir(base)):
+        p = os.path.join(base, d)
+        try:
+            if _read_text(os.path.join(p, "name")) == "acer":
+                return p
+        except OSError:
+            continue
+    return None
+
+
+def _selftest_attrs() -> List[Tuple[str, str]]:
+    """Return (label, path) for every readable driver attribute."""
+    attrs = []
+    for sub in SELFTEST_GROUPS:
+        d = os.path.join(SYSFS_BASE, sub)
+        if not _path_exists(d):
+            continue
+        for name in sorted(os.listdir(d)):
+            p = os.path.join(d, name)
+            if os.path.isfile(p) and os.stat(p).st_mode & 0o444:
+                attrs.append((f"{sub}/{name}", p))
+    if _path_exists(STATE):
+        attrs.append(("state", STATE))
+    hwmon = _hwmon_dir()
+    if hwmon:
+        for name in sorted(os.listdir(hwmon)):
+            if name.startswith(("temp", "fan")) and name.endswith(("_input", "_label")):
+                attrs.append((f"hwmon/{name}", os.path.join(hwmon, name)))
+    for p in (PLATFORM_PROFILE, PLATFORM_PROFILE_CHOICES):
+        if _path_exists(p):
+            attrs.append((os.path.basename(p), p))
+    return attrs
+
+
+def _sysfs_write(path: str, data) -> None:
+    """Write str or bytes in a single write(), as sysfs stores expect."""
+    fd = os.open(path, os.O_WRONLY)
+    try:
+        os.write(fd, data.encode() if isinstance(data, str) else data)
+    finally:
+        os.close(fd)
+
+
+def _timed(fn, n: int) -> List[float]:
+    """Run fn n times and return the durations in ms."""
+    times = []
+    for _ in range(n):
+        start = time.perf_counter_ns()
+        fn()
+        times.append((time.perf_counter_ns() - start) / 1e6)
+    return times
+
+
+def _p99(times: List[float]) -> float:
+    times = sorted(times)
+    return times[max(0, math.ceil(len(times) * 0.99) - 1)]
+
+
+def _write_errno(path: str, data) -> int:
+    try:
+        _sysfs_write(path, data)
+    except OSError as e:
+        return e.errno
+    return 0
+
+
+def _selftest_text(check, label: str, path: str, args: argparse.Namespace) -> None:
+    name = label.rpartition("/")[2]
+    try:
+        before = _read_text(path)
+    except OSError as e:
+        check(False, f"write {label}: read failed: {e.strerror}")
+        return
+    if before == "-1":
+        check(True, f"write {label}", "# SKIP firmware value unknown")
+        return
+    if not before:
+        check(True, f"write {label}", "# SKIP nothing to write back")
+        return
+    if name == "platform_profile" and before == "custom":
+        check(True, f"write {label}", "# SKIP custom profile")
+        return
+
+    try:
+        times = _timed(lambda: _sysfs_write(path, before + "\n"), args.writes)
+        after = _read_text(path)
+    except OSError as e:
+        check(False, f"write {label} {before!r}: {e.strerror}")
+        return
+    p99 = _p99(times)
+    check(after == before, f"round trip {label} wrote={before!r} read={after!r}")
+    check(p99 <= args.write_budget_ms,
+          f"write {label} p99={p99:.2f}ms budget={args.write_budget_ms}ms")
+
+    for bad in _selftest_rejects(label):
+        err = _write_errno(path, bad + "\n")
+        check(err == errno.EINVAL, f"reject {label} {bad!r} errno={err}")
+    try:
+        after = _read_text(path)
+    except OSError as e:
+        after = e.strerror
+    check(after == before, f"unchanged {label} after rejects read={after!r}")
+
+
+def _selftest_raw(check, label: str, path: str, args: argparse.Namespace) -> None:
+    name = label.rpartition("/")[2]
+    try:
+        before = _read_bytes(path)
+    except OSError as e:
+        check(False, f"write {label}: read failed: {e.strerror}")
+        return
+
+    try:
+        times = _timed(lambda: _sysfs_write(path, before), args.writes)
+        after = _read_bytes(path)
+    except OSError as e:
+        check(False, f"write {label} {before.hex()}: {e.strerror}")
+        return
+    p99 = _p99(times)
+    check(after == before, f"round trip {label} wrote={before.hex()} read={after.hex()}")
+    check(p99 <= args.write_budget_ms,
+          f"write {label} p99={p99:.2f}ms budget={args.write_budget_ms}ms")
+
+    # Short write, reserved byte set, then each field out of range
+    bad = [before[:-1], before[:-1] + b"\x01"]
+    for off, val in SELFTEST_RAW_WRITES[name].items():
+        bad.append(before[:off] + bytes([val]) + before[off + 1:])
+    for data in bad:
+        err = _write_errno(path, data)
+        check(err == errno.EINVAL, f"reject {label} {data.hex()} errno={err}")
+    try:
+        after = _read_bytes(path)
+    except OSError as e:
+        check(False, f"unchanged {label} after rejects: {e.strerror}")
+        return
+    check(after == before, f"unchanged {label} after rejects read={after.hex()}")
+
+
+def _selftest_scene(check) -> None:
+    """Define, apply and remove a scene of the current lighting."""
+    define, apply, remove, listing = (os.path.join(SCENES, n)
+                                      for n in ("define", "apply", "remove", "list"))
+    label = f"scene {SELFTEST_SCENE}"
+    batch = os.path.join(SYSFS_BASE, "lighting/batch")
+    try:
+        items = _read_text(batch).split() if _path_exists(batch) else []
+        active = _read_text(apply)
+    except OSError as e:
+        check(False, f"{label}: read failed: {e.strerror}")
+        return
+    if not items:
+        check(True, label, "# SKIP no lighting to capture")
+        return
+
+    line = " ".join([SELFTEST_SCENE] + items)
+    err = _write_errno(define, line + "\n")
+    if err == errno.ENOSPC:
+        check(True, label, "# SKIP scene table full")
+        return
+    if err:
+        check(False, f"define {label} errno={err}")
+        return
+    listed = _read_text(listing).splitlines()
+    check(line in listed, f"define {label} listed={line in listed}")
+
+    # Applying replaces the active scene, and removing ours would then leave none
+    if active:
+        check(True, f"apply {label}", f"# SKIP scene {active} is active")
+    else:
+        err = _write_errno(apply, SELFTEST_SCENE + "\n")
+        applied = _read_text(apply)
+        check(not err and applied == SELFTEST_SCENE,
+              f"apply {label} errno={err} read={applied!r}")
+
+    for bad in (f"{SELFTEST_SCENE} bogus=1", f"{SELFTEST_SCENE} fan=101,0", "bad/name fan=0,0",
+                SELFTEST_SCENE):
+        err = _write_errno(define, bad + "\n")
+        check(err == errno.EINVAL, f"reject define {bad!r} errno={err}")
+    listed = _read_text(listing).splitlines()
+    check(line in listed, f"unchanged {label} after rejects listed={line in listed}")
+
+    err = _write_errno(remove, SELFTEST_SCENE + "\n")
+    listed = _read_text(listing).splitlines()
+    check(not err and line not in listed, f"remove {label} errno={err}")
+    check(_read_text(apply) == active, f"active scene after remove read={_read_text(apply)!r}")
+    for path in (apply, remove):
+        err = _write_errno(path, SELFTEST_SCENE + "\n")
+        check(err == errno.ENOENT,
+              f"reject {os.path.basename(path)} of removed {label} errno={err}")
+
+
+def cmd_selftest(args: argparse.Namespace) -> None:
+    """Walk the driver ABI and print a TAP report; exit 1 on any failure."""
+    results = []  # (ok, description, directive)
+
+    def check(ok: bool, desc: str, directive: str = "") -> None:
+        results.append((ok, desc, directive))
+
+    attrs = _selftest_attrs()
+    if not attrs:
+        sys.stderr.write("No Nekro-Sense attributes found. Is the module loaded?\n")
+        sys.exit(2)
+
+    for label, path in attrs:
+        read = _read_bytes if _is_binary(label) else _read_text
+        try:
+            times = _timed(lambda: read(path), args.reads)
+        except OSError as e:
+            check(False, f"read {label}: {e.strerror}")
+            continue
+        p99 = _p99(times)
+        check(p99 <= args.read_budget_ms,
+              f"read {label} p99={p99:.2f}ms budget={args.read_budget_ms}ms")
+
+    writable = [(label, path) for label, path in attrs
+                if _selftest_rejects(label) is not None
+                or label.rpartition("/")[2] in SELFTEST_RAW_WRITES]
+    # Round trip the active keyboard mode last, so it is the one left in place.
+    # The profile goes first: quiet and eco put the fans back on auto, so the
+    # fan_speed write back must come after it.
+    state = read_state() if _path_exists(STATE) else {}
+    last = (("per_zone_mode", "per_zone_raw") if state.get("kb_per_zone") == "1"
+            else ("four_zone_mode", "four_zone_raw"))
+    writable.sort(key=lambda a: (a[1] != PLATFORM_PROFILE) + a[0].endswith(last))
+    fans = next((path for label, path in writable if label.endswith("/fan_speed")), None)
+    try:
+        fans_before = _read_text(fans) if fans else None
+    except OSError:
+        fans_before = None
+    skip = ""
+    if args.read_only:
+        skip = "# SKIP read-only"
+    elif os.geteuid() != 0:
+        skip = "# SKIP needs root"
+
+    for label, path in writable:
+        if skip:
+            check(True, f"write {label}", skip)
+        elif _is_binary(label):
+            _selftest_raw(check, label, path, args)
+        else:
+            _selftest_text(check, label, path, args)
+
+    # Nothing written later may have moved the fans off what the user had
+    if fans_before is not None and not skip:
+        try:
+            fans_after = _read_text(fans)
+        except OSError as e:
+            fans_after = e.strerror
+        check(fans_after == fans_before,
+              f"unchanged fan_speed read={fans_after!r} expected={fans_before!r}")
+        if fans_after != fans_before:
+            _write_errno(fans, fans_before + "\n")
+
+    if _path_exists(os.path.join(SCENES, "define")):
+        if skip:
+            check(True, f"scene {SELFTEST_SCENE}", skip)
+        else:
+            _selftest_scene(check)
+
+    print("TAP version 13")
+    print(f"1..{len(results)}")
+    for i, (ok, desc, directive) in enumerate(results, 1):
+        line = f"{'ok' if ok else 'not ok'} {i} {desc}"
+        print(f"{line} {directive}" if directive else line)
+    failed = sum(1 for ok, _, _ in results if not ok)
+    skipped = sum(1 for _, _, d in results if d)
+    print(f"# pass={len(results) - failed - skipped} fail={failed} skip={skipped}")
+    if failed:
+        sys.exit(1)
+
+
 def build_parser() -> argparse.ArgumentParser:
     p = argparse.ArgumentParser(
         prog="nekroctl",
@@ -523,6 +924,59 @@ def build_parser() -> argparse.ArgumentParser:
 
     bset.set_defaults(func=_battery_set_wrapper)
 
+    # scene
+    scene = sub.add_parser("scene", help="Named scenes applied in one batch")
+    scene.set_defaults(func=lambda _args, _parser=scene: _parser.print_help())
+    scene_sub = scene.add_subparsers(dest="scene_cmd")
+
+    slist = scene_sub.add_parser("list", help="Print defined scenes")
+    slist.set_defaults(func=cmd_scene_list)
+
+    sdef = scene_sub.add_parser(
+        "define",
+        help="Define or replace a scene",
+        description=(
+            "Items: profile=NAME fan=CPU,GPU kb=RRGGBB,RRGGBB,RRGGBB,RRGGBB,B "
+            "kb_mode=M,S,B,D,R,G,B logo=RRGGBB,B[,EN] battery_limiter=0|1"
+        ),
+    )
+    sdef.add_argument("name", help="Scene name (letters, digits, - and _)")
+    sdef.add_argument("items", nargs="+", help="key=value items")
+    sdef.set_defaults(func=cmd_scene_define)
+
+    sapply = scene_sub.add_parser("apply", help="Apply a scene")
+    sapply.add_argument("name")
+    sapply.set_defaults(func=cmd_scene_apply)
+
+    srm = scene_sub.add_parser("remove", help="Remove a scene")
+    srm.add_argument("name")
+    srm.set_defaults(func=cmd_scene_remove)
+
+    # state
+    state = sub.add_parser("state", help="Print all driver state from one snapshot read")
+    state.set_defaults(func=cmd_state)
+
+    # selftest
+    st = sub.add_parser(
+        "selftest",
+        help="Check every driver attribute and print a TAP report",
+        description=(
+            "Read every driver attribute, write back what was read and check that "
+            "invalid input is rejected. Each attribute's p99 latency is checked "
+            "against a budget. Exits 1 if any check fails."
+        ),
+    )
+    st.add_argument("--reads", type=int, default=20,
+                    help="Reads per attribute (default 20). Below 100, the p99 is the slowest one")
+    st.add_argument("--writes", type=int, default=5,
+                    help="Writes per attribute (default 5). Below 100, the p99 is the slowest one")
+    st.add_argument("--read-budget-ms", type=float, default=20.0,
+                    help="p99 read latency budget in ms (default 20)")
+    st.add_argument("--write-budget-ms", type=float, default=100.0,
+                    help="p99 write latency budget in ms (default 100)")
+    st.add_argument("--read-only", action="store_true", help="Skip the write checks")
+    st.set_defaults(func=cmd_selftest)
+
     return p
 
 